@@ -17,9 +17,11 @@
 #include "model/rategamma.h"
 #include "gsl/mygsl.h"
 #include "utils/gzstream.h"
+#include "utils/linereader.h"
 #include "utils/timeutil.h" //for getRealTime()
 #include "utils/progress.h" //for progress_display
 #include "alignmentsummary.h"
+#include "alignmentcache.h"
 
 #include <Eigen/LU>
 #ifdef USE_BOOST
@@ -62,6 +64,13 @@ char genetic_code23[] = "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSS
 char genetic_code24[] = "KNKNTTTTSSKSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSSWCWCLFLF"; // Pterobranchia mitochondrial
 char genetic_code25[] = "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSSGCWCLFLF"; // Candidate Division SR1 and Gracilibacteria
 
+/** genetic code tables indexed by the NCBI translation table number, NULL if not available */
+char *genetic_code_tables[] = {NULL, genetic_code1, genetic_code2, genetic_code3, genetic_code4,
+    genetic_code5, genetic_code6, NULL, NULL, genetic_code9, genetic_code10, genetic_code11,
+    genetic_code12, genetic_code13, genetic_code14, genetic_code15, genetic_code16, NULL, NULL, NULL, NULL,
+    genetic_code21, genetic_code22, genetic_code23, genetic_code24, genetic_code25};
+const int NUM_GENETIC_CODE_TABLES = sizeof(genetic_code_tables)/sizeof(genetic_code_tables[0]);
+
 Alignment::Alignment()
         : vector<Pattern>()
 {
@@ -532,8 +541,36 @@ Alignment::Alignment(char *filename, char *sequence_type, InputType &intype, str
     cout << "Reading alignment file " << filename << " ... ";
     intype = detectInputFile(filename);
 
+    // the compressed alignment of the cache FILE.iqa is only used if it was built from the same file
+    AlignmentCache *cache = NULL;
+    string cache_key;
+    bool cached = false;
+    if (Params::getInstance().aln_cache && intype != IN_COUNTS) {
+        cache = new AlignmentCache(string(filename) + ".iqa", StrVector(1, filename));
+        cache_key = string("alignment:") + (sequence_type ? sequence_type : "") +
+            (Params::getInstance().phylip_sequential_format ? ":sequential" : "");
+    }
+
     try {
-        if (intype == IN_NEXUS) {
+        const char *cache_data;
+        size_t cache_len;
+        if (cache && cache->getEntry(cache_key, cache_data, cache_len)) {
+            cout << "Alignment cache " << cache->getFileName() << " found" << endl;
+            try {
+                BinaryReader cache_in(cache_data, cache_len);
+                readBinary(cache_in);
+                cached = true;
+            } catch (string &str) {
+                outWarning(str + ", reading the alignment file instead");
+                seq_names.clear();
+                clear();
+                pattern_index.clear();
+                site_pattern.clear();
+            }
+        }
+        if (cached) {
+            // nothing to parse
+        } else if (intype == IN_NEXUS) {
             cout << "Nexus format detected" << endl;
             readNexus(filename);
         } else if (intype == IN_FASTA) {
@@ -564,6 +601,15 @@ Alignment::Alignment(char *filename, char *sequence_type, InputType &intype, str
     } catch (string str) {
         outError(str);
     }
+    if (cache) {
+        if (!cached && seq_type != SEQ_POMO) {
+            ostringstream cache_out;
+            writeBinary(cache_out);
+            cache->putEntry(cache_key, cache_out.str());
+            cache->save();
+        }
+        delete cache;
+    }
     if (verbose_mode >= VB_MED) {
         cout << "Time to read input file was " << (getRealTime() - readStart) << " sec." << endl;
     }
@@ -1105,18 +1151,23 @@ bool Alignment::addPatternLazy(Pattern &pat, int site, int freq, bool& gaps_only
             cout << "Site " << site << " contains only gaps or ambiguous characters" << endl;
         }
     }
-    PatternIntMap::iterator pat_it = pattern_index.find(pat);
-    if (pat_it == pattern_index.end()) { // not found
+    size_t hash = hashPattern()(pat);
+    int index = -1;
+    for (auto range = pattern_index.equal_range(hash); range.first != range.second; range.first++)
+        if (at(range.first->second) == pat) {
+            index = range.first->second;
+            break;
+        }
+    if (index < 0) { // not found
         pat.frequency = freq;
         //We don't do computeConst(pat); here, that's why
         //there's a "Lazy" in this member function's name!
         //We do that in addPattern...
         push_back(pat);
-        pattern_index[back()] = size()-1;
+        pattern_index.insert({hash, (int)size()-1});
         site_pattern[site] = size()-1;
         return true;
     } else {
-        int index = pat_it->second;
         at(index).frequency += freq;
         site_pattern[site] = index;
         return false;
@@ -1131,6 +1182,13 @@ bool Alignment::addPattern(Pattern &pat, int site, int freq) {
     return gaps_only;
 }
 
+int Alignment::findPattern(const vector<StateType> &pat) const {
+    for (auto range = pattern_index.equal_range(hashPattern()(pat)); range.first != range.second; range.first++)
+        if (at(range.first->second) == pat)
+            return range.first->second;
+    return -1;
+}
+
 void Alignment::updatePatterns(size_t oldPatternCount) {
     size_t patternCount = size();
     #ifdef _OPENMP
@@ -1722,6 +1780,31 @@ string Alignment::getSeqTypeStr(SeqType sequence_type) {
     }
 }
 
+/** number of sites converted into states at a time by Alignment::buildPattern */
+const int BUILD_PATTERN_TILE_SITES = 64;
+
+/** stop codon, ambiguous codon or invalid character found by Alignment::buildPattern */
+struct SiteStateEvent {
+    enum EventType {STOP_CODON, AMBIGUOUS_CODON, INVALID_CHAR};
+    EventType type;
+    int site, seq;
+    bool operator<(const SiteStateEvent &other) const {
+        return (site < other.site) || (site == other.site && seq < other.seq);
+    }
+};
+
+/** distinct patterns of a block of consecutive sites, built by Alignment::buildPattern */
+struct SitePatternBlock {
+    /** distinct patterns in order of first occurrence, with their frequencies in the block */
+    vector<Pattern> patterns;
+    /** hash of every pattern */
+    vector<size_t> hashes;
+    /** index in patterns of every site of the block */
+    IntVector site_ptn;
+    /** stop codons, ambiguous codons and invalid characters in site order */
+    vector<SiteStateEvent> events;
+};
+
 int Alignment::buildPattern(StrVector &sequences, char *sequence_type, int nseq, int nsite) {
     int seq_id;
     ostringstream err_str;
@@ -1838,7 +1921,7 @@ int Alignment::buildPattern(StrVector &sequences, char *sequence_type, int nseq,
     //initStateSpace(seq_type);
     
     // now convert to patterns
-    int site, seq, num_gaps_only = 0;
+    int num_gaps_only = 0;
 
     char char_to_state[NUM_CHAR];
     char AA_to_state[NUM_CHAR];
@@ -1849,53 +1932,124 @@ int Alignment::buildPattern(StrVector &sequences, char *sequence_type, int nseq,
     } else
         buildStateMap(char_to_state, seq_type);
 
-    Pattern pat;
-    pat.resize(nseq);
     int step = ((seq_type == SEQ_CODON || nt2aa) ? 3 : 1);
     if (nsite % step != 0)
     	outError("Number of sites is not multiple of 3");
-    site_pattern.resize(nsite/step, -1);
+    int num_sites = nsite/step;
+    site_pattern.resize(num_sites, -1);
     clear();
     pattern_index.clear();
     int num_error = 0;
-    
+
+    // the sites are compressed into distinct patterns block by block in parallel;
+    // merging the blocks in site order gives the same patterns in the same order
+    // as adding the sites one by one
+    int num_threads = 1;
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif
+    int block_sites = (num_sites + 4*num_threads - 1) / (4*num_threads);
+    block_sites = ((block_sites + BUILD_PATTERN_TILE_SITES - 1) / BUILD_PATTERN_TILE_SITES) * BUILD_PATTERN_TILE_SITES;
+    block_sites = max(block_sites, BUILD_PATTERN_TILE_SITES);
+    int num_blocks = (num_sites + block_sites - 1) / block_sites;
+    vector<SitePatternBlock> blocks(num_blocks);
+
     progress_display progress(nsite, "Constructing alignment", "examined", "site");
-    for (site = 0; site < nsite; site+=step) {
-        for (seq = 0; seq < nseq; seq++) {
-            //char state = convertState(sequences[seq][site], seq_type);
-            char state = char_to_state[(int)(sequences[seq][site])];
-            if (seq_type == SEQ_CODON || nt2aa) {
-            	// special treatment for codon
-            	char state2 = char_to_state[(int)(sequences[seq][site+1])];
-            	char state3 = char_to_state[(int)(sequences[seq][site+2])];
-            	if (state < 4 && state2 < 4 && state3 < 4) {
-//            		state = non_stop_codon[state*16 + state2*4 + state3];
-            		state = state*16 + state2*4 + state3;
-            		if (genetic_code[(int)state] == '*') {
-                        err_str << "Sequence " << seq_names[seq] << " has stop codon " <<
-                        		sequences[seq][site] << sequences[seq][site+1] << sequences[seq][site+2] <<
-                        		" at site " << site+1 << endl;
-                        num_error++;
-                        state = STATE_UNKNOWN;
-            		} else if (nt2aa) {
-                        state = AA_to_state[(int)genetic_code[(int)state]];
-                    } else {
-                        state = non_stop_codon[(int)state];
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int b = 0; b < num_blocks; b++) {
+        SitePatternBlock &block = blocks[b];
+        int first_site = b*block_sites;
+        int last_site = min(first_site + block_sites, num_sites);
+        PatternIntMap block_index;
+        // states of a tile of sites, one column after another
+        vector<char> tile((size_t)BUILD_PATTERN_TILE_SITES*nseq);
+        Pattern pat;
+        pat.resize(nseq);
+        block.site_ptn.resize(last_site - first_site);
+        for (int tile_start = first_site; tile_start < last_site; tile_start += BUILD_PATTERN_TILE_SITES) {
+            int tile_end = min(tile_start + BUILD_PATTERN_TILE_SITES, last_site);
+            // convert the characters of each sequence into the columns of the tile
+            for (int seq = 0; seq < nseq; seq++) {
+                const char *chars = sequences[seq].data();
+                for (int site = tile_start; site < tile_end; site++) {
+                    int col = site*step;
+                    char state = char_to_state[(int)(chars[col])];
+                    if (step == 3) {
+                        // special treatment for codon
+                        char state2 = char_to_state[(int)(chars[col+1])];
+                        char state3 = char_to_state[(int)(chars[col+2])];
+                        if (state < 4 && state2 < 4 && state3 < 4) {
+                            state = state*16 + state2*4 + state3;
+                            if (genetic_code[(int)state] == '*') {
+                                block.events.push_back({SiteStateEvent::STOP_CODON, site, seq});
+                                state = STATE_UNKNOWN;
+                            } else if (nt2aa) {
+                                state = AA_to_state[(int)genetic_code[(int)state]];
+                            } else {
+                                state = non_stop_codon[(int)state];
+                            }
+                        } else if (state == STATE_INVALID || state2 == STATE_INVALID || state3 == STATE_INVALID) {
+                            state = STATE_INVALID;
+                        } else {
+                            if (state != STATE_UNKNOWN || state2 != STATE_UNKNOWN || state3 != STATE_UNKNOWN)
+                                block.events.push_back({SiteStateEvent::AMBIGUOUS_CODON, site, seq});
+                            state = STATE_UNKNOWN;
+                        }
                     }
-            	} else if (state == STATE_INVALID || state2 == STATE_INVALID || state3 == STATE_INVALID) {
-            		state = STATE_INVALID;
-            	} else {
-            		if (state != STATE_UNKNOWN || state2 != STATE_UNKNOWN || state3 != STATE_UNKNOWN) {
-            			ostringstream warn_str;
-                        warn_str << "Sequence " << seq_names[seq] << " has ambiguous character " <<
-                        		sequences[seq][site] << sequences[seq][site+1] << sequences[seq][site+2] <<
-                        		" at site " << site+1;
-                        outWarning(warn_str.str());
-            		}
-            		state = STATE_UNKNOWN;
-            	}
+                    if (state == STATE_INVALID)
+                        block.events.push_back({SiteStateEvent::INVALID_CHAR, site, seq});
+                    tile[(size_t)(site-tile_start)*nseq + seq] = state;
+                }
             }
-            if (state == STATE_INVALID) {
+            // find the distinct patterns of the block
+            for (int site = tile_start; site < tile_end; site++) {
+                const char *column = &tile[(size_t)(site-tile_start)*nseq];
+                for (int seq = 0; seq < nseq; seq++)
+                    pat[seq] = column[seq];
+                size_t hash = hashPattern()(pat);
+                int index = -1;
+                for (auto range = block_index.equal_range(hash); range.first != range.second; range.first++)
+                    if (block.patterns[range.first->second] == pat) {
+                        index = range.first->second;
+                        break;
+                    }
+                if (index < 0) {
+                    index = block.patterns.size();
+                    pat.frequency = 1;
+                    block.patterns.push_back(pat);
+                    block.hashes.push_back(hash);
+                    block_index.insert({hash, index});
+                } else {
+                    block.patterns[index].frequency++;
+                }
+                block.site_ptn[site-first_site] = index;
+            }
+            progress += (tile_end - tile_start)*step;
+        }
+        // events were collected sequence by sequence within a tile
+        sort(block.events.begin(), block.events.end());
+    }
+    progress.done();
+
+    // report stop codons, ambiguous codons and invalid characters in site order
+    for (auto &block : blocks)
+        for (auto &event : block.events) {
+            int site = event.site*step;
+            int seq = event.seq;
+            if (event.type == SiteStateEvent::STOP_CODON) {
+                err_str << "Sequence " << seq_names[seq] << " has stop codon " <<
+                        sequences[seq][site] << sequences[seq][site+1] << sequences[seq][site+2] <<
+                        " at site " << site+1 << endl;
+                num_error++;
+            } else if (event.type == SiteStateEvent::AMBIGUOUS_CODON) {
+                ostringstream warn_str;
+                warn_str << "Sequence " << seq_names[seq] << " has ambiguous character " <<
+                        sequences[seq][site] << sequences[seq][site+1] << sequences[seq][site+2] <<
+                        " at site " << site+1;
+                outWarning(warn_str.str());
+            } else {
                 if (num_error < 100) {
                     err_str << "Sequence " << seq_names[seq] << " has invalid character " << sequences[seq][site];
                     if (seq_type == SEQ_CODON)
@@ -1905,35 +2059,173 @@ int Alignment::buildPattern(StrVector &sequences, char *sequence_type, int nseq,
                     err_str << "...many more..." << endl;
                 num_error++;
             }
-            pat[seq] = state;
         }
-        if (!num_error)
-        {
-            bool gaps_only;
-            addPatternLazy(pat, site/step, 1, gaps_only);
-            num_gaps_only += gaps_only ? 1 : 0;
+    if (err_str.str() != "") {
+        throw err_str.str();
+    }
+
+    // merge the distinct patterns of the blocks in site order
+    for (int b = 0; b < num_blocks; b++) {
+        SitePatternBlock &block = blocks[b];
+        size_t num_block_ptn = block.patterns.size();
+        IntVector ptn_id(num_block_ptn);
+        vector<bool> gaps_only(num_block_ptn, true);
+        for (size_t i = 0; i < num_block_ptn; i++) {
+            Pattern &pat = block.patterns[i];
+            for (auto state : pat)
+                if (state != STATE_UNKNOWN) {
+                    gaps_only[i] = false;
+                    break;
+                }
+            int index = -1;
+            for (auto range = pattern_index.equal_range(block.hashes[i]); range.first != range.second; range.first++)
+                if (at(range.first->second) == pat) {
+                    index = range.first->second;
+                    break;
+                }
+            if (index < 0) {
+                index = size();
+                pattern_index.insert({block.hashes[i], index});
+                push_back(std::move(pat));
+            } else {
+                at(index).frequency += pat.frequency;
+            }
+            ptn_id[i] = index;
         }
-        progress += step;
+        int first_site = b*block_sites;
+        for (size_t i = 0; i < block.site_ptn.size(); i++) {
+            int ptn = block.site_ptn[i];
+            site_pattern[first_site+i] = ptn_id[ptn];
+            if (gaps_only[ptn]) {
+                num_gaps_only++;
+                if (verbose_mode >= VB_DEBUG) {
+                    cout << "Site " << first_site+i << " contains only gaps or ambiguous characters" << endl;
+                }
+            }
+        }
+        block = SitePatternBlock();
     }
-    progress.done();
     updatePatterns(0);
     if (num_gaps_only) {
         cout << "WARNING: " << num_gaps_only << " sites contain only gaps or ambiguous characters." << endl;
     }
-    if (err_str.str() != "") {
-        throw err_str.str();
-    }
     return 1;
 }
 
-void processSeq(string &sequence, string &line, int line_num) {
+void Alignment::writeBinary(ostream &out) {
+    size_t nseq = getNSeq();
+    size_t nptn = size();
+    size_t nsite = site_pattern.size();
+    int code_id = 0;
+    if (genetic_code)
+        for (code_id = NUM_GENETIC_CODE_TABLES-1; code_id > 0; code_id--)
+            if (genetic_code_tables[code_id] == genetic_code)
+                break;
+    // most data types fit into one byte per state
+    bool byte_states = true;
+    for (auto &pat : *this)
+        for (auto state : pat)
+            if (state > 255)
+                byte_states = false;
+
+    ::writeBinary<int32_t>(out, seq_type);
+    ::writeBinary<int32_t>(out, num_states);
+    ::writeBinary<uint32_t>(out, STATE_UNKNOWN);
+    ::writeBinary<int32_t>(out, code_id);
+    ::writeBinary<uint64_t>(out, nseq);
+    ::writeBinary<uint64_t>(out, nptn);
+    ::writeBinary<uint64_t>(out, nsite);
+    ::writeBinary<uint8_t>(out, byte_states);
+    for (auto &seq_name : seq_names)
+        writeBinaryString(out, seq_name);
+    for (auto &pat : *this) {
+        ::writeBinary<int32_t>(out, pat.frequency);
+        ::writeBinary<int32_t>(out, pat.flag);
+        ::writeBinary<char>(out, pat.const_char);
+        ::writeBinary<int32_t>(out, pat.num_chars);
+    }
+    vector<uint8_t> states(nseq);
+    for (auto &pat : *this) {
+        ASSERT(pat.size() == nseq);
+        if (byte_states) {
+            for (size_t seq = 0; seq < nseq; seq++)
+                states[seq] = pat[seq];
+            out.write((const char*)states.data(), nseq);
+        } else {
+            out.write((const char*)pat.data(), nseq*sizeof(StateType));
+        }
+    }
+    out.write((const char*)site_pattern.data(), nsite*sizeof(int));
+}
+
+void Alignment::readBinary(BinaryReader &in) {
+    seq_type = (SeqType)in.read<int32_t>();
+    int cached_num_states = in.read<int32_t>();
+    STATE_UNKNOWN = in.read<uint32_t>();
+    int code_id = in.read<int32_t>();
+    if (code_id != 0) {
+        if (code_id < 0 || code_id >= NUM_GENETIC_CODE_TABLES || !genetic_code_tables[code_id])
+            throw string("Alignment cache has an unknown genetic code");
+        initCodon((char*)convertIntToString(code_id).c_str());
+    }
+    // initCodon() sets the number of codons, which differs for NT2AA
+    num_states = cached_num_states;
+    size_t nseq = in.read<uint64_t>();
+    size_t nptn = in.read<uint64_t>();
+    size_t nsite = in.read<uint64_t>();
+    bool byte_states = in.read<uint8_t>();
+
+    seq_names.resize(nseq);
+    for (auto &seq_name : seq_names)
+        seq_name = in.readString();
+    clear();
+    pattern_index.clear();
+    resize(nptn);
+    for (auto &pat : *this) {
+        pat.frequency = in.read<int32_t>();
+        pat.flag = in.read<int32_t>();
+        pat.const_char = in.read<char>();
+        pat.num_chars = in.read<int32_t>();
+    }
+    size_t state_bytes = byte_states ? 1 : sizeof(StateType);
+    const char *states = in.readBlock(nptn*nseq*state_bytes);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t ptn = 0; ptn < nptn; ptn++) {
+        Pattern &pat = at(ptn);
+        pat.resize(nseq);
+        const char *ptn_states = states + ptn*nseq*state_bytes;
+        if (byte_states) {
+            for (size_t seq = 0; seq < nseq; seq++)
+                pat[seq] = (uint8_t)ptn_states[seq];
+        } else {
+            memcpy(pat.data(), ptn_states, nseq*sizeof(StateType));
+        }
+    }
+    for (size_t ptn = 0; ptn < nptn; ptn++)
+        pattern_index.insert({hashPattern()(at(ptn)), (int)ptn});
+    site_pattern.resize(nsite);
+    memcpy(site_pattern.data(), in.readBlock(nsite*sizeof(int)), nsite*sizeof(int));
+    for (auto ptn : site_pattern)
+        if (ptn < 0 || ptn >= nptn)
+            throw string("Alignment cache has an invalid site pattern");
+    countConstSite();
+}
+
+void processSeq(string &sequence, const char *line, size_t len, int line_num) {
     int exclam_found = false;
-    for (string::iterator it = line.begin(); it != line.end(); it++) {
+    const char *line_end = line + len;
+    // write the characters in place, the sequence grows by at most len characters
+    size_t seq_len = sequence.length();
+    sequence.resize(seq_len + len);
+    char *seq_chars = &sequence[0];
+    for (const char *it = line; it != line_end; it++) {
         if ((*it) <= ' ') continue;
         if (isalnum(*it) || (*it) == '-' || (*it) == '?'|| (*it) == '.' || (*it) == '*' || (*it) == '~')
-            sequence.append(1, toupper(*it));
+            seq_chars[seq_len++] = toupper(*it);
         else if ((*it) == '!') {
-            sequence.append(1, *it);
+            seq_chars[seq_len++] = *it;
             if (!exclam_found) {
                 exclam_found = true;
                 cout << "Warning: Line " + convertIntToString(line_num) + ": '!' was found in the alignment, which will be interpreted as a gap" << endl;
@@ -1941,41 +2233,40 @@ void processSeq(string &sequence, string &line, int line_num) {
         }
         else if (*it == '(' || *it == '{') {
             auto start_it = it;
-            while (*it != ')' && *it != '}' && it != line.end())
+            while (it != line_end && *it != ')' && *it != '}')
                 it++;
-            if (it == line.end())
+            if (it == line_end)
                 throw "Line " + convertIntToString(line_num) + ": No matching close-bracket ) or } found";
-            sequence.append(1, '?');
-            cout << "NOTE: Line " << line_num << ": " << line.substr(start_it-line.begin(), (it-start_it)+1) << " is treated as unknown character" << endl;
+            seq_chars[seq_len++] = '?';
+            cout << "NOTE: Line " << line_num << ": " << string(start_it, it+1) << " is treated as unknown character" << endl;
         } else {
             throw "Line " + convertIntToString(line_num) + ": Unrecognized character "  + *it;
         }
     }
+    sequence.resize(seq_len);
+}
+
+void processSeq(string &sequence, string &line, int line_num) {
+    processSeq(sequence, line.data(), line.length(), line_num);
 }
 
 void Alignment::doReadPhylip(char *filename, char *sequence_type, StrVector &sequences, int &nseq, int &nsite)
 {
     ostringstream err_str;
-    igzstream in;
+    LineReader in(filename);
     int line_num = 1;
-    // set the failbit and badbit
-    in.exceptions(ios::failbit | ios::badbit);
-    in.open(filename);
     int seq_id = 0;
-    string line;
-    // remove the failbit
-    in.exceptions(ios::badbit);
+    const char *line;
+    size_t len;
     bool tina_state = (sequence_type && (strcmp(sequence_type,"TINA") == 0 || strcmp(sequence_type,"MULTI") == 0));
     num_states = 0;
 
-    for (; !in.eof(); line_num++) {
-        safeGetline(in, line);
-        line = line.substr(0, line.find_first_of("\n\r"));
-        if (line == "") continue;
+    for (; in.getLine(line, len); line_num++) {
+        if (len == 0) continue;
 
         //cout << line << endl;
         if (nseq == 0) { // read number of sequences and sites
-            istringstream line_in(line);
+            istringstream line_in(string(line, len));
             if (!(line_in >> nseq >> nsite))
                 throw "Invalid PHYLIP format. First line must contain number of sequences and sites";
             //cout << "nseq: " << nseq << "  nsite: " << nsite << endl;
@@ -1986,17 +2277,23 @@ void Alignment::doReadPhylip(char *filename, char *sequence_type, StrVector &seq
 
             seq_names.resize(nseq, "");
             sequences.resize(nseq, "");
+            // sequences grow in interleaved blocks, avoid reallocations
+            for (auto &seq : sequences)
+                seq.reserve(nsite);
 
         } else { // read sequence contents
             if (seq_names[seq_id] == "") { // cut out the sequence name
-                string::size_type pos = line.find_first_of(" \t");
-                if (pos == string::npos) pos = 10; //  assume standard phylip
-                seq_names[seq_id] = line.substr(0, pos);
-                line.erase(0, pos);
+                size_t pos = 0;
+                while (pos < len && line[pos] != ' ' && line[pos] != '\t')
+                    pos++;
+                if (pos == len) pos = min(len, (size_t)10); //  assume standard phylip
+                seq_names[seq_id] = string(line, pos);
+                line += pos;
+                len -= pos;
             }
             int old_len = sequences[seq_id].length();
             if (tina_state) {
-                stringstream linestr(line);
+                stringstream linestr(string(line, len));
                 int state;
                 while (!linestr.eof() ) {
                     state = -1;
@@ -2005,7 +2302,7 @@ void Alignment::doReadPhylip(char *filename, char *sequence_type, StrVector &seq
                     sequences[seq_id].append(1, state);
                     if (num_states < state+1) num_states = state+1;
                 }
-            } else processSeq(sequences[seq_id], line, line_num);
+            } else processSeq(sequences[seq_id], line, len, line_num);
             if (sequences[seq_id].length() != sequences[0].length()) {
                 err_str << "Line " << line_num << ": Sequence " << seq_names[seq_id] << " has wrong sequence length " << sequences[seq_id].length() << endl;
                 throw err_str.str();
@@ -2019,10 +2316,6 @@ void Alignment::doReadPhylip(char *filename, char *sequence_type, StrVector &seq
         }
         //sequences.
     }
-    in.clear();
-    // set the failbit again
-    in.exceptions(ios::failbit | ios::badbit);
-    in.close();
 }
 
 int Alignment::readPhylip(char *filename, char *sequence_type) {
@@ -2037,26 +2330,19 @@ int Alignment::readPhylip(char *filename, char *sequence_type) {
 void Alignment::doReadPhylipSequential(char *filename, char *sequence_type, StrVector &sequences, int &nseq, int &nsite)
 {
     ostringstream err_str;
-    igzstream in;
+    LineReader in(filename);
     int line_num = 1;
-    // set the failbit and badbit
-    in.exceptions(ios::failbit | ios::badbit);
-    in.open(filename);
-    
     int seq_id = 0;
-    string line;
-    // remove the failbit
-    in.exceptions(ios::badbit);
+    const char *line;
+    size_t len;
     num_states = 0;
 
-    for (; !in.eof(); line_num++) {
-        safeGetline(in, line);
-        line = line.substr(0, line.find_first_of("\n\r"));
-        if (line == "") continue;
+    for (; in.getLine(line, len); line_num++) {
+        if (len == 0) continue;
 
         //cout << line << endl;
         if (nseq == 0) { // read number of sequences and sites
-            istringstream line_in(line);
+            istringstream line_in(string(line, len));
             if (!(line_in >> nseq >> nsite))
                 throw "Invalid PHYLIP format. First line must contain number of sequences and sites";
             //cout << "nseq: " << nseq << "  nsite: " << nsite << endl;
@@ -2073,12 +2359,16 @@ void Alignment::doReadPhylipSequential(char *filename, char *sequence_type, StrV
                 throw "Line " + convertIntToString(line_num) + ": Too many sequences detected";
 
             if (seq_names[seq_id] == "") { // cut out the sequence name
-                string::size_type pos = line.find_first_of(" \t");
-                if (pos == string::npos) pos = 10; //  assume standard phylip
-                seq_names[seq_id] = line.substr(0, pos);
-                line.erase(0, pos);
+                size_t pos = 0;
+                while (pos < len && line[pos] != ' ' && line[pos] != '\t')
+                    pos++;
+                if (pos == len) pos = min(len, (size_t)10); //  assume standard phylip
+                seq_names[seq_id] = string(line, pos);
+                line += pos;
+                len -= pos;
+                sequences[seq_id].reserve(nsite);
             }
-            processSeq(sequences[seq_id], line, line_num);
+            processSeq(sequences[seq_id], line, len, line_num);
             if (sequences[seq_id].length() > nsite)
                 throw ("Line " + convertIntToString(line_num) + ": Sequence " + seq_names[seq_id] + " is too long (" + convertIntToString(sequences[seq_id].length()) + ")");
             if (sequences[seq_id].length() == nsite) {
@@ -2087,10 +2377,6 @@ void Alignment::doReadPhylipSequential(char *filename, char *sequence_type, StrV
         }
         //sequences.
     }
-    in.clear();
-    // set the failbit again
-    in.exceptions(ios::failbit | ios::badbit);
-    in.close();
 }
 
 int Alignment::readPhylipSequential(char *filename, char *sequence_type) {
@@ -2105,10 +2391,10 @@ int Alignment::readPhylipSequential(char *filename, char *sequence_type) {
 
 void Alignment::doReadFasta(char *filename, char *sequence_type, StrVector &sequences, int &nseq, int &nsite){
     ostringstream err_str;
-    igzstream in;
-    // ifstream in;
+    LineReader in(filename);
     int line_num = 1;
-    string line;
+    const char *line;
+    size_t len;
 
     // PoMo with Fasta files is not supported yet.
     // if (sequence_type) {
@@ -2117,41 +2403,33 @@ void Alignment::doReadFasta(char *filename, char *sequence_type, StrVector &sequ
     //         throw "PoMo does not support reading fasta files yet, please use a Counts File.";
     // }
 
-    // set the failbit and badbit
-    in.exceptions(ios::failbit | ios::badbit);
-    in.open(filename);
-    // remove the failbit
-    in.exceptions(ios::badbit);
-
     {
         progress_display progress(in.getCompressedLength(), "Reading fasta file", "", "");
-        for (; !in.eof(); line_num++) {
-            safeGetline(in, line);
-            if (line == "") {
+        for (; in.getLine(line, len); line_num++) {
+            if (len == 0) {
                 continue;
             }
             //cout << line << endl;
             if (line[0] == '>') { // next sequence
-                string::size_type pos = line.find_first_of("\n\r");
-                seq_names.push_back(line.substr(1, pos-1));
+                seq_names.push_back(string(line+1, len-1));
                 trimString(seq_names.back());
                 sequences.push_back("");
+                // sequences of an alignment have the same length as the first one
+                if (sequences.size() > 1)
+                    sequences.back().reserve(sequences.front().length());
                 continue;
             }
             // read sequence contents
             if (sequences.empty()) {
                 throw "First line must begin with '>' to define sequence name";
             }
-            processSeq(sequences.back(), line, line_num);
-            progress = (double)in.getCompressedPosition();
+            processSeq(sequences.back(), line, len, line_num);
+            // updating the progress costs more than parsing a line
+            if ((line_num & 1023) == 0)
+                progress = (double)in.getCompressedPosition();
         }
     }
 
-    in.clear();
-    // set the failbit again
-    in.exceptions(ios::failbit | ios::badbit);
-    in.close();
-
     // now try to cut down sequence name if possible
     int i, step = 0;
     StrVector new_seq_names, remain_seq_names;
@@ -4147,7 +4425,7 @@ void Alignment::getUnobservedConstPatterns(ASCType ASC_type, vector<Pattern> &un
                 if (!isStopCodon(state)) {
                     Pattern pat;
                     pat.resize(getNSeq(), state);
-                    if (pattern_index.find(pat) == pattern_index.end()) {
+                    if (findPattern(pat) < 0) {
                         // constant pattern is unobserved
                         unobserved_ptns.push_back(pat);
                     }
@@ -5456,11 +5734,10 @@ void Alignment::multinomialProb(Alignment refAlign, double &prob)
     double fac = logFac(nsite);
     int index;
     for ( iterator it = begin(); it != end() ; it++) {
-        PatternIntMap::iterator pat_it = refAlign.pattern_index.find((*it));
-        if ( pat_it == refAlign.pattern_index.end() ) //not found ==> error
+        index = refAlign.findPattern(*it);
+        if ( index < 0 ) //not found ==> error
             outError("Pattern in the current alignment is not found in the reference alignment!");
         sumFac += logFac((*it).frequency);
-        index = pat_it->second;
         sumProb += (double)(*it).frequency*log((double)refAlign.at(index).frequency/(double)nsite);
     }
     prob = fac - sumFac + sumProb;
@@ -25,6 +25,8 @@ const int NUM_CHAR = 256;
 typedef bitset<NUM_CHAR> StateBitset;
 
 /** class storing results of symmetry tests */
+class BinaryReader;
+
 class SymTestResult {
 public:
     SymTestResult() {
@@ -79,9 +81,10 @@ struct hashPattern {
         return sum;
     }
 };
-typedef unordered_map<vector<StateType>, int, hashPattern> PatternIntMap;
+/** map from the hash of a pattern to its index; patterns with colliding hashes are told apart by Alignment::findPattern */
+typedef unordered_multimap<size_t, int> PatternIntMap;
 #else
-typedef map<vector<StateType>, int> PatternIntMap;
+typedef multimap<size_t, int> PatternIntMap;
 #endif
 
 
@@ -156,6 +159,12 @@ public:
      */
     bool addPattern(Pattern &pat, int site, int freq = 1);
 
+    /**
+            @param pat a pattern
+            @return index of the identical pattern in this alignment, -1 if not found
+     */
+    int findPattern(const vector<StateType> &pat) const;
+
     
     /**
         Update a bunch of patterns that have been added via addPatternLazy
@@ -200,6 +209,20 @@ public:
     int readNexus(char *filename);
 
     int buildPattern(StrVector &sequences, char *sequence_type, int nseq, int nsite);
+
+    /**
+            write the compressed alignment (sequence names, data type, patterns and site_pattern)
+            in the binary format of the alignment cache (.iqa)
+            @param out binary output stream
+     */
+    void writeBinary(ostream &out);
+
+    /**
+            read the compressed alignment written by writeBinary()
+            @param in reader positioned at the data written by writeBinary()
+            @throw string if the data is corrupted
+     */
+    void readBinary(BinaryReader &in);
     
     /**
             do-read the alignment in PHYLIP format (interleaved)
@@ -666,6 +689,19 @@ public:
      @param[out] support number of sites supporting 12|34, 13|24 and 14|23
      */
     virtual void computeQuartetSupports(IntVector &quartet, vector<int64_t> &support);
+
+    /**
+     build the sequence-major bit planes of informative patterns used by computeQuartetSupports:
+     one bit per pattern for each sequence and state. Patterns are grouped by frequency such that
+     every 64-bit word holds patterns of the same frequency.
+     Nothing is built for more than 32 states (e.g. codons), where the planes outgrow the patterns.
+     */
+    virtual void buildQuartetBitPlanes();
+
+    /**
+     free the bit planes of buildQuartetBitPlanes
+     */
+    virtual void clearQuartetBitPlanes();
     
     /****************************************************************************
             Distance functions
@@ -1029,7 +1065,8 @@ protected:
     IntVector site_pattern;
 
     /**
-            hash map from pattern to index in the vector of patterns (the alignment)
+            hash map from pattern hash to index in the vector of patterns (the alignment).
+            Only the hash is stored as key, the states are looked up in the patterns themselves
      */
     PatternIntMap pattern_index;
     
@@ -1038,6 +1075,22 @@ protected:
      */
     double* cache_ntfreq = NULL;
 
+    /**
+            bit planes of informative patterns for computeQuartetSupports,
+            (sequence, state, word) in row-major order
+     */
+    vector<uint64_t> quartet_planes;
+
+    /**
+            number of 64-bit words per bit plane
+     */
+    size_t quartet_plane_words = 0;
+
+    /**
+            pattern frequency of each word of the bit planes
+     */
+    IntVector quartet_word_freq;
+
 private:
     /**
         Generate a reference genome from input_sequences
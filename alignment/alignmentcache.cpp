@@ -0,0 +1,234 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "alignmentcache.h"
+#include "utils/tools.h"
+#include <fstream>
+#include <algorithm>
+#include <zlib.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <process.h>
+#endif
+
+/** magic number of .iqa files, followed by the format version */
+const char ALN_CACHE_MAGIC[4] = {'I', 'Q', 'A', '1'};
+
+/** written as a number to detect caches created on a machine with different byte order */
+const uint32_t ALN_CACHE_BYTE_ORDER = 0x01020304;
+
+void writeBinaryString(ostream &out, const string &str) {
+    writeBinary<uint64_t>(out, str.length());
+    out.write(str.data(), str.length());
+}
+
+bool AlignmentCache::computeSignature(const string &filename, uint64_t &size, uint32_t &crc) {
+    FILE *fp = fopen(filename.c_str(), "rb");
+    if (!fp)
+        return false;
+    vector<unsigned char> buffer(1 << 20);
+    size = 0;
+    crc = crc32(0L, Z_NULL, 0);
+    size_t num;
+    while ((num = fread(buffer.data(), 1, buffer.size(), fp)) > 0) {
+        crc = crc32(crc, buffer.data(), (uInt)num);
+        size += num;
+    }
+    bool ok = !ferror(fp);
+    fclose(fp);
+    return ok;
+}
+
+AlignmentCache::AlignmentCache(string cache_file, const vector<string> &sources) {
+    this->cache_file = cache_file;
+    mapped = NULL;
+    mapped_len = 0;
+    mapped_alloc = false;
+    for (auto source : sources)
+        addSource(source);
+
+    // map the existing cache file
+#ifndef _WIN32
+    int fd = open(cache_file.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            mapped = (char*)addr;
+            mapped_len = st.st_size;
+        }
+    }
+    close(fd);
+#else
+    ifstream in(cache_file.c_str(), ios::binary | ios::ate);
+    if (!in.is_open())
+        return;
+    mapped_len = in.tellg();
+    if (mapped_len > 0) {
+        mapped = new char[mapped_len];
+        mapped_alloc = true;
+        in.seekg(0);
+        in.read(mapped, mapped_len);
+    }
+    in.close();
+#endif
+    if (!mapped)
+        return;
+
+    // check the header and the source files
+    bool valid = true;
+    try {
+        BinaryReader in(mapped, mapped_len);
+        if (memcmp(in.readBlock(sizeof(ALN_CACHE_MAGIC)), ALN_CACHE_MAGIC, sizeof(ALN_CACHE_MAGIC)) != 0 ||
+            in.read<uint32_t>() != ALN_CACHE_BYTE_ORDER)
+            throw string("Unknown alignment cache format");
+        uint32_t num_sources = in.read<uint32_t>();
+        size_t num_required = source_files.size();
+        size_t num_found = 0;
+        for (uint32_t i = 0; i < num_sources; i++) {
+            string source = in.readString();
+            uint64_t size = in.read<uint64_t>();
+            uint32_t crc = in.read<uint32_t>();
+            auto it = find(source_files.begin(), source_files.end(), source);
+            if (it == source_files.end()) {
+                addSource(source);
+                it = source_files.end() - 1;
+            } else if (it - source_files.begin() < num_required) {
+                num_found++;
+            }
+            size_t id = it - source_files.begin();
+            if (source_sizes[id] != size || source_crcs[id] != crc)
+                valid = false;
+        }
+        if (num_found != num_required)
+            valid = false;
+        uint32_t num_entries = in.read<uint32_t>();
+        for (uint32_t i = 0; i < num_entries && valid; i++) {
+            string key = in.readString();
+            uint64_t len = in.read<uint64_t>();
+            const char *data = in.readBlock(len);
+            old_entries[key] = make_pair((size_t)(data - mapped), (size_t)len);
+        }
+        if (!valid)
+            cout << "NOTE: Alignment cache " << cache_file << " is out of date and will be rebuilt" << endl;
+    } catch (string &str) {
+        outWarning(str + " " + cache_file + ", it will be rebuilt");
+        valid = false;
+    }
+    if (!valid) {
+        old_entries.clear();
+        // forget the sources recorded in the stale cache
+        source_files.resize(sources.size());
+        source_sizes.resize(sources.size());
+        source_crcs.resize(sources.size());
+    }
+}
+
+AlignmentCache::~AlignmentCache() {
+    if (!mapped)
+        return;
+    if (mapped_alloc)
+        delete [] mapped;
+#ifndef _WIN32
+    else
+        munmap(mapped, mapped_len);
+#endif
+}
+
+void AlignmentCache::addSource(const string &source) {
+    if (find(source_files.begin(), source_files.end(), source) != source_files.end())
+        return;
+    uint64_t size = 0;
+    uint32_t crc = 0;
+    if (!computeSignature(source, size, crc))
+        outWarning("Cannot read " + source + " to check the alignment cache");
+    source_files.push_back(source);
+    source_sizes.push_back(size);
+    source_crcs.push_back(crc);
+}
+
+bool AlignmentCache::getEntry(const string &key, const char *&data, size_t &len) {
+    auto new_it = new_entries.find(key);
+    if (new_it != new_entries.end()) {
+        data = new_it->second.data();
+        len = new_it->second.length();
+        return true;
+    }
+    auto it = old_entries.find(key);
+    if (it == old_entries.end())
+        return false;
+    data = mapped + it->second.first;
+    len = it->second.second;
+    return true;
+}
+
+void AlignmentCache::putEntry(const string &key, const string &data) {
+    new_entries[key] = data;
+    old_entries.erase(key);
+}
+
+void AlignmentCache::save() {
+#ifndef _WIN32
+    string tmp_file = cache_file + "." + convertIntToString(getpid()) + ".tmp";
+#else
+    string tmp_file = cache_file + "." + convertIntToString(_getpid()) + ".tmp";
+#endif
+    try {
+        ofstream out;
+        out.exceptions(ios::failbit | ios::badbit);
+        out.open(tmp_file.c_str(), ios::binary);
+        out.write(ALN_CACHE_MAGIC, sizeof(ALN_CACHE_MAGIC));
+        writeBinary<uint32_t>(out, ALN_CACHE_BYTE_ORDER);
+        writeBinary<uint32_t>(out, source_files.size());
+        for (size_t i = 0; i < source_files.size(); i++) {
+            writeBinaryString(out, source_files[i]);
+            writeBinary<uint64_t>(out, source_sizes[i]);
+            writeBinary<uint32_t>(out, source_crcs[i]);
+        }
+        writeBinary<uint32_t>(out, old_entries.size() + new_entries.size());
+        for (auto &entry : old_entries) {
+            writeBinaryString(out, entry.first);
+            writeBinary<uint64_t>(out, entry.second.second);
+            out.write(mapped + entry.second.first, entry.second.second);
+        }
+        for (auto &entry : new_entries) {
+            writeBinaryString(out, entry.first);
+            writeBinary<uint64_t>(out, entry.second.length());
+            out.write(entry.second.data(), entry.second.length());
+        }
+        out.close();
+#ifdef _WIN32
+        remove(cache_file.c_str());
+#endif
+        if (rename(tmp_file.c_str(), cache_file.c_str()) != 0)
+            throw ios::failure("rename");
+    } catch (ios::failure &) {
+        remove(tmp_file.c_str());
+        outWarning("Cannot write alignment cache " + cache_file);
+    }
+}
@@ -0,0 +1,177 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef ALIGNMENTCACHE_H
+#define ALIGNMENTCACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+#include <stdint.h>
+#include <string.h>
+
+using namespace std;
+
+/**
+    reader of little pieces of binary data from a memory block, used to load the alignment cache
+*/
+class BinaryReader {
+public:
+
+    /**
+        constructor
+        @param data first byte
+        @param len number of bytes
+    */
+    BinaryReader(const char *data, size_t len) : pos(data), end(data + len) {}
+
+    /**
+        get a block of bytes and skip over it
+        @param len number of bytes
+        @return first byte of the block
+        @throw string if the data is truncated
+    */
+    const char *readBlock(size_t len) {
+        if (len > (size_t)(end - pos))
+            throw string("Alignment cache is truncated");
+        const char *block = pos;
+        pos += len;
+        return block;
+    }
+
+    /** read a plain value */
+    template <class T>
+    T read() {
+        T value;
+        memcpy(&value, readBlock(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    /** read a string written by writeBinaryString() */
+    string readString() {
+        uint64_t len = read<uint64_t>();
+        const char *str = readBlock(len);
+        return string(str, len);
+    }
+
+    /** current position */
+    const char *pos;
+
+    /** end of the memory block */
+    const char *end;
+};
+
+/** write a plain value in the format of BinaryReader::read() */
+template <class T>
+void writeBinary(ostream &out, T value) {
+    out.write((const char*)&value, sizeof(T));
+}
+
+/** write a string in the format of BinaryReader::readString() */
+void writeBinaryString(ostream &out, const string &str);
+
+/**
+    Binary cache of compressed alignments (.iqa file).
+    The cache stores named entries (e.g. an alignment built with a given sequence type,
+    or all partitions of a partition file) together with the size and CRC-32 of
+    every source file they were built from; a cache whose sources changed is ignored.
+    The existing file is memory-mapped, such that loading an entry only copies
+    the pattern matrix into the alignment.
+*/
+class AlignmentCache {
+public:
+
+    /**
+        constructor, map the cache file if it exists and was built from the current source files
+        @param cache_file name of the cache file
+        @param sources files that the cached entries must be built from
+    */
+    AlignmentCache(string cache_file, const vector<string> &sources);
+
+    ~AlignmentCache();
+
+    /**
+        @param key name of the entry
+        @param[out] data first byte of the entry
+        @param[out] len number of bytes of the entry
+        @return TRUE if the entry exists
+    */
+    bool getEntry(const string &key, const char *&data, size_t &len);
+
+    /**
+        add or replace an entry, the file is only updated by save()
+        @param key name of the entry
+        @param data content of the entry
+    */
+    void putEntry(const string &key, const string &data);
+
+    /**
+        add a source file of the entries in addition to those given to the constructor
+        @param source file name
+    */
+    void addSource(const string &source);
+
+    /**
+        write all entries to the cache file; the file is replaced atomically,
+        so that concurrent jobs never read a partial cache
+    */
+    void save();
+
+    /** @return name of the cache file */
+    const string &getFileName() { return cache_file; }
+
+protected:
+
+    /**
+        compute size and CRC-32 of a file
+        @param filename file name
+        @param[out] size file size
+        @param[out] crc CRC-32 of the content
+        @return FALSE if the file cannot be read
+    */
+    static bool computeSignature(const string &filename, uint64_t &size, uint32_t &crc);
+
+    /** name of the cache file */
+    string cache_file;
+
+    /** source files and their signature */
+    vector<string> source_files;
+    vector<uint64_t> source_sizes;
+    vector<uint32_t> source_crcs;
+
+    /** content of the existing cache file, NULL if there is none or it is stale */
+    char *mapped;
+
+    /** number of bytes of the existing cache file */
+    size_t mapped_len;
+
+    /** TRUE if mapped was allocated instead of memory-mapped */
+    bool mapped_alloc;
+
+    /** entries of the existing cache file, as offset and length into mapped */
+    map<string, pair<size_t, size_t> > old_entries;
+
+    /** new or replaced entries */
+    map<string, string> new_entries;
+};
+
+#endif // ALIGNMENTCACHE_H
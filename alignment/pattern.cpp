@@ -46,6 +46,33 @@ Pattern::Pattern(const Pattern &pat)
     num_chars = pat.num_chars;
 }
 
+Pattern::Pattern(Pattern &&pat) noexcept
+        : vector<StateType>(std::move(pat))
+{
+    frequency = pat.frequency;
+    flag = pat.flag;
+    const_char = pat.const_char;
+    num_chars = pat.num_chars;
+}
+
+Pattern &Pattern::operator= (const Pattern &pat) {
+    vector<StateType>::operator=(pat);
+    frequency = pat.frequency;
+    flag = pat.flag;
+    const_char = pat.const_char;
+    num_chars = pat.num_chars;
+    return *this;
+}
+
+Pattern &Pattern::operator= (Pattern &&pat) noexcept {
+    vector<StateType>::operator=(std::move(pat));
+    frequency = pat.frequency;
+    flag = pat.flag;
+    const_char = pat.const_char;
+    num_chars = pat.num_chars;
+    return *this;
+}
+
 Pattern::~Pattern()
 {
 }
@@ -41,6 +41,15 @@ public:
 
     Pattern(const Pattern &pat);
 
+    /**
+        move constructor, such that growing a vector of patterns does not copy the states
+    */
+    Pattern(Pattern &&pat) noexcept;
+
+    Pattern &operator= (const Pattern &pat);
+
+    Pattern &operator= (Pattern &&pat) noexcept;
+
     /**
 		@param num_states number of states of the model
 		@return the number of ambiguous character incl. gaps 
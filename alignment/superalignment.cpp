@@ -78,13 +78,30 @@ void SuperAlignment::readFromParams(Params &params) {
         readPartitionList(params.partition_file, params.sequence_type, params.intype, params.model_name, params.remove_empty_seq);
     } else {
         cout << "Reading partition model file " << params.partition_file << " ..." << endl;
-        if (detectInputFile(params.partition_file) == IN_NEXUS) {
-            readPartitionNexus(params);
-            if (partitions.empty()) {
-                outError("No partition found in SETS block. An example syntax looks like: \n#nexus\nbegin sets;\n  charset part1=1-100;\n  charset part2=101-300;\nend;");
-            }
-        } else
-            readPartitionRaxml(params);
+        // partitions are cached in FILE.iqa of the partition file, built from the partition and alignment files
+        AlignmentCache *cache = NULL;
+        string cache_key;
+        if (params.aln_cache && !params.alisim_active) {
+            StrVector sources(1, params.partition_file);
+            if (params.aln_file)
+                sources.push_back(params.aln_file);
+            cache = new AlignmentCache(string(params.partition_file) + ".iqa", sources);
+            cache_key = string("partitions:") + (params.sequence_type ? params.sequence_type : "") + ":" + params.model_name +
+                (params.remove_empty_seq ? ":remove_empty_seq" : "") + (params.phylip_sequential_format ? ":sequential" : "");
+        }
+        if (!cache || !readPartitionCache(cache, cache_key)) {
+            if (detectInputFile(params.partition_file) == IN_NEXUS) {
+                readPartitionNexus(params);
+                if (partitions.empty()) {
+                    outError("No partition found in SETS block. An example syntax looks like: \n#nexus\nbegin sets;\n  charset part1=1-100;\n  charset part2=101-300;\nend;");
+                }
+            } else
+                readPartitionRaxml(params);
+            if (cache)
+                writePartitionCache(cache, cache_key);
+        }
+        if (cache)
+            delete cache;
     }
     if (partitions.empty())
         outError("No partition found");
@@ -620,6 +637,59 @@ void SuperAlignment::readPartitionNexus(Params &params) {
     delete sets_block;
 }
 
+bool SuperAlignment::readPartitionCache(AlignmentCache *cache, const string &key) {
+    const char *data;
+    size_t len;
+    if (!cache->getEntry(key, data, len))
+        return false;
+    cout << "Alignment cache " << cache->getFileName() << " found" << endl;
+    vector<Alignment*> cached_partitions;
+    try {
+        BinaryReader in(data, len);
+        uint32_t num_partitions = in.read<uint32_t>();
+        for (uint32_t part = 0; part < num_partitions; part++) {
+            Alignment *part_aln = new Alignment();
+            cached_partitions.push_back(part_aln);
+            part_aln->name = in.readString();
+            part_aln->model_name = in.readString();
+            part_aln->aln_file = in.readString();
+            part_aln->position_spec = in.readString();
+            part_aln->sequence_type = in.readString();
+            part_aln->tree_len = in.read<double>();
+            part_aln->readBinary(in);
+        }
+    } catch (string &str) {
+        outWarning(str + ", reading the partitions instead");
+        for (auto part_aln : cached_partitions)
+            delete part_aln;
+        return false;
+    }
+    partitions.insert(partitions.end(), cached_partitions.begin(), cached_partitions.end());
+    return true;
+}
+
+void SuperAlignment::writePartitionCache(AlignmentCache *cache, const string &key) {
+    ostringstream out;
+    ::writeBinary<uint32_t>(out, partitions.size());
+    for (auto part_aln : partitions) {
+        // partitions made of several files cannot be checked for changes
+        if (part_aln->isSuperAlignment() || part_aln->seq_type == SEQ_POMO ||
+            part_aln->aln_file.find(',') != string::npos || isDirectory(part_aln->aln_file.c_str()))
+            return;
+        if (!part_aln->aln_file.empty())
+            cache->addSource(part_aln->aln_file);
+        writeBinaryString(out, part_aln->name);
+        writeBinaryString(out, part_aln->model_name);
+        writeBinaryString(out, part_aln->aln_file);
+        writeBinaryString(out, part_aln->position_spec);
+        writeBinaryString(out, part_aln->sequence_type);
+        ::writeBinary<double>(out, part_aln->tree_len);
+        part_aln->writeBinary(out);
+    }
+    cache->putEntry(key, out.str());
+    cache->save();
+}
+
 void SuperAlignment::readPartitionDir(string partition_dir, char *sequence_type,
                                       InputType &intype, string model, bool remove_empty_seq) {
     //    Params origin_params = params;
@@ -1738,7 +1808,7 @@ Alignment *SuperAlignment::concatenateAlignments(set<int> &ids) {
     		//ASSERT(part_seq == partitions[id]->getNSeq());
     		aln->addPattern(pat, pattern_to_sites[it - partitions[id]->begin()][0], (*it).frequency);
     		// IMPORTANT BUG FIX FOLLOW
-    		int ptnindex = aln->pattern_index[pat];
+    		int ptnindex = aln->findPattern(pat);
 
             // 2021-04-14: build original site to patterns index
             ASSERT((*it).frequency == pattern_to_sites[it - partitions[id]->begin()].size());
@@ -21,6 +21,7 @@
 #define SUPERALIGNMENT_H
 
 #include "alignment.h"
+#include "alignmentcache.h"
 
 /**
 Super alignment representing presence/absence of sequences in
@@ -73,6 +74,21 @@ public:
     /** read partition model file in NEXUS format into variable info */
     void readPartitionNexus(Params &params);
 
+    /**
+        load all partitions from an entry of the alignment cache (option --aln-cache)
+        @param cache alignment cache of the partition file
+        @param key name of the cache entry
+        @return TRUE if the entry exists and was loaded
+    */
+    bool readPartitionCache(AlignmentCache *cache, const string &key);
+
+    /**
+        store all partitions as an entry of the alignment cache and write the cache file
+        @param cache alignment cache of the partition file
+        @param key name of the cache entry
+    */
+    void writePartitionCache(AlignmentCache *cache, const string &key);
+
     /** read partition as files in a directory */
     void readPartitionDir(string partition_dir, char *sequence_type, InputType &intype, string model, bool remove_empty_seq);
 
@@ -258,6 +274,16 @@ public:
      @param[out] support number of sites supporting 12|34, 13|24 and 14|23
      */
     virtual void computeQuartetSupports(IntVector &quartet, vector<int64_t> &support);
+
+    /**
+     build the bit planes of all partitions
+     */
+    virtual void buildQuartetBitPlanes();
+
+    /**
+     free the bit planes of all partitions
+     */
+    virtual void clearQuartetBitPlanes();
     
 	/**
 		@return unconstrained log-likelihood (without a tree)
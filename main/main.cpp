@@ -1265,22 +1265,51 @@ void calcDistribution(Params &params) {
     }
 }
 
-void printRFDist(string filename, double *rfdist, int n, int m, int rf_dist_mode, bool print_msg = true) {
+/**
+    print the header of an RF distance file in CSV format
+*/
+void printRFDistCSVHeader(ostream &out, string filename) {
+    out << "# Robinson-Foulds distances" << endl
+    << "# This file can be read in MS Excel or in R with command:" << endl
+    << "#    dat=read.csv('" <<  filename << "',comment.char='#')" << endl
+    << "# Columns are comma-separated with following meanings:" << endl
+    << "#    ID1:     Tree 1 ID" << endl
+    << "#    ID2:     Tree 2 ID" << endl
+    << "#    Dist:    Robinson-Foulds distance" << endl
+    << "ID1,ID2,Dist" << endl;
+}
+
+/**
+    print rows of an all-pair RF distance matrix
+    @param rfdist nrows x m distances
+    @param first_row index of the first row
+*/
+void printRFDistRows(ostream &out, double *rfdist, int first_row, int nrows, int m) {
     int i, j;
+    if (Params::getInstance().output_format == FORMAT_CSV) {
+        for (i = 0; i < nrows; i++)  {
+            for (j = 0; j < m; j++)
+                out << first_row+i+1 << ',' << j+1 << ',' << rfdist[(size_t)i*m+j] << endl;
+        }
+    } else {
+        for (i = 0; i < nrows; i++)  {
+            out << "Tree" << first_row+i << "      ";
+            for (j = 0; j < m; j++)
+                out << " " << rfdist[(size_t)i*m+j];
+            out << endl;
+        }
+    }
+}
+
+void printRFDist(string filename, double *rfdist, int n, int m, int rf_dist_mode, bool print_msg = true) {
+    int i;
 
     try {
         ofstream out;
         out.exceptions(ios::failbit | ios::badbit);
         out.open(filename);
         if (Params::getInstance().output_format == FORMAT_CSV) {
-            out << "# Robinson-Foulds distances" << endl
-            << "# This file can be read in MS Excel or in R with command:" << endl
-            << "#    dat=read.csv('" <<  filename << "',comment.char='#')" << endl
-            << "# Columns are comma-separated with following meanings:" << endl
-            << "#    ID1:     Tree 1 ID" << endl
-            << "#    ID2:     Tree 2 ID" << endl
-            << "#    Dist:    Robinson-Foulds distance" << endl
-            << "ID1,ID2,Dist" << endl;
+            printRFDistCSVHeader(out, filename);
             if (rf_dist_mode == RF_ADJACENT_PAIR) {
                 for (i = 0; i < n; i++)
                     out << i+1 << ',' << i+2 << ',' << rfdist[i] << endl;
@@ -1288,10 +1317,7 @@ void printRFDist(string filename, double *rfdist, int n, int m, int rf_dist_mode
                 for (i = 0; i < n; i++)
                     out << i+1 << ',' << i+1 << ',' << rfdist[i] << endl;
             } else {
-                for (i = 0; i < n; i++)  {
-                    for (j = 0; j < m; j++)
-                        out << i+1 << ',' << j+1 << ',' << rfdist[i*m+j] << endl;
-                }
+                printRFDistRows(out, rfdist, 0, n, m);
             }
         } else if (rf_dist_mode == RF_ADJACENT_PAIR || Params::getInstance().rf_same_pair) {
             out << "XXX        ";
@@ -1302,12 +1328,7 @@ void printRFDist(string filename, double *rfdist, int n, int m, int rf_dist_mode
         } else {
             // all pairs
             out << n << " " << m << endl;
-            for (i = 0; i < n; i++)  {
-                out << "Tree" << i << "      ";
-                for (j = 0; j < m; j++)
-                    out << " " << rfdist[i*m+j];
-                out << endl;
-            }
+            printRFDistRows(out, rfdist, 0, n, m);
         }
         out.close();
         if (print_msg)
@@ -1317,6 +1338,42 @@ void printRFDist(string filename, double *rfdist, int n, int m, int rf_dist_mode
     }
 }
 
+/** maximum number of distances kept in memory by printRFDistAllPairs */
+#define RF_TILE_ENTRIES (1 << 24)
+
+/**
+    compute and print all-pair RF distances of a tree set. The matrix is
+    computed in tiles of rows that are written out immediately, so that it
+    never has to be kept in memory as a whole
+*/
+void printRFDistAllPairs(string filename, MTreeSet &trees, double weight_threshold) {
+    cout << "Computing Robinson-Foulds distance..." << endl;
+    RFDistEngine engine(trees, weight_threshold);
+    int n = engine.size();
+    int tile = max(1, min(n, RF_TILE_ENTRIES / max(n, 1)));
+    double *rfdist = new double [(size_t)tile*n];
+
+    try {
+        ofstream out;
+        out.exceptions(ios::failbit | ios::badbit);
+        out.open(filename);
+        if (Params::getInstance().output_format == FORMAT_CSV)
+            printRFDistCSVHeader(out, filename);
+        else
+            out << n << " " << n << endl;
+        for (int first_row = 0; first_row < n; first_row += tile) {
+            int nrows = min(tile, n - first_row);
+            engine.computeRFDistRows(first_row, nrows, rfdist);
+            printRFDistRows(out, rfdist, first_row, nrows, n);
+        }
+        out.close();
+        cout << "Robinson-Foulds distances printed to " << filename << endl;
+    } catch (ios::failure) {
+        outError(ERR_WRITE_OUTPUT, filename);
+    }
+    delete [] rfdist;
+}
+
 void computeRFDistExtended(const char *trees1, const char *trees2, const char *filename) {
     cout << "Reading input trees 1 file " << trees1 << endl;
     int ntrees = 0, ntrees2 = 0;
@@ -1456,9 +1513,12 @@ void computeRFDist(Params &params) {
                                 infoname.c_str(),treename.c_str(), incomp_splits);
         else
             trees.computeRFDist(rfdist, &treeset2, params.rf_same_pair);
+    } else if (params.rf_dist_mode == RF_ALL_PAIR) {
+        printRFDistAllPairs(filename, trees, params.split_weight_threshold);
+        return;
     } else {
-        rfdist = new double [n*n];
-        memset(rfdist, 0, n*n* sizeof(double));
+        rfdist = new double [n];
+        memset(rfdist, 0, n* sizeof(double));
         trees.computeRFDist(rfdist, params.rf_dist_mode, params.split_weight_threshold);
     }
 
@@ -2274,6 +2334,7 @@ int main(int argc, char *argv[]) {
     Checkpoint *checkpoint = new Checkpoint;
     string filename = (string)Params::getInstance().out_prefix +".ckp.gz";
     checkpoint->setFileName(filename);
+    checkpoint->setBinary(Params::getInstance().binary_checkpoint);
     
     bool append_log = false;
     
@@ -64,11 +64,7 @@
 #include "utils/MPIHelper.h"
 #include "timetree.h"
 
-#ifdef USE_BOOSTER
-extern "C" {
-#include "booster/booster.h"
-}
-#endif
+#include "tree/transferbootstrap.h"
 
 #ifdef IQTREE_TERRAPHAST
     #include "terracetphast/terracetphast.h"
@@ -2573,6 +2569,8 @@ void printFinalSearchInfo(Params &params, IQTree &iqtree, double search_cpu_time
     params.run_time = (getCPUTime() - params.startCPUTime);
     cout << endl;
     cout << "Total number of iterations: " << iqtree.stop_rule.getCurIt() << endl;
+    if (params.lh_mem_save == LM_MEM_SAVE && verbose_mode >= VB_MED)
+        iqtree.reportMemSlots(cout);
 //    cout << "Total number of partial likelihood vector computations: " << iqtree.num_partial_lh_computations << endl;
     cout << "CPU time used for tree search: " << search_cpu_time
             << " sec (" << convert_time(search_cpu_time) << ")" << endl;
@@ -3870,7 +3868,6 @@ void runStandardBootstrap(Params &params, Alignment *alignment, IQTree *tree) {
     } else
         cout << endl;
 
-#ifdef USE_BOOSTER
     if (params.transfer_bootstrap) {
         // transfer bootstrap expectation (TBE)
         cout << "Performing transfer bootstrap expectation..." << endl;
@@ -3879,16 +3876,15 @@ void runStandardBootstrap(Params &params, Alignment *alignment, IQTree *tree) {
         string out_tree = (string)params.out_prefix + ".tbe.tree";
         string out_raw_tree = (string)params.out_prefix + ".tbe.rawtree";
         string stat_out = (string)params.out_prefix + ".tbe.stat";
-        main_booster(input_tree.c_str(), boot_trees.c_str(), out_tree.c_str(),
-                     (params.transfer_bootstrap==2) ? out_raw_tree.c_str() : NULL,
-                     stat_out.c_str(), (verbose_mode >= VB_MED) ? 0 : 1);
+        computeTransferBootstrap(input_tree.c_str(), boot_trees.c_str(), out_tree.c_str(),
+                                 (params.transfer_bootstrap==2) ? out_raw_tree.c_str() : NULL,
+                                 stat_out.c_str());
         cout << "TBE tree written to " << out_tree << endl;
         if (params.transfer_bootstrap == 2)
             cout << "TBE raw tree written to " << out_raw_tree << endl;
         cout << "TBE statistic written to " << stat_out << endl;
         cout << endl;
     }
-#endif
     
     if (MPIHelper::getInstance().isMaster()) {
         cout << "Total CPU time for " << RESAMPLE_NAME << ": " << (getCPUTime() - start_time) << " seconds." << endl;
@@ -12,6 +12,7 @@
 #endif
 #include <iqtree_config.h>
 #include <numeric>
+#include <functional>
 #include "tree/phylotree.h"
 #include "tree/iqtree.h"
 #include "tree/phylosupertree.h"
@@ -808,8 +809,8 @@ void runModelFinder(Params &params, IQTree &iqtree, ModelCheckpoint &model_info,
     // Model already specifed, nothing to do here
     if (!empty_model_found && params.model_name.substr(0, 4) != "TEST" && params.model_name.substr(0, 2) != "MF")
         return;
-    if (MPIHelper::getInstance().getNumProcesses() > 1)
-        outError("Please use only 1 MPI process! We are currently working on the MPI parallelization of model selection.");
+    if (MPIHelper::getInstance().getNumProcesses() > 1 && (params.model_test_and_tree || params.modelomatic))
+        outError("Please use only 1 MPI process for ModelFinder with full tree search or ModelOMatic");
     // TODO: check if necessary
     //        if (iqtree.isSuperTree())
     //            ((PhyloSuperTree*) &iqtree)->mapTrees();
@@ -817,6 +818,7 @@ void runModelFinder(Params &params, IQTree &iqtree, ModelCheckpoint &model_info,
     double real_time = getRealTime();
     model_info.setFileName((string)params.out_prefix + ".model.gz");
     model_info.setDumpInterval(params.checkpoint_dump_interval);
+    model_info.setBinary(params.binary_checkpoint);
     
     bool ok_model_file = false;
     if (!params.model_test_again) {
@@ -828,6 +830,9 @@ void runModelFinder(Params &params, IQTree &iqtree, ModelCheckpoint &model_info,
     ok_model_file &= model_info.size() > 0;
     if (ok_model_file)
         cout << "NOTE: Restoring information from model checkpoint file " << model_info.getFileName() << endl;
+    // only the master writes the model checkpoint
+    if (MPIHelper::getInstance().isWorker())
+        model_info.setFileName("");
     
     
     Checkpoint *orig_checkpoint = iqtree.getCheckpoint();
@@ -867,6 +872,15 @@ void runModelFinder(Params &params, IQTree &iqtree, ModelCheckpoint &model_info,
         }
     }
     
+#ifdef _IQTREE_MPI
+    if (MPIHelper::getInstance().getNumProcesses() > 1) {
+        // all processes start from the initial tree of the master
+        MPIHelper::getInstance().broadcastCheckpoint(&model_info);
+        if (MPIHelper::getInstance().isWorker())
+            iqtree.restoreCheckpoint();
+    }
+#endif
+
     // also save initial tree to the original .ckp.gz checkpoint
     //        string initTree = iqtree.getTreeString();
     //        CKP_SAVE(initTree);
@@ -902,7 +916,7 @@ void runModelFinder(Params &params, IQTree &iqtree, ModelCheckpoint &model_info,
     } else {
         // single model selection
         CandidateModel best_model;
-        if (params.openmp_by_model)
+        if (params.openmp_by_model || MPIHelper::getInstance().getNumProcesses() > 1)
             best_model = CandidateModelSet().evaluateAll(params, &iqtree,
                 model_info, models_block, params.num_threads, BRLEN_OPTIMIZE);
         else
@@ -1806,6 +1820,139 @@ string CandidateModel::evaluateConcatenation(Params &params, SuperAlignment *sup
     return concat_tree;
 }
 
+#ifdef _IQTREE_MPI
+/** append the result of a ModelFinder job to a message */
+void packJobResult(ostream &out, int64_t job, ModelCheckpoint &result) {
+    out << job << ' ' << result.size() << '\n';
+    for (auto it = result.begin(); it != result.end(); it++)
+        out << it->first.length() << ' ' << it->second.length() << '\n' << it->first << it->second;
+}
+
+/**
+    read the next result of a ModelFinder job from a message
+    @return false at the end of the message
+*/
+bool unpackJobResult(istream &in, int64_t &job, ModelCheckpoint &result) {
+    size_t num_keys;
+    if (!(in >> job >> num_keys))
+        return false;
+    in.get();
+    for (size_t i = 0; i < num_keys; i++) {
+        size_t key_len, value_len;
+        in >> key_len >> value_len;
+        in.get();
+        string key(key_len, ' '), value(value_len, ' ');
+        in.read(&key[0], key_len);
+        in.read(&value[0], value_len);
+        result[key] = value;
+    }
+    return true;
+}
+#endif
+
+/**
+    Run a loop of independent ModelFinder jobs. With several MPI processes the master hands out
+    the jobs to the workers (one job at a time per worker, using all its threads) and merges
+    the results in the order they arrive. Every job message and the final stop message also
+    carry the results merged since the previous message to that worker, such that all processes
+    merge all results in the same order and leave the loop in the same state.
+    Otherwise the jobs 0..num_jobs-1 are run by OpenMP threads and merged in a critical section.
+    @param num_jobs number of jobs
+    @param get_job with MPI, return the next job (called on the master only), -1 if there is none left;
+           NULL to hand out the jobs 0..num_jobs-1 in order
+    @param parallel true to run the jobs in parallel with OpenMP in a single process
+    @param run_job compute a job and store its result
+    @param merge_job merge the result of a job into the state of the calling process
+*/
+void runModelFinderJobs(int64_t num_jobs, function<int64_t()> get_job, bool parallel,
+                        function<void(int64_t, ModelCheckpoint&)> run_job,
+                        function<void(int64_t, ModelCheckpoint&)> merge_job)
+{
+    int64_t next_job = 0;
+    if (!get_job)
+        get_job = [&]() { return (next_job < num_jobs) ? next_job++ : (int64_t)-1; };
+#ifdef _IQTREE_MPI
+    MPIHelper &mpi = MPIHelper::getInstance();
+    if (mpi.getNumProcesses() > 1) {
+        if (mpi.isMaster()) {
+            vector<string> merged;
+            vector<size_t> num_sent(mpi.getNumProcesses(), 0);
+            auto sendJob = [&](int worker, int64_t job) {
+                stringstream ss;
+                ss << job << '\n';
+                for (size_t i = num_sent[worker]; i < merged.size(); i++)
+                    ss << merged[i];
+                num_sent[worker] = merged.size();
+                string msg = ss.str();
+                mpi.sendString(msg, worker, MF_JOB_TAG);
+            };
+            int busy = 0;
+            for (int worker = 1; worker < mpi.getNumProcesses(); worker++) {
+                int64_t job = get_job();
+                if (job < 0)
+                    break;
+                sendJob(worker, job);
+                busy++;
+            }
+            while (busy > 0) {
+                string msg;
+                int worker = mpi.recvString(msg, MPI_ANY_SOURCE, MF_RESULT_TAG);
+                busy--;
+                stringstream ss(msg);
+                int64_t job;
+                ModelCheckpoint result;
+                if (!unpackJobResult(ss, job, result))
+                    outError("Invalid ModelFinder result from MPI process ", convertIntToString(worker));
+                merge_job(job, result);
+                merged.push_back(msg);
+                job = get_job();
+                if (job >= 0) {
+                    sendJob(worker, job);
+                    busy++;
+                }
+            }
+            for (int worker = 1; worker < mpi.getNumProcesses(); worker++)
+                sendJob(worker, -1);
+        } else {
+            int64_t job;
+            do {
+                string msg;
+                mpi.recvString(msg, PROC_MASTER, MF_JOB_TAG);
+                stringstream ss(msg);
+                ss >> job;
+                ss.get();
+                int64_t merged_job;
+                ModelCheckpoint merged_result;
+                while (unpackJobResult(ss, merged_job, merged_result)) {
+                    merge_job(merged_job, merged_result);
+                    merged_result.clear();
+                }
+                if (job < 0)
+                    break;
+                ModelCheckpoint result;
+                run_job(job, result);
+                stringstream out;
+                packJobResult(out, job, result);
+                string str = out.str();
+                mpi.sendString(str, PROC_MASTER, MF_RESULT_TAG);
+            } while (true);
+        }
+        return;
+    }
+#endif
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if(parallel)
+#endif
+    for (int64_t job = 0; job < num_jobs; job++) {
+        ModelCheckpoint result;
+        run_job(job, result);
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+        merge_job(job, result);
+    }
+}
+
 /**
  * k-means clustering of partitions using partition-specific tree length
  * @return score (AIC/BIC/etc.) of the clustering
@@ -1839,6 +1986,9 @@ double doKmeansClustering(Params &params, PhyloSuperTree *in_tree,
             dfsum -= 1;
     }
 
+    // with MPI every worker runs one cluster at a time
+    int cluster_threads = (params.model_test_and_tree || MPIHelper::getInstance().getNumProcesses() > 1) ? num_threads : 1;
+    StrVector set_names;
     for (int cluster = 0; cluster < ncluster; cluster++) {
         string set_name;
         set<int> merged_set;
@@ -1850,63 +2000,79 @@ double doKmeansClustering(Params &params, PhyloSuperTree *in_tree,
                 merged_set.insert(i);
             }
         gene_sets.push_back(merged_set);
-        CandidateModel best_model;
-        bool done_before = false;
+        set_names.push_back(set_name);
+    }
+    model_names.resize(ncluster);
+
+    auto run_cluster = [&](int64_t cluster, ModelCheckpoint &part_model_info) {
+        string &set_name = set_names[cluster];
+        set<int> &merged_set = gene_sets[cluster];
         {
             // if pairs previously examined, reuse the information
+            string best_model_name;
             model_info.startStruct(set_name);
-            if (model_info.getBestModel(best_model.subst_name)) {
-                best_model.restoreCheckpoint(&model_info);
-                done_before = true;
-            }
+            bool done_before = model_info.getBestModel(best_model_name);
             model_info.endStruct();
-        }
-        ModelCheckpoint part_model_info;
-        if (!done_before) {
-            Alignment *aln = super_aln->concatenateAlignments(merged_set);
-            PhyloTree *tree = in_tree->extractSubtree(merged_set);
-            tree->setAlignment(aln);
-            extractModelInfo(set_name, model_info, part_model_info);
-            tree->num_precision = in_tree->num_precision;
-            tree->setParams(&params);
-            tree->sse = params.SSE;
-            tree->optimize_by_newton = params.optimize_by_newton;
-            tree->setNumThreads(params.model_test_and_tree ? num_threads : 1);
-            /*if (params.model_test_and_tree) {
-             tree->setCheckpoint(new Checkpoint());
-             tree->saveCheckpoint();
-             } else*/
-            {
-            tree->setCheckpoint(&part_model_info);
-            // trick to restore checkpoint
-            tree->restoreCheckpoint();
-            tree->saveCheckpoint();
-            }
-            best_model = CandidateModelSet().test(params, tree, part_model_info, models_block,
-                params.model_test_and_tree ? num_threads : 1, params.partition_type,
-                set_name, "", true);
+            if (done_before)
+                return;
+        }
+        Alignment *aln = super_aln->concatenateAlignments(merged_set);
+        PhyloTree *tree = in_tree->extractSubtree(merged_set);
+        tree->setAlignment(aln);
+        extractModelInfo(set_name, model_info, part_model_info);
+        tree->num_precision = in_tree->num_precision;
+        tree->setParams(&params);
+        tree->sse = params.SSE;
+        tree->optimize_by_newton = params.optimize_by_newton;
+        tree->setNumThreads(cluster_threads);
+        /*if (params.model_test_and_tree) {
+         tree->setCheckpoint(new Checkpoint());
+         tree->saveCheckpoint();
+         } else*/
+        {
+        tree->setCheckpoint(&part_model_info);
+        // trick to restore checkpoint
+        tree->restoreCheckpoint();
+        tree->saveCheckpoint();
+        }
+        CandidateModelSet().test(params, tree, part_model_info, models_block,
+            cluster_threads, params.partition_type, set_name, "", true);
+        delete tree;
+        delete aln;
+    };
+
+    auto merge_cluster = [&](int64_t cluster, ModelCheckpoint &part_model_info) {
+        string &set_name = set_names[cluster];
+        CandidateModel best_model;
+        // an empty result means that the cluster was examined before
+        bool done_before = part_model_info.empty();
+        if (done_before) {
+            model_info.startStruct(set_name);
+            model_info.getBestModel(best_model.subst_name);
+            best_model.restoreCheckpoint(&model_info);
+            model_info.endStruct();
+        } else {
+            part_model_info.getBestModel(best_model.subst_name);
             best_model.restoreCheckpoint(&part_model_info);
-            model_names.push_back(best_model.getName());
-            delete tree;
-            delete aln;
         }
+        model_names[cluster] = best_model.getName();
         lhsum += best_model.logl;
         dfsum += best_model.df;
-        {
-            if (!done_before) {
-                replaceModelInfo(set_name, model_info, part_model_info);
-                model_info.dump();
-                cout.width(4);
-                cout << right << cluster+1 << " ";
-                cout.width(12);
-                cout << left << best_model.getName() << " ";
-                cout.width(11);
-                cout << best_model.logl << " " << set_name;
-                cout << endl;
-            }
+        if (!done_before) {
+            replaceModelInfo(set_name, model_info, part_model_info);
+            model_info.dump();
+            cout.width(4);
+            cout << right << cluster+1 << " ";
+            cout.width(12);
+            cout << left << best_model.getName() << " ";
+            cout.width(11);
+            cout << best_model.logl << " " << set_name;
+            cout << endl;
         }
-    }
-    
+    };
+
+    runModelFinderJobs(ncluster, NULL, false, run_cluster, merge_cluster);
+
     size_t ssize = in_tree->getAlnNSite();
     double score = computeInformationScore(lhsum, dfsum, ssize, params.model_test_criterion);
     cout << "k-means score for " << ncluster << " partitions: " << score << " (LnL: " << lhsum << "  " << "df: " << dfsum << ")" << endl;
@@ -2080,6 +2246,8 @@ void testPartitionModel(Params &params, PhyloSuperTree* in_tree, ModelCheckpoint
         std::sort(partitionID.begin(), partitionID.end(), comparePartition);
     }
     bool parallel_over_partitions = false;
+    // with MPI the workers run one subset at a time with all their threads
+    bool distributed = MPIHelper::getInstance().getNumProcesses() > 1;
     int brlen_type = params.partition_type;
     if (brlen_type == TOPO_UNLINKED) {
         brlen_type = BRLEN_OPTIMIZE;
@@ -2087,35 +2255,40 @@ void testPartitionModel(Params &params, PhyloSuperTree* in_tree, ModelCheckpoint
     bool test_merge = (params.partition_merge != MERGE_NONE) && params.partition_type != TOPO_UNLINKED && (in_tree->size() > 1);
     
 #ifdef _OPENMP
-    parallel_over_partitions = !params.model_test_and_tree && (in_tree->size() >= num_threads);
-#pragma omp parallel for private(i) schedule(dynamic) reduction(+: lhsum, dfsum) if(parallel_over_partitions)
+    parallel_over_partitions = !distributed && !params.model_test_and_tree && (in_tree->size() >= num_threads);
 #endif
-	for (int j = 0; j < in_tree->size(); j++) {
-        i = partitionID[j].first;
-        PhyloTree *this_tree = in_tree->at(i);
+    bool merge_phase = test_merge;
+    auto run_partition = [&](int64_t j, ModelCheckpoint &part_model_info) {
+        PhyloTree *this_tree = in_tree->at(partitionID[j].first);
 		// scan through models for this partition, assuming the information occurs consecutively
-		ModelCheckpoint part_model_info;
 		extractModelInfo(this_tree->aln->name, model_info, part_model_info);
 		// do the computation
         string part_model_name;
         if (params.model_name.empty())
             part_model_name = this_tree->aln->model_name;
-        CandidateModel best_model;
-		best_model = CandidateModelSet().test(params, this_tree, part_model_info, models_block,
-            (parallel_over_partitions ? 1 : num_threads), brlen_type, this_tree->aln->name, part_model_name, test_merge);
+		CandidateModelSet().test(params, this_tree, part_model_info, models_block,
+            (parallel_over_partitions ? 1 : num_threads), brlen_type, this_tree->aln->name, part_model_name, merge_phase);
+    };
 
-        bool check = (best_model.restoreCheckpoint(&part_model_info));
+    // merge the best model of a partition, in a critical section
+    auto merge_partition = [&](int64_t j, ModelCheckpoint &part_model_info) {
+        int i = partitionID[j].first;
+        PhyloTree *this_tree = in_tree->at(i);
+        CandidateModel best_model;
+        bool check = part_model_info.getBestModel(best_model.subst_name) && best_model.restoreCheckpoint(&part_model_info);
         ASSERT(check);
+        if (distributed) {
+            // the tree of the partition was only updated by the worker
+            string best_tree;
+            if (part_model_info.getBestTree(best_tree))
+                this_tree->readTreeString(best_tree);
+        }
 
-		double score = best_model.computeICScore(this_tree->getAlnNSite());
 		this_tree->aln->model_name = best_model.getName();
 		lhsum += (lhvec[i] = best_model.logl);
 		dfsum += (dfvec[i] = best_model.df);
         lenvec[i] = best_model.tree_len;
 
-#ifdef _OPENMP
-#pragma omp critical
-#endif
         {
             num_model++;
 //            cout.width(4);
@@ -2139,7 +2312,9 @@ void testPartitionModel(Params &params, PhyloSuperTree* in_tree, ModelCheckpoint
             replaceModelInfo(this_tree->aln->name, model_info, part_model_info);
             model_info.dump();
         }
-    }
+    };
+
+    runModelFinderJobs(in_tree->size(), NULL, parallel_over_partitions, run_partition, merge_partition);
 
     // in case ModelOMatic change the alignment
     fixPartitions(in_tree);
@@ -2227,11 +2402,8 @@ void testPartitionModel(Params &params, PhyloSuperTree* in_tree, ModelCheckpoint
         // progress_display progress(num_pairs, "Calculating subsets");
         // progress.setProgressDisplay(true);
 
-#ifdef _OPENMP
-#pragma omp parallel for private(i) schedule(dynamic) if(!params.model_test_and_tree)
-#endif
-        for (size_t pair = 0; pair < num_pairs; pair++) {
-            // information of current partitions pair
+        // information of a pair of current partitions
+        auto get_pair = [&](int64_t pair) {
             ModelPair cur_pair;
             cur_pair.part1 = closest_pairs[pair].first;
             cur_pair.part2 = closest_pairs[pair].second;
@@ -2239,52 +2411,63 @@ void testPartitionModel(Params &params, PhyloSuperTree* in_tree, ModelCheckpoint
             cur_pair.merged_set.insert(gene_sets[cur_pair.part1].begin(), gene_sets[cur_pair.part1].end());
             cur_pair.merged_set.insert(gene_sets[cur_pair.part2].begin(), gene_sets[cur_pair.part2].end());
             cur_pair.set_name = getSubsetName(in_tree, cur_pair.merged_set);
-            double weight1 = getSubsetAlnLength(in_tree, gene_sets[cur_pair.part1]);
-            double weight2 = getSubsetAlnLength(in_tree, gene_sets[cur_pair.part2]);
-            double sum = 1.0 / (weight1 + weight2);
-            weight1 *= sum;
-            weight2 *= sum;
-            CandidateModel best_model;
+            return cur_pair;
+        };
+        int pair_threads = (params.model_test_and_tree || distributed) ? num_threads : 1;
+
+        auto run_pair = [&](int64_t pair, ModelCheckpoint &part_model_info) {
+            ModelPair cur_pair = get_pair(pair);
             bool done_before = false;
 #ifdef _OPENMP
 #pragma omp critical
 #endif
             {
                 // if pairs previously examined, reuse the information
+                string best_model_name;
                 model_info.startStruct(cur_pair.set_name);
-                if (model_info.getBestModel(best_model.subst_name)) {
-                    best_model.restoreCheckpoint(&model_info);
-                    done_before = true;
-                }
+                done_before = model_info.getBestModel(best_model_name);
                 model_info.endStruct();
             }
-            ModelCheckpoint part_model_info;
-            double cur_tree_len = 0.0;
-            if (!done_before) {
-                Alignment *aln = super_aln->concatenateAlignments(cur_pair.merged_set);
-                PhyloTree *tree = in_tree->extractSubtree(cur_pair.merged_set);
-                //tree->scaleLength((weight1*lenvec[cur_pair.part1] + weight2*lenvec[cur_pair.part2])/tree->treeLength());
-                tree->scaleLength(sqrt(lenvec[cur_pair.part1]*lenvec[cur_pair.part2])/tree->treeLength());
-                cur_tree_len = tree->treeLength();
-                tree->setAlignment(aln);
-                extractModelInfo(cur_pair.set_name, model_info, part_model_info);
-                transferModelParameters(in_tree, model_info, part_model_info, gene_sets[cur_pair.part1], gene_sets[cur_pair.part2]);
-                tree->num_precision = in_tree->num_precision;
-                tree->setParams(&params);
-                tree->sse = params.SSE;
-                tree->optimize_by_newton = params.optimize_by_newton;
-                tree->setNumThreads(params.model_test_and_tree ? num_threads : 1);
-                {
-                    tree->setCheckpoint(&part_model_info);
-                    // trick to restore checkpoint
-                    tree->restoreCheckpoint();
-                    tree->saveCheckpoint();
-                }
-                best_model = CandidateModelSet().test(params, tree, part_model_info, models_block,
-                    params.model_test_and_tree ? num_threads : 1, params.partition_type, cur_pair.set_name, "", true);
+            if (done_before)
+                return;
+            Alignment *aln = super_aln->concatenateAlignments(cur_pair.merged_set);
+            PhyloTree *tree = in_tree->extractSubtree(cur_pair.merged_set);
+            //tree->scaleLength((weight1*lenvec[cur_pair.part1] + weight2*lenvec[cur_pair.part2])/tree->treeLength());
+            tree->scaleLength(sqrt(lenvec[cur_pair.part1]*lenvec[cur_pair.part2])/tree->treeLength());
+            tree->setAlignment(aln);
+            extractModelInfo(cur_pair.set_name, model_info, part_model_info);
+            transferModelParameters(in_tree, model_info, part_model_info, gene_sets[cur_pair.part1], gene_sets[cur_pair.part2]);
+            tree->num_precision = in_tree->num_precision;
+            tree->setParams(&params);
+            tree->sse = params.SSE;
+            tree->optimize_by_newton = params.optimize_by_newton;
+            tree->setNumThreads(pair_threads);
+            {
+                tree->setCheckpoint(&part_model_info);
+                // trick to restore checkpoint
+                tree->restoreCheckpoint();
+                tree->saveCheckpoint();
+            }
+            CandidateModelSet().test(params, tree, part_model_info, models_block,
+                pair_threads, params.partition_type, cur_pair.set_name, "", true);
+            delete tree;
+            delete aln;
+        };
+
+        // merge the best model of a pair, in a critical section
+        auto merge_pair = [&](int64_t pair, ModelCheckpoint &part_model_info) {
+            ModelPair cur_pair = get_pair(pair);
+            CandidateModel best_model;
+            // an empty result means that the pair was examined before
+            bool done_before = part_model_info.empty();
+            if (done_before) {
+                model_info.startStruct(cur_pair.set_name);
+                model_info.getBestModel(best_model.subst_name);
+                best_model.restoreCheckpoint(&model_info);
+                model_info.endStruct();
+            } else {
+                part_model_info.getBestModel(best_model.subst_name);
                 best_model.restoreCheckpoint(&part_model_info);
-                delete tree;
-                delete aln;
             }
             cur_pair.logl = best_model.logl;
             cur_pair.df = best_model.df;
@@ -2293,9 +2476,6 @@ void testPartitionModel(Params &params, PhyloSuperTree* in_tree, ModelCheckpoint
             double lhnew = lhsum - lhvec[cur_pair.part1] - lhvec[cur_pair.part2] + best_model.logl;
             int dfnew = dfsum - dfvec[cur_pair.part1] - dfvec[cur_pair.part2] + best_model.df;
             cur_pair.score = computeInformationScore(lhnew, dfnew, ssize, params.model_test_criterion);
-#ifdef _OPENMP
-#pragma omp critical
-#endif
 			{
 				if (!done_before) {
 					replaceModelInfo(cur_pair.set_name, model_info, part_model_info);
@@ -2325,8 +2505,9 @@ void testPartitionModel(Params &params, PhyloSuperTree* in_tree, ModelCheckpoint
                 if (cur_pair.score < inf_score)
                     better_pairs.insertPair(cur_pair);
 			}
+        };
 
-        }
+        runModelFinderJobs(num_pairs, NULL, !params.model_test_and_tree, run_pair, merge_pair);
 
         // clear the message previous on this line
         // cout << blkStr << "\r" << flush;
@@ -2439,38 +2620,17 @@ void testPartitionModel(Params &params, PhyloSuperTree* in_tree, ModelCheckpoint
         int partition_id = 0;
 
     #ifdef _OPENMP
-        parallel_over_partitions = !params.model_test_and_tree && (in_tree->size() >= num_threads);
-        #pragma omp parallel for private(i) schedule(dynamic) reduction(+: lhsum, dfsum) if(parallel_over_partitions)
+        parallel_over_partitions = !distributed && !params.model_test_and_tree && (in_tree->size() >= num_threads);
     #endif
-        for (int j = 0; j < in_tree->size(); j++) {
-            i = partitionID[j].first;
-            PhyloTree *this_tree = in_tree->at(i);
-            // scan through models for this partition, assuming the information occurs consecutively
-            ModelCheckpoint part_model_info;
-            extractModelInfo(this_tree->aln->name, model_info, part_model_info);
-            // do the computation
-            string part_model_name;
-            if (params.model_name.empty())
-                part_model_name = this_tree->aln->model_name;
+        merge_phase = false;
+        runModelFinderJobs(in_tree->size(), NULL, parallel_over_partitions, run_partition,
+            [&](int64_t j, ModelCheckpoint &part_model_info) {
+            merge_partition(j, part_model_info);
+            PhyloTree *this_tree = in_tree->at(partitionID[j].first);
             CandidateModel best_model;
-            best_model = CandidateModelSet().test(params, this_tree, part_model_info, models_block,
-                (parallel_over_partitions ? 1 : num_threads), brlen_type,
-                this_tree->aln->name, part_model_name, false);
-            
-            bool check = (best_model.restoreCheckpoint(&part_model_info));
-            ASSERT(check);
-            
+            part_model_info.getBestModel(best_model.subst_name);
+            best_model.restoreCheckpoint(&part_model_info);
             double score = best_model.computeICScore(this_tree->getAlnNSite());
-            this_tree->aln->model_name = best_model.getName();
-            lhsum += (lhvec[i] = best_model.logl);
-            dfsum += (dfvec[i] = best_model.df);
-            lenvec[i] = best_model.tree_len;
-            
-    #ifdef _OPENMP
-    #pragma omp critical
-    #endif
-            {
-            num_model++;
             cout.width(4);
             cout << right << ++partition_id << " ";
             cout.width(12);
@@ -2483,10 +2643,7 @@ void testPartitionModel(Params &params, PhyloSuperTree* in_tree, ModelCheckpoint
                 << convert_time(remain_time) << " left)";
             }
             cout << endl;
-            replaceModelInfo(this_tree->aln->name, model_info, part_model_info);
-            model_info.dump();
-            }
-        }
+        });
     }
 
     inf_score = computeInformationScore(lhsum, dfsum, ssize, params.model_test_criterion);
@@ -3042,26 +3199,9 @@ CandidateModel CandidateModelSet::evaluateAll(Params &params, PhyloTree* in_tree
     }
 
     int64_t num_models = size();
-#ifdef _OPENMP
-#pragma omp parallel num_threads(num_threads)
-#endif
-    {
-    int64_t model;
-    do {
-        model = getNextModel();
-        if (model == -1)
-            break;
 
-        // optimize model parameters
-        string orig_model_name = at(model).getName();
-        // keep separate output model_info to only update model_info if better model found
-        ModelCheckpoint out_model_info;
-        at(model).set_name = at(model).aln->name;
-        string tree_string;
-        
-        // main call to estimate model parameters
-        tree_string = at(model).evaluate(params, model_info, out_model_info,
-                                         models_block, num_threads, brlen_type);
+    // update the candidate set after a model was evaluated
+    auto finish_model = [&](int64_t model, ModelCheckpoint &out_model_info) {
         at(model).computeICScores();
         at(model).setFlag(MF_DONE);
         
@@ -3080,9 +3220,6 @@ CandidateModel CandidateModelSet::evaluateAll(Params &params, PhyloTree* in_tree
 #endif
         if (best_score > at(model).getScore()) {
             best_score = at(model).getScore();
-            if (!tree_string.empty()) {
-                //model_info.put("best_tree_" + criterionName(params.model_test_criterion), tree_string);
-            }
             // only update model_info with better model
             model_info.putSubCheckpoint(&out_model_info, "");
         }
@@ -3113,8 +3250,51 @@ CandidateModel CandidateModelSet::evaluateAll(Params &params, PhyloTree* in_tree
 #ifdef _OPENMP
         }
 #endif
+    };
+
+    if (MPIHelper::getInstance().getNumProcesses() > 1) {
+        // the master hands out the models, such that the filters above decide what is evaluated next
+        runModelFinderJobs(num_models, [&]() { return getNextModel(); }, false,
+            [&](int64_t model, ModelCheckpoint &result) {
+            ModelCheckpoint out_model_info;
+            at(model).set_name = at(model).aln->name;
+            at(model).evaluate(params, model_info, out_model_info, models_block, num_threads, brlen_type);
+            result.put("subst_name", at(model).subst_name);
+            result.put("rate_name", at(model).rate_name);
+            at(model).saveCheckpoint(&result);
+            result.putSubCheckpoint(&out_model_info, "model_info");
+        }, [&](int64_t model, ModelCheckpoint &result) {
+            ModelCheckpoint out_model_info;
+            result.getString("subst_name", at(model).subst_name);
+            result.getString("rate_name", at(model).rate_name);
+            at(model).restoreCheckpoint(&result);
+            if (!model_info.hasKey(at(model).getName()))
+                at(model).saveCheckpoint(&model_info);
+            result.getSubCheckpoint(&out_model_info, "model_info");
+            finish_model(model, out_model_info);
+        });
+    } else {
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_threads)
+#endif
+    {
+    int64_t model;
+    do {
+        model = getNextModel();
+        if (model == -1)
+            break;
+
+        // keep separate output model_info to only update model_info if better model found
+        ModelCheckpoint out_model_info;
+        at(model).set_name = at(model).aln->name;
+        
+        // main call to estimate model parameters
+        at(model).evaluate(params, model_info, out_model_info,
+                           models_block, num_threads, brlen_type);
+        finish_model(model, out_model_info);
     } while (model != -1);
     }
+    }
     
     // store the best model
     ModelTestCriterion criteria[] = {MTC_AIC, MTC_AICC, MTC_BIC};
@@ -3277,6 +3457,7 @@ CandidateModel runModelSelection(Params &params, IQTree &iqtree, ModelCheckpoint
     // handling checkpoint file
     model_info.setFileName((string)params.out_prefix + ".model.gz");
     model_info.setDumpInterval(params.checkpoint_dump_interval);
+    model_info.setBinary(params.binary_checkpoint);
     ok_model_file = false;
     if (!params.model_test_again) {
         ok_model_file = model_info.load();
@@ -3285,6 +3466,9 @@ CandidateModel runModelSelection(Params &params, IQTree &iqtree, ModelCheckpoint
     ok_model_file &= model_info.size() > 0;
     if (ok_model_file)
         cout << "NOTE: Restoring information from model checkpoint file " << model_info.getFileName() << endl;
+    // only the master writes the model checkpoint
+    if (MPIHelper::getInstance().isWorker())
+        model_info.setFileName("");
     orig_checkpoint = iqtree.getCheckpoint();
     iqtree.setCheckpoint(&model_info);
     iqtree.restoreCheckpoint();
@@ -795,6 +795,63 @@ int mlecoef(double *cnts, double *rr, double bb, int kk,
 
 /* END CODE WAS TAKEN FROM CONSEL PROGRAM */
 
+/** number of bootstrap replicates scored together against the pattern log-likelihoods of all trees */
+const int TOPOTEST_BOOT_BLOCK = 16;
+
+/** number of patterns of one tile of the RELL product */
+const size_t TOPOTEST_PTN_BLOCK = 1024;
+
+/** number of trees of one tile of the RELL product */
+const int TOPOTEST_TREE_BLOCK = 32;
+
+/**
+    compute the RELL log-likelihoods of all trees for a block of bootstrap replicates.
+    The product is tiled over (patterns x trees), such that every tile of pattern
+    log-likelihoods is reused by all replicates of the block.
+    @param tree tree providing the dot-product kernel
+    @param pattern_lhs pattern log-likelihoods of all trees, stored maxnptn apart and padded with zeros
+    @param ntrees number of trees
+    @param nptn number of patterns
+    @param boot_samples pattern frequencies of the replicates, stored boot_stride apart
+    @param boot_stride distance between two replicates in boot_samples
+    @param nboot number of replicates, at most TOPOTEST_BOOT_BLOCK
+    @param freq buffer of TOPOTEST_BOOT_BLOCK*TOPOTEST_PTN_BLOCK doubles, aligned
+    @param[out] boot_lhs log-likelihood of replicate b under tree t, stored at boot_lhs[b*ntrees+t]
+*/
+void computeRELLBlock(PhyloTree *tree, double *pattern_lhs, size_t ntrees, size_t nptn,
+                      int *boot_samples, size_t boot_stride, int nboot, double *freq, double *boot_lhs) {
+    size_t maxnptn = get_safe_upper_limit(nptn);
+    memset(boot_lhs, 0, sizeof(double)*nboot*ntrees);
+    for (size_t ptn_start = 0; ptn_start < maxnptn; ptn_start += TOPOTEST_PTN_BLOCK) {
+        size_t len = min(TOPOTEST_PTN_BLOCK, maxnptn - ptn_start);
+        size_t nptn_block = (ptn_start < nptn) ? min(len, nptn - ptn_start) : 0;
+        // frequencies of this tile as doubles, padded with zeros
+        for (int boot = 0; boot < nboot; boot++) {
+            int *this_boot_sample = boot_samples + boot*boot_stride + ptn_start;
+            double *this_freq = freq + boot*TOPOTEST_PTN_BLOCK;
+            for (size_t ptn = 0; ptn < nptn_block; ptn++)
+                this_freq[ptn] = this_boot_sample[ptn];
+            for (size_t ptn = nptn_block; ptn < len; ptn++)
+                this_freq[ptn] = 0.0;
+        }
+        for (size_t tree_start = 0; tree_start < ntrees; tree_start += TOPOTEST_TREE_BLOCK) {
+            int ntrees_block = min((size_t)TOPOTEST_TREE_BLOCK, ntrees - tree_start);
+            double *pattern_lh = pattern_lhs + tree_start*maxnptn + ptn_start;
+            for (int boot = 0; boot < nboot; boot++) {
+                double *this_freq = freq + boot*TOPOTEST_PTN_BLOCK;
+                double *res = boot_lhs + boot*ntrees + tree_start;
+                if (tree->sse == LK_386) {
+                    for (int tid = 0; tid < ntrees_block; tid++)
+                        for (size_t ptn = 0; ptn < nptn_block; ptn++)
+                            res[tid] += pattern_lh[tid*maxnptn + ptn] * this_freq[ptn];
+                } else {
+                    (tree->*(tree->dotProductMultiDouble))(this_freq, pattern_lh, maxnptn, ntrees_block, len, res);
+                }
+            }
+        }
+    }
+}
+
 /**
  @param tree_lhs RELL score matrix of size #trees x #replicates
  */
@@ -828,53 +885,51 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
     if (!treelhs)
         outError("Not enough memory to perform AU test!");
     
-    size_t k, tid, ptn;
+    size_t k, tid;
     
     double start_time = getRealTime();
     
     cout << "Generating " << nscales << " x " << nboot << " multiscale bootstrap replicates... ";
     
+    // replicates are generated and scored in blocks, all blocks of all scales are distributed over the threads
+    size_t nblocks = (nboot + TOPOTEST_BOOT_BLOCK - 1) / TOPOTEST_BOOT_BLOCK;
+    int64_t ntasks = nscales * nblocks;
 #ifdef _OPENMP
-#pragma omp parallel private(k, tid, ptn)
+#pragma omp parallel private(k, tid)
     {
     int *rstream;
     init_random(params.ran_seed + omp_get_thread_num(), false, &rstream);
 #else
     int *rstream = randstream;
 #endif
-    size_t boot;
-    int *boot_sample = aligned_alloc<int>(maxnptn);
-    memset(boot_sample, 0, maxnptn*sizeof(int));
-    
-    double *boot_sample_dbl = aligned_alloc<double>(maxnptn);
+    int *boot_samples = aligned_alloc<int>(TOPOTEST_BOOT_BLOCK*maxnptn);
+    memset(boot_samples, 0, TOPOTEST_BOOT_BLOCK*maxnptn*sizeof(int));
+    double *freq = aligned_alloc<double>(TOPOTEST_BOOT_BLOCK*TOPOTEST_PTN_BLOCK);
+    double *boot_lhs = new double[TOPOTEST_BOOT_BLOCK*ntrees];
     
 #ifdef _OPENMP
 #pragma omp for schedule(dynamic)
 #endif
-    for (int k = 0; k < nscales; ++k) {
+    for (int64_t task = 0; task < ntasks; task++) {
+        k = task / nblocks;
+        size_t first = (task % nblocks) * TOPOTEST_BOOT_BLOCK;
+        int nboot_block = min((size_t)TOPOTEST_BOOT_BLOCK, nboot - first);
         string str = "SCALE=" + convertDoubleToString(r[k]);
-        for (boot = 0; boot < nboot; boot++) {
-            if (r[k] == 1.0 && boot == 0)
+        for (int boot = 0; boot < nboot_block; boot++) {
+            if (r[k] == 1.0 && first + boot == 0)
                 // 2018-10-23: get one of the bootstrap sample as the original alignment
-                tree->aln->getPatternFreq(boot_sample);
+                tree->aln->getPatternFreq(boot_samples + boot*maxnptn);
             else
-                tree->aln->createBootstrapAlignment(boot_sample, str.c_str(), rstream);
-            for (ptn = 0; ptn < maxnptn; ptn++)
-                boot_sample_dbl[ptn] = boot_sample[ptn];
+                tree->aln->createBootstrapAlignment(boot_samples + boot*maxnptn, str.c_str(), rstream);
+        }
+        computeRELLBlock(tree, pattern_lhs, ntrees, nptn, boot_samples, maxnptn, nboot_block, freq, boot_lhs);
+        for (int boot = 0; boot < nboot_block; boot++) {
+            double *this_boot_lhs = boot_lhs + boot*ntrees;
             double max_lh = -DBL_MAX, second_max_lh = -DBL_MAX;
             int max_tid = -1;
             for (tid = 0; tid < ntrees; tid++) {
-                double *pattern_lh = pattern_lhs + (tid*maxnptn);
-                double tree_lh;
-                if (params.SSE == LK_386) {
-                    tree_lh = 0.0;
-                    for (ptn = 0; ptn < nptn; ptn++)
-                        tree_lh += pattern_lh[ptn] * boot_sample_dbl[ptn];
-                } else {
-                    tree_lh = tree->dotProductDoubleCall(pattern_lh, boot_sample_dbl, nptn);
-                }
                 // rescale lh
-                tree_lh /= r[k];
+                double tree_lh = this_boot_lhs[tid] / r[k];
                 
                 // find the max and second max
                 if (tree_lh > max_lh) {
@@ -884,27 +939,28 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
                 } else if (tree_lh > second_max_lh)
                     second_max_lh = tree_lh;
                 
-                treelhs[(tid*nscales+k)*nboot + boot] = tree_lh;
+                this_boot_lhs[tid] = tree_lh;
             }
             
             // compute difference from max_lh
             for (tid = 0; tid < ntrees; tid++)
                 if (tid != max_tid)
-                    treelhs[(tid*nscales+k)*nboot + boot] = max_lh - treelhs[(tid*nscales+k)*nboot + boot];
+                    treelhs[(tid*nscales+k)*nboot + first + boot] = max_lh - this_boot_lhs[tid];
                 else
-                    treelhs[(tid*nscales+k)*nboot + boot] = second_max_lh - max_lh;
-            //            bp[k*ntrees+max_tid] += nboot_inv;
+                    treelhs[(tid*nscales+k)*nboot + first + boot] = second_max_lh - max_lh;
         } // for boot
-        
-        // sort the replicates
-        for (tid = 0; tid < ntrees; tid++) {
-            quicksort<double,int>(treelhs + (tid*nscales+k)*nboot, 0, nboot-1);
-        }
-        
-    } // for scale
+    } // for task
     
-    aligned_free(boot_sample_dbl);
-    aligned_free(boot_sample);
+    delete [] boot_lhs;
+    aligned_free(freq);
+    aligned_free(boot_samples);
+    
+    // sort the replicates
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (int64_t id = 0; id < ntrees*nscales; id++)
+        quicksort<double,int>(treelhs + id*nboot, 0, nboot-1);
     
 #ifdef _OPENMP
     finish_random(rstream);
@@ -1067,6 +1123,86 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
 }
 
 
+/** evaluate user trees in parallel if site-level parallelism gives every thread less patterns than this */
+const size_t TOPOTEST_TREE_PARALLEL_PATTERNS = 5000;
+
+/**
+    read the next user tree and prepare it for the likelihood computation
+    @param in input stream
+    @param params program parameters
+    @param tree tree with alignment and model
+*/
+void readUserTree(istream &in, Params &params, PhyloTree *tree) {
+    tree->freeNode();
+    tree->readTree(in, tree->rooted);
+    if (!tree->findNodeName(tree->aln->getSeqName(0))) {
+        outError("Taxon " + tree->aln->getSeqName(0) + " not found in tree");
+    }
+    
+    if (tree->rooted && tree->getModelFactory()->isReversible()) {
+        if (tree->leafNum != tree->aln->getNSeq()+1)
+            outError("Tree does not have same number of taxa as alignment");
+        tree->convertToUnrooted();
+//            cout << "convertToUnrooted" << endl;
+    } else if (!tree->rooted && !tree->getModelFactory()->isReversible()) {
+        if (tree->leafNum != tree->aln->getNSeq())
+            outError("Tree does not have same number of taxa as alignment");
+        tree->convertToRooted();
+//            cout << "convertToRooted" << endl;
+    }
+    tree->setAlignment(tree->aln);
+    tree->setRootNode(params.root);
+    if (tree->isSuperTree())
+        ((PhyloSuperTree*) tree)->mapTrees();
+}
+
+/**
+    optimize the branch lengths (and model parameters with -zo) of a user tree and set its score
+    @param params program parameters
+    @param tree tree read by readUserTree()
+*/
+void optimizeUserTree(Params &params, PhyloTree *tree) {
+    tree->initializeAllPartialLh();
+    tree->fixNegativeBranch(false);
+    if (params.fixed_branch_length) {
+        tree->setCurScore(tree->computeLikelihood());
+    } else if (params.topotest_optimize_model) {
+        tree->getModelFactory()->optimizeParameters(BRLEN_OPTIMIZE, false, params.modelEps);
+        tree->setCurScore(tree->computeLikelihood());
+    } else {
+        tree->setCurScore(tree->optimizeAllBranches(100, 0.001));
+    }
+}
+
+/**
+    decide whether user trees are evaluated one by one with all threads working on the patterns,
+    or whole trees are distributed over the threads
+    @param params program parameters
+    @param tree tree with alignment and model
+    @param ntrees number of trees to evaluate
+    @return number of threads evaluating trees in parallel, 1 to evaluate trees one by one
+*/
+int getNumTreeWorkers(Params &params, IQTree *tree, size_t ntrees) {
+#ifdef _OPENMP
+    size_t num_threads = max(tree->num_threads, 1);
+    if (num_threads <= 1 || ntrees < 2)
+        return 1;
+    // the workers share the model, which must therefore stay fixed and not depend on the tree
+    if (tree->isSuperTree() || tree->isMixlen() || tree->isTreeMix() ||
+        params.topotest_optimize_model || tree->getModel()->isSiteSpecificModel())
+        return 1;
+    if (tree->getAlnNPattern() >= num_threads * TOPOTEST_TREE_PARALLEL_PATTERNS)
+        return 1;
+    num_threads = min(num_threads, ntrees);
+    // every worker holds the partial likelihoods of a whole tree
+    if (num_threads * tree->getMemoryRequired() > getMemorySize() / 2)
+        return 1;
+    return num_threads;
+#else
+    return 1;
+#endif
+}
+
 void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &info, IntVector &distinct_ids)
 {
     cout << endl;
@@ -1118,20 +1254,20 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
     int *boot_samples = NULL;
     //double *saved_tree_lhs = NULL;
     double *tree_lhs = NULL; // RELL score matrix of size #trees x #replicates
-    double *pattern_lh = NULL;
-    double *pattern_lhs = NULL;
+    double *pattern_lhs = NULL; // pattern log-likelihoods of all trees
     double *orig_tree_lh = NULL; // Original tree log-likelihoods
     double *max_lh = NULL;
     double *lhdiff_weights = NULL;
     size_t nptn = tree->getAlnNPattern();
     size_t maxnptn = get_safe_upper_limit(nptn);
+    int num_workers = getNumTreeWorkers(params, tree, ntrees);
     
     if (params.topotest_replicates && ntrees > 1) {
         size_t mem_size = (size_t)params.topotest_replicates*nptn*sizeof(int) +
         ntrees*params.topotest_replicates*sizeof(double) +
-        (nptn + ntrees*3 + params.topotest_replicates*2)*sizeof(double) +
-        ntrees*sizeof(TreeInfo) +
-        params.do_weighted_test*(ntrees * nptn * sizeof(double) + ntrees*ntrees*sizeof(double));
+        (ntrees*3 + params.topotest_replicates*2)*sizeof(double) +
+        ntrees*sizeof(TreeInfo) + ntrees * maxnptn * sizeof(double) +
+        params.do_weighted_test*ntrees*ntrees*sizeof(double);
         cout << "Note: " << ((double)mem_size/1024)/1024 << " MB of RAM required!" << endl;
         if (mem_size > getMemorySize()-100000)
             outWarning("The required memory does not fit in RAM!");
@@ -1164,22 +1300,85 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
         if (params.do_weighted_test || params.do_au_test) {
             if (!(lhdiff_weights = new double [ntrees * ntrees]))
                 outError(ERR_NO_MEMORY);
-            pattern_lhs = aligned_alloc<double>(ntrees*maxnptn);
-            //            if (!(pattern_lhs = new double[ntrees* nptn]))
-            //                outError(ERR_NO_MEMORY);
         }
-        pattern_lh = aligned_alloc<double>(maxnptn);
-        //        if (!(pattern_lh = new double[nptn]))
-        //            outError(ERR_NO_MEMORY);
+        // RELL scores of all trees are computed at once from the pattern log-likelihoods
+        pattern_lhs = aligned_alloc<double>(ntrees*maxnptn);
         if (!(orig_tree_lh = new double[ntrees]))
             outError(ERR_NO_MEMORY);
         if (!(max_lh = new double[params.topotest_replicates]))
             outError(ERR_NO_MEMORY);
+    } else if (num_workers > 1 && params.print_site_lh) {
+        pattern_lhs = aligned_alloc<double>(ntrees*maxnptn);
     }
     int tree_index, tid, tid2;
     info.resize(ntrees);
     string saved_tree;
     saved_tree = tree->getTreeString();
+    
+    // tree strings of the trees evaluated in parallel and the number format printTree() left in their stream
+    StrVector tree_outputs;
+    vector<pair<ios::fmtflags, streamsize> > tree_formats;
+    if (num_workers > 1) {
+        cout << "Evaluating " << ntrees << " trees in parallel by " << num_workers << " threads" << endl;
+        // check all trees in the input order, the workers then parse their tree strings again
+        string tree_text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        istringstream scan_in(tree_text);
+        StrVector tree_strings;
+        BoolVector tree_rooted;
+        for (tree_index = 0; tree_index < distinct_ids.size(); tree_index++) {
+            if (distinct_ids[tree_index] >= 0) {
+                char ch;
+                do {
+                    scan_in >> ch;
+                } while (!scan_in.eof() && ch != ';');
+                continue;
+            }
+            tree_rooted.push_back(tree->rooted);
+            size_t tree_start = scan_in.tellg();
+            readUserTree(scan_in, params, tree);
+            size_t tree_end = scan_in.good() ? (size_t)scan_in.tellg() : tree_text.length();
+            tree_strings.push_back(tree_text.substr(tree_start, tree_end - tree_start));
+        }
+        ASSERT(tree_strings.size() == ntrees);
+        tree_outputs.resize(ntrees);
+        tree_formats.resize(ntrees);
+        
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_workers)
+#endif
+        {
+        // every worker owns a tree sharing the alignment and model, which are not changed
+        PhyloTree *worker = new PhyloTree(tree->aln);
+        worker->setParams(&params);
+        worker->optimize_by_newton = params.optimize_by_newton;
+        worker->setLikelihoodKernel(params.SSE);
+        worker->setNumThreads(1);
+        worker->setModelFactory(tree->getModelFactory());
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int id = 0; id < ntrees; id++) {
+            istringstream tree_in(tree_strings[id]);
+            worker->rooted = tree_rooted[id];
+            readUserTree(tree_in, params, worker);
+            optimizeUserTree(params, worker);
+            ostringstream ostr;
+            worker->printTree(ostr);
+            tree_outputs[id] = ostr.str();
+            tree_formats[id] = make_pair(ostr.flags(), ostr.precision());
+            info[id].logl = worker->getCurScore();
+            if (pattern_lhs) {
+                double curScore = worker->getCurScore();
+                memset(pattern_lhs + id*maxnptn, 0, maxnptn*sizeof(double));
+                worker->computePatternLikelihood(pattern_lhs + id*maxnptn, &curScore);
+            }
+        }
+        // reset model so that it is not deleted
+        worker->setModelFactory(NULL);
+        delete worker;
+        }
+    }
+    
     //for (MTreeSet::iterator it = trees.begin(); it != trees.end(); it++, tree_index++) {
     for (tree_index = 0, tid = 0; tree_index < distinct_ids.size(); tree_index++) {
         
@@ -1187,59 +1386,37 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
         if (distinct_ids[tree_index] >= 0) {
             cout << " / identical to tree " << distinct_ids[tree_index]+1 << endl;
             // ignore tree
+            if (num_workers > 1)
+                continue;
             char ch;
             do {
                 in >> ch;
             } while (!in.eof() && ch != ';');
             continue;
         }
-        tree->freeNode();
-        tree->readTree(in, tree->rooted);
-        if (!tree->findNodeName(tree->aln->getSeqName(0))) {
-            outError("Taxon " + tree->aln->getSeqName(0) + " not found in tree");
-        }
-        
-        if (tree->rooted && tree->getModelFactory()->isReversible()) {
-            if (tree->leafNum != tree->aln->getNSeq()+1)
-                outError("Tree does not have same number of taxa as alignment");
-            tree->convertToUnrooted();
-//            cout << "convertToUnrooted" << endl;
-        } else if (!tree->rooted && !tree->getModelFactory()->isReversible()) {
-            if (tree->leafNum != tree->aln->getNSeq())
-                outError("Tree does not have same number of taxa as alignment");
-            tree->convertToRooted();
-//            cout << "convertToRooted" << endl;
-        }
-        tree->setAlignment(tree->aln);
-        tree->setRootNode(params.root);
-        if (tree->isSuperTree())
-            ((PhyloSuperTree*) tree)->mapTrees();
-        
-        tree->initializeAllPartialLh();
-        tree->fixNegativeBranch(false);
-        if (params.fixed_branch_length) {
-            tree->setCurScore(tree->computeLikelihood());
-        } else if (params.topotest_optimize_model) {
-            tree->getModelFactory()->optimizeParameters(BRLEN_OPTIMIZE, false, params.modelEps);
-            tree->setCurScore(tree->computeLikelihood());
+        double *pattern_lh = pattern_lhs ? pattern_lhs + tid*maxnptn : NULL;
+        if (num_workers > 1) {
+            treeout << "[ tree " << tree_index+1 << " lh=" << info[tid].logl << " ]" << tree_outputs[tid] << endl;
+            treeout.flags(tree_formats[tid].first);
+            treeout.precision(tree_formats[tid].second);
         } else {
-            tree->setCurScore(tree->optimizeAllBranches(100, 0.001));
+            readUserTree(in, params, tree);
+            optimizeUserTree(params, tree);
+            info[tid].logl = tree->getCurScore();
+            treeout << "[ tree " << tree_index+1 << " lh=" << tree->getCurScore() << " ]";
+            tree->printTree(treeout);
+            treeout << endl;
+            if (pattern_lh) {
+                double curScore = tree->getCurScore();
+                memset(pattern_lh, 0, maxnptn*sizeof(double));
+                tree->computePatternLikelihood(pattern_lh, &curScore);
+            }
         }
-        treeout << "[ tree " << tree_index+1 << " lh=" << tree->getCurScore() << " ]";
-        tree->printTree(treeout);
-        treeout << endl;
         if (params.print_tree_lh)
-            scoreout << tree->getCurScore() << endl;
+            scoreout << info[tid].logl << endl;
         
-        cout << " / LogL: " << tree->getCurScore() << endl;
+        cout << " / LogL: " << info[tid].logl << endl;
         
-        if (pattern_lh) {
-            double curScore = tree->getCurScore();
-            memset(pattern_lh, 0, maxnptn*sizeof(double));
-            tree->computePatternLikelihood(pattern_lh, &curScore);
-            if (params.do_weighted_test || params.do_au_test)
-                memcpy(pattern_lhs + tid*maxnptn, pattern_lh, maxnptn*sizeof(double));
-        }
         if (params.print_site_lh) {
             string tree_name = "Tree" + convertIntToString(tree_index+1);
             printSiteLh(site_lh_file.c_str(), tree, pattern_lh, true, tree_name.c_str());
@@ -1248,28 +1425,40 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
             string tree_name = "Tree" + convertIntToString(tree_index+1);
             printPartitionLh(part_lh_file.c_str(), tree, pattern_lh, true, tree_name.c_str());
         }
-        info[tid].logl = tree->getCurScore();
         
-        if (!params.topotest_replicates || ntrees <= 1) {
-            tid++;
-            continue;
-        }
-        // now compute RELL scores
-        orig_tree_lh[tid] = tree->getCurScore();
-        double *tree_lhs_offset = tree_lhs + (tid*params.topotest_replicates);
-        for (size_t boot = 0; boot < params.topotest_replicates; boot++) {
-            double lh = 0.0;
-            int *this_boot_sample = boot_samples + (boot*nptn);
-            for (size_t ptn = 0; ptn < nptn; ptn++)
-                lh += pattern_lh[ptn] * this_boot_sample[ptn];
-            tree_lhs_offset[boot] = lh;
-        }
+        if (params.topotest_replicates && ntrees > 1)
+            orig_tree_lh[tid] = info[tid].logl;
         tid++;
     }
     
     ASSERT(tid == ntrees);
     
     if (params.topotest_replicates && ntrees > 1) {
+        // now compute RELL scores of all trees, blocked over (trees x replicates)
+        size_t nboot = params.topotest_replicates;
+        size_t nblocks = (nboot + TOPOTEST_BOOT_BLOCK - 1) / TOPOTEST_BOOT_BLOCK;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(max(tree->num_threads, 1))
+#endif
+        {
+        double *freq = aligned_alloc<double>(TOPOTEST_BOOT_BLOCK*TOPOTEST_PTN_BLOCK);
+        double *boot_lhs = new double[TOPOTEST_BOOT_BLOCK*ntrees];
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int64_t block = 0; block < nblocks; block++) {
+            size_t first = block * TOPOTEST_BOOT_BLOCK;
+            int nboot_block = min((size_t)TOPOTEST_BOOT_BLOCK, nboot - first);
+            computeRELLBlock(tree, pattern_lhs, ntrees, nptn, boot_samples + first*nptn, nptn,
+                             nboot_block, freq, boot_lhs);
+            for (int boot = 0; boot < nboot_block; boot++)
+                for (size_t id = 0; id < ntrees; id++)
+                    tree_lhs[id*nboot + first + boot] = boot_lhs[boot*ntrees + id];
+        }
+        delete [] boot_lhs;
+        aligned_free(freq);
+        }
+        
         double *tree_probs = new double[ntrees];
         memset(tree_probs, 0, ntrees*sizeof(double));
         int *tree_ranks = new int[ntrees];
@@ -1487,7 +1676,6 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
     }
     delete [] max_lh;
     delete [] orig_tree_lh;
-    aligned_free(pattern_lh);
     aligned_free(pattern_lhs);
     delete [] lhdiff_weights;
     delete [] tree_lhs;
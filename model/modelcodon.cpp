@@ -822,6 +822,11 @@ void ModelCodon::decomposeRateMatrix() {
     ModelMarkov::decomposeRateMatrix();
 }
 
+bool ModelCodon::computeNormalizedRateMatrix(double *q_mat, double *freq) {
+    computeCodonRateMatrix();
+    return ModelMarkov::computeNormalizedRateMatrix(q_mat, freq);
+}
+
 void ModelCodon::computeCodonRateMatrix() {
 //    if (num_params == 0) 
 //        return; // do nothing for empirical codon model
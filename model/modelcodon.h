@@ -93,6 +93,14 @@ public:
 	*/
 	virtual void decomposeRateMatrix();
 
+	/**
+		compute the codon rate matrix from kappa and omega, then the normalized rate matrix
+		@param[out] q_mat rate matrix of size num_states*num_states
+		@param[out] freq state frequencies summing to 1
+		@return FALSE for non-reversible models
+	*/
+	virtual bool computeNormalizedRateMatrix(double *q_mat, double *freq);
+
 	/**
 	 * read codon model from a stream, modying rates and state_freq accordingly
 	 * @param in input stream containing lower triangular matrix of rates, frequencies and list of codons
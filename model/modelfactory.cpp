@@ -131,7 +131,7 @@ ModelFactory::ModelFactory() : CheckpointFactory() {
     model = NULL;
     site_rate = NULL;
     store_trans_matrix = false;
-    is_storing = false;
+    is_storing = true;
     joint_optimize = false;
     fused_mix_rate = false;
     ASC_type = ASC_NONE;
@@ -150,7 +150,7 @@ size_t findCloseBracket(string &str, size_t start_pos) {
 
 ModelFactory::ModelFactory(Params &params, string &model_name, PhyloTree *tree, ModelsBlock *models_block) : CheckpointFactory() {
     store_trans_matrix = params.store_trans_matrix;
-    is_storing = false;
+    is_storing = true;
     joint_optimize = params.optimize_model_rate_joint;
     fused_mix_rate = false;
     ASC_type = ASC_NONE;
@@ -1052,6 +1052,11 @@ double ModelFactory::initGTRGammaIParameters(RateHeterogeneity *rate, ModelSubst
 
 double ModelFactory::optimizeParametersOnly(int num_steps, double gradient_epsilon, double cur_logl) {
     double logl;
+    // numerical derivatives w.r.t. model parameters need double-precision likelihoods
+    PhyloTree *tree = site_rate->getTree();
+    bool suspend_float_lh = tree && getNDim() > 0;
+    if (suspend_float_lh)
+        tree->suspendMixedPrecision(true);
     /* Optimize substitution and heterogeneity rates independently */
     if (!joint_optimize) {
         // more steps for fused mix rate model
@@ -1083,6 +1088,8 @@ double ModelFactory::optimizeParametersOnly(int num_steps, double gradient_epsil
         /* Optimize substitution and heterogeneity rates jointly using BFGS */
         logl = optimizeAllParameters(gradient_epsilon);
     }
+    if (suspend_float_lh)
+        tree->suspendMixedPrecision(false);
     return logl;
 }
 
@@ -1337,7 +1344,6 @@ double ModelFactory::optimizeParameters(int fixed_len, bool write_info,
     PhyloTree *tree = site_rate->getTree();
     ASSERT(tree);
 
-    stopStoringTransMatrix();
     // modified by Thomas Wong on Sept 11, 15
     // no optimization of branch length in the first round
     double optimizeStartTime = getRealTime();
@@ -1471,7 +1477,6 @@ double ModelFactory::optimizeParameters(int fixed_len, bool write_info,
     double elapsed_secs = getRealTime() - begin_time;
     if (write_info)
         cout << "Parameters optimization took " << i-1 << " rounds (" << elapsed_secs << " sec)" << endl;
-    startStoringTransMatrix();
 
     // For UpperBounds -----------
     tree->mlCheck = 1;
@@ -1497,11 +1502,6 @@ void ModelFactory::startStoringTransMatrix() {
 void ModelFactory::stopStoringTransMatrix() {
     if (!store_trans_matrix) return;
     is_storing = false;
-    if (!empty()) {
-        for (iterator it = begin(); it != end(); it++)
-            delete it->second;
-        clear();
-    }
 }
 
 
@@ -1514,24 +1514,17 @@ double ModelFactory::computeTrans(double time, int state1, int state2, double &d
 }
 
 void ModelFactory::computeTransMatrix(double time, double *trans_matrix, int mixture, int selected_row) {
-    if (!store_trans_matrix || !is_storing || model->isSiteSpecificModel()) {
+    if (!store_trans_matrix || !is_storing || selected_row >= 0 || model->isSiteSpecificModel()) {
         model->computeTransMatrix(time, trans_matrix, mixture, selected_row);
         return;
     }
-    int mat_size = model->num_states * model->num_states;
-    iterator ass_it = find(round(time * 1e6));
-    if (ass_it == end()) {
-        // allocate memory for 3 matricies
-        double *trans_entry = new double[mat_size * 3];
-        trans_entry[mat_size] = trans_entry[mat_size+1] = 0.0;
-        model->computeTransMatrix(time, trans_entry, mixture, selected_row);
-        ass_it = insert(value_type(round(time * 1e6), trans_entry)).first;
-    } else {
-        //if (verbose_mode >= VB_MAX)
-            //cout << "ModelFactory bingo" << endl;
-    }
-
-    memcpy(trans_matrix, ass_it->second, mat_size * sizeof(double));
+    size_t mat_size = model->num_states * model->num_states;
+    // the version changes with every eigen-decomposition, so stale entries are never hit
+    uint64_t version = model->getTransMatrixVersion();
+    if (trans_cache.lookup(version, mixture, time, mat_size, trans_matrix))
+        return;
+    model->computeTransMatrix(time, trans_matrix, mixture, selected_row);
+    trans_cache.insert(version, mixture, time, mat_size, trans_matrix);
 }
 
 void ModelFactory::computeTransDerv(double time, double *trans_matrix,
@@ -1540,28 +1533,21 @@ void ModelFactory::computeTransDerv(double time, double *trans_matrix,
         model->computeTransDerv(time, trans_matrix, trans_derv1, trans_derv2, mixture);
         return;
     }
-    int mat_size = model->num_states * model->num_states;
-    iterator ass_it = find(round(time * 1e6));
-    if (ass_it == end()) {
-        // allocate memory for 3 matricies
-        double *trans_entry = new double[mat_size * 3];
-        trans_entry[mat_size] = trans_entry[mat_size+1] = 0.0;
-        model->computeTransDerv(time, trans_entry, trans_entry+mat_size, trans_entry+(mat_size*2), mixture);
-        ass_it = insert(value_type(round(time * 1e6), trans_entry)).first;
-    } else if (ass_it->second[mat_size] == 0.0 && ass_it->second[mat_size+1] == 0.0) {
-        double *trans_entry = ass_it->second;
-        model->computeTransDerv(time, trans_entry, trans_entry+mat_size, trans_entry+(mat_size*2), mixture);
-    }
-    memcpy(trans_matrix, ass_it->second, mat_size * sizeof(double));
-    memcpy(trans_derv1, ass_it->second + mat_size, mat_size * sizeof(double));
-    memcpy(trans_derv2, ass_it->second + (mat_size*2), mat_size * sizeof(double));
+    size_t mat_size = model->num_states * model->num_states;
+    uint64_t version = model->getTransMatrixVersion();
+    if (trans_cache.lookup(version, mixture, time, mat_size, trans_matrix, trans_derv1, trans_derv2))
+        return;
+    model->computeTransDerv(time, trans_matrix, trans_derv1, trans_derv2, mixture);
+    trans_cache.insert(version, mixture, time, mat_size, trans_matrix, trans_derv1, trans_derv2);
 }
 
 ModelFactory::~ModelFactory()
 {
-    for (iterator it = begin(); it != end(); it++)
-        delete it->second;
-    clear();
+    uint64_t hits = trans_cache.getHits(), misses = trans_cache.getMisses();
+    if (verbose_mode >= VB_MED && hits + misses > 0)
+        cout << "Transition matrix cache: " << hits << " hits, " << misses << " misses ("
+             << (100.0 * hits / (hits + misses)) << "% hit rate, "
+             << trans_cache.getCapacity() << " entries)" << endl;
 }
 
 /************* FOLLOWING SERVE FOR JOINT OPTIMIZATION OF MODEL AND RATE PARAMETERS *******/
@@ -1579,6 +1565,17 @@ double ModelFactory::targetFunk(double x[]) {
     return site_rate->targetFunk(x + model->getNDim());
 }
 
+double ModelFactory::derivativeFunk(double x[], double dfx[]) {
+    PhyloTree *tree = site_rate->phylo_tree;
+    if (!tree || tree->getModelFactory() != this || !tree->isModelGradientSupported())
+        return Optimization::derivativeFunk(x, dfx);
+    double fx = targetFunk(x);
+    if (fx >= 1.0e+12)
+        return Optimization::derivativeFunk(x, dfx);
+    tree->computeModelGradient(getNDim(), x, dfx, [this](double *v) { getVariables(v); });
+    return fx;
+}
+
 void ModelFactory::setVariables(double *variables) {
     model->setVariables(variables);
     site_rate->setVariables(variables + model->getNDim());
@@ -23,6 +23,7 @@
 #include "utils/tools.h"
 #include "modelsubst.h"
 #include "rateheterogeneity.h"
+#include "transmatrixcache.h"
 #include "nclextra/modelsblock.h"
 #include "utils/checkpoint.h"
 #include "alignment/alignment.h"
@@ -56,11 +57,11 @@ string::size_type posPOMO(string &model_name);
 /**
 Store the transition matrix corresponding to evolutionary time so that one must not compute again. 
 For efficiency purpose esp. for protein (20x20) or codon (61x61).
-The values of the map contain 3 matricies consecutively: transition matrix, 1st, and 2nd derivative
+The matrices and their derivatives are kept in a TransMatrixCache keyed by the model version.
 
 	@author BUI Quang Minh <minh.bui@univie.ac.at>
 */
-class ModelFactory : public unordered_map<int, double*>, public Optimization, public CheckpointFactory
+class ModelFactory : public Optimization, public CheckpointFactory
 {
 public:
 
@@ -117,12 +118,12 @@ public:
     }
     
 	/**
-		Start to store transition matrix for efficiency
+		Resume storing transition matrix for efficiency
 	*/
 	void startStoringTransMatrix();
 
 	/**
-		Stop storing transition matrix, e.g., when optimizing model parameters
+		Pause storing transition matrix, e.g., while the matrices are computed for rates that are not reused
 	*/
 	void stopStoringTransMatrix();
 
@@ -220,7 +221,7 @@ public:
 	bool fused_mix_rate;
 
 	/**
-		TRUE to store transition matrix into this hash table for computation efficiency
+		TRUE to store transition matrix into trans_cache for computation efficiency
 	*/
 	bool store_trans_matrix;
 
@@ -228,6 +229,11 @@ public:
 		TRUE for storing process
 	*/
 	bool is_storing;
+
+	/**
+		cache of transition matrices, shared by all threads
+	*/
+	TransMatrixCache trans_cache;
     
     /**
         TRUE for continuous Gamma
@@ -272,6 +278,15 @@ public:
 	*/
 	virtual double targetFunk(double x[]);
 
+	/**
+		the derivative function, computed analytically if supported by the tree,
+		otherwise by finite differences
+		@param x the input vector x
+		@param dfx the derivative at x
+		@return the function value at x
+	*/
+	virtual double derivativeFunk(double x[], double dfx[]);
+
 	double initGTRGammaIParameters(RateHeterogeneity *rate, ModelSubst *model, double initAlpha,
 								 double initPInvar, double *initRates, double *initStateFreqs);
 
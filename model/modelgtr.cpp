@@ -607,6 +607,8 @@ double ModelGTR::optimizeParameters(double gradient_epsilon) {
 void ModelGTR::decomposeRateMatrix(){
 	int i, j, k = 0;
 
+	updateTransMatrixVersion();
+
 	if (num_params == -1) {
 		// manual compute eigenvalues/vectors for F81-style model
 		eigenvalues[0] = 0.0;
@@ -878,10 +880,12 @@ double* ModelGTR::getInverseEigenvectors() const {
 void ModelGTR::setEigenvalues(double *eigenvalues)
 {
     this->eigenvalues = eigenvalues;
+    updateTransMatrixVersion();
 }
 
 void ModelGTR::setEigenvectors(double *eigenvectors)
 {
     this->eigenvectors = eigenvectors;
+    updateTransMatrixVersion();
 }
 
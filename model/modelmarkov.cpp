@@ -961,6 +961,44 @@ void ModelMarkov::getQMatrix(double *q_mat, int mixture) {
 
 }
 
+bool ModelMarkov::computeNormalizedRateMatrix(double *q_mat, double *freq) {
+    // F81-style models are decomposed in closed form with unnormalized frequencies
+    if (!is_reversible || num_params == -1)
+        return false;
+    int i, j, k;
+    double sum = 0.0;
+    for (i = 0; i < num_states; i++)
+        sum += state_freq[i];
+    for (i = 0; i < num_states; i++)
+        freq[i] = state_freq[i] / sum;
+
+    // same rate matrix as in decomposeRateMatrixRev()
+    double **rate_matrix = new double*[num_states];
+    for (i = 0; i < num_states; i++)
+        rate_matrix[i] = new double[num_states];
+    if (half_matrix) {
+        for (i = 0, k = 0; i < num_states; i++) {
+            rate_matrix[i][i] = 0.0;
+            for (j = i+1; j < num_states; j++, k++) {
+                rate_matrix[i][j] = (state_freq[i] <= ZERO_FREQ || state_freq[j] <= ZERO_FREQ) ? 0 : rates[k];
+                rate_matrix[j][i] = rate_matrix[i][j];
+            }
+        }
+    } else {
+        for (i = 0; i < num_states; i++) {
+            memcpy(rate_matrix[i], &rates[i*num_states], num_states*sizeof(double));
+            rate_matrix[i][i] = 0.0;
+        }
+    }
+    computeRateMatrix(rate_matrix, freq, num_states);
+    for (i = 0; i < num_states; i++)
+        memcpy(q_mat + (i*num_states), rate_matrix[i], num_states * sizeof(double));
+    for (i = num_states-1; i >= 0; i--)
+        delete [] rate_matrix[i];
+    delete [] rate_matrix;
+    return true;
+}
+
 int ModelMarkov::getNDim() { 
 	ASSERT(freq_type != FREQ_UNKNOWN);
 	if (fixed_parameters)
@@ -1117,6 +1155,16 @@ double ModelMarkov::targetFunk(double x[]) {
 
 }
 
+double ModelMarkov::derivativeFunk(double x[], double dfx[]) {
+    if (!phylo_tree || phylo_tree->getModel() != this || !phylo_tree->isModelGradientSupported())
+        return Optimization::derivativeFunk(x, dfx);
+    double fx = targetFunk(x);
+    if (fx >= 1.0e+12)
+        return Optimization::derivativeFunk(x, dfx);
+    phylo_tree->computeModelGradient(getNDim(), x, dfx, [this](double *v) { getVariables(v); });
+    return fx;
+}
+
 bool ModelMarkov::isUnstableParameters() {
 	int nrates = getNumRateEntries();
 	int i;
@@ -1389,6 +1437,8 @@ void ModelMarkov::decomposeRateMatrixNonrev() {
 void ModelMarkov::decomposeRateMatrix(){
 	int i, j, k = 0;
 
+    updateTransMatrixVersion();
+
     if (!is_reversible) {
         decomposeRateMatrixNonrev();
         return;
@@ -1925,21 +1975,25 @@ double* ModelMarkov::getInverseEigenvectorsTransposed() const {
 void ModelMarkov::setEigenvalues(double *eigenValues)
 {
     this->eigenvalues = eigenValues;
+    updateTransMatrixVersion();
 }
 
 void ModelMarkov::setEigenvectors(double *eigenVectors)
 {
     this->eigenvectors = eigenVectors;
+    updateTransMatrixVersion();
 }
 
 void ModelMarkov::setInverseEigenvectors(double *eigenV)
 {
     this->inv_eigenvectors = eigenV;
+    updateTransMatrixVersion();
 }
 
 void ModelMarkov::setInverseEigenvectorsTransposed(double *eigenVTranspose)
 {
     this->inv_eigenvectors_transposed = eigenVTranspose;
+    updateTransMatrixVersion();
 }
 
 /****************************************************/
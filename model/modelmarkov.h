@@ -259,6 +259,15 @@ public:
 	 */
 	virtual void getQMatrix(double *q_mat, int mixture = 0);
 
+	/**
+		compute the normalized rate matrix and state frequencies from the current parameters,
+		as used by decomposeRateMatrix() for reversible models
+		@param[out] q_mat rate matrix of size num_states*num_states
+		@param[out] freq state frequencies summing to 1
+		@return FALSE for non-reversible models
+	*/
+	virtual bool computeNormalizedRateMatrix(double *q_mat, double *freq);
+
 	/**
 		rescale the state frequencies
 		@param sum_one TRUE to make frequencies sum to 1, FALSE to make last entry equal to 1
@@ -303,6 +312,15 @@ public:
 	*/
 	virtual double targetFunk(double x[]);
 
+	/**
+		the derivative function, computed analytically from the eigen decomposition
+		if supported by the tree, otherwise by finite differences
+		@param x the input vector x
+		@param dfx the derivative at x
+		@return the function value at x
+	*/
+	virtual double derivativeFunk(double x[], double dfx[]);
+
 	/**
 	 * setup the bounds for joint optimization with BFGS
 	 */
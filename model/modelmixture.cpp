@@ -1794,6 +1794,14 @@ void ModelMixture::getQMatrix(double *q_mat, int mixture)
     at(mixture)->getQMatrix(q_mat);
 }
 
+bool ModelMixture::computeNormalizedRateMatrix(double *q_mat, double *freq) {
+    size_t nstates = num_states;
+    for (size_t m = 0; m < size(); m++)
+        if (!at(m)->computeNormalizedRateMatrix(q_mat + m*nstates*nstates, freq + m*nstates))
+            return false;
+    return true;
+}
+
 void ModelMixture::computeTransDerv(double time, double *trans_matrix,
     double *trans_derv1, double *trans_derv2, int mixture) {
     ASSERT(mixture < getNMixtures());
@@ -2364,6 +2372,14 @@ void ModelMixture::decomposeRateMatrix() {
 		(*it)->decomposeRateMatrix();
 }
 
+uint64_t ModelMixture::getTransMatrixVersion() {
+    // versions increase, so the maximum changes whenever any class changes
+    uint64_t version = trans_matrix_version;
+    for (iterator it = begin(); it != end(); it++)
+        version = max(version, (*it)->getTransMatrixVersion());
+    return version;
+}
+
 // added case for gtr optimization -JD
 void ModelMixture::setVariables(double *variables) {
 	int dim = 0;
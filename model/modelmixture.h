@@ -164,6 +164,14 @@ public:
     */
     virtual void getQMatrix(double *q_mat, int mixture = 0);
 
+	/**
+		compute the normalized rate matrices and state frequencies of all mixture classes
+		@param[out] q_mat rate matrices, of size getNMixtures()*num_states*num_states
+		@param[out] freq state frequencies, of size getNMixtures()*num_states
+		@return FALSE if not supported by one of the classes
+	*/
+	virtual bool computeNormalizedRateMatrix(double *q_mat, double *freq);
+
 
 	/**
 		compute the transition probability matrix.and the derivative 1 and 2
@@ -245,6 +253,11 @@ public:
 	*/
 	virtual void decomposeRateMatrix();
 
+	/**
+		@return the latest version of the mixture classes
+	*/
+	virtual uint64_t getTransMatrixVersion();
+
 	/**
 	 * setup the bounds for joint optimization with BFGS
 	 */
@@ -167,6 +167,12 @@ class ModelPoMo : virtual public ModelMarkov
     */
     virtual double targetFunk(double x[]);
 
+    /**
+     *  PoMo rate matrices are not built from exchangeabilities, so analytic
+     *  gradients are not supported
+     */
+    virtual bool computeNormalizedRateMatrix(double *q_mat, double *freq) { return false; }
+
     /**
      *  @return TRUE if parameters are at the boundary that may cause
      *  numerical unstability
@@ -89,6 +89,11 @@ public:
 	*/
 	virtual double targetFunk(double x[]);
 
+    /**
+     * analytic gradients are not supported for PoMo
+     */
+    virtual bool computeNormalizedRateMatrix(double *q_mat, double *freq) { return false; }
+
     /**
      * @return TRUE if parameters are at the boundary that may cause
      * numerical unstability
@@ -11,9 +11,14 @@
 //
 #include "modelsubst.h"
 #include "utils/tools.h"
+#include <atomic>
+
+/** last version given to a model */
+static std::atomic<uint64_t> last_trans_matrix_version(0);
 
 ModelSubst::ModelSubst(int nstates) : Optimization(), CheckpointFactory()
 {
+    updateTransMatrixVersion();
 	num_states = nstates;
 	name = "JC";
 	full_name = "JC (Juke and Cantor, 1969)";
@@ -57,6 +62,10 @@ void ModelSubst::restoreCheckpoint() {
     decomposeRateMatrix();
 }
 
+void ModelSubst::updateTransMatrixVersion() {
+    trans_matrix_version = ++last_trans_matrix_version;
+}
+
 // here the simplest Juke-Cantor model is implemented, valid for all kind of data (DNA, AA,...)
 void ModelSubst::computeTransMatrix(double time, double *trans_matrix, int mixture, int selected_row) {
 	double non_diagonal = (1.0 - exp(-time*num_states/(num_states - 1))) / num_states;
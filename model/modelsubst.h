@@ -262,6 +262,16 @@ public:
 	*/
 	virtual void getQMatrix(double *q_mat, int mixture = 0);
 
+	/**
+		compute the normalized rate matrices and state frequencies of all mixture classes
+		from the current parameters, exactly as they enter the eigen decomposition,
+		but without decomposing them. Used for analytic gradients of model parameters.
+		@param[out] q_mat rate matrices, of size getNMixtures()*num_states*num_states
+		@param[out] freq state frequencies summing to 1, of size getNMixtures()*num_states
+		@return FALSE if not supported by the model
+	*/
+	virtual bool computeNormalizedRateMatrix(double *q_mat, double *freq) { return false; }
+
 	/**
 		compute the state frequency vector. One should override this function when defining new model.
 		The default is equal state sequency, valid for all kind of data.
@@ -325,6 +335,17 @@ public:
 	*/
 	virtual void decomposeRateMatrix() {}
 
+	/**
+		@return a number that changes whenever the transition matrices of the model change,
+		used as key of the transition matrix cache of ModelFactory
+	*/
+	virtual uint64_t getTransMatrixVersion() { return trans_matrix_version; }
+
+	/**
+		give the model a new version, must be called after changing the eigen-decomposition
+	*/
+	void updateTransMatrixVersion();
+
 
     /** 
         set number of optimization steps
@@ -453,6 +474,11 @@ public:
 
 protected:
 
+	/**
+		version of the transition matrices, unique among all models
+	*/
+	uint64_t trans_matrix_version;
+
 	/**
 		this function is served for the multi-dimension optimization. It should pack the model parameters
 		into a vector that is index from 1 (NOTE: not from 0)
@@ -33,7 +33,7 @@ PartitionModel::PartitionModel(Params &params, PhyloSuperTree *tree, ModelsBlock
         : ModelFactory()
 {
 	store_trans_matrix = params.store_trans_matrix;
-	is_storing = false;
+	is_storing = true;
 	joint_optimize = params.optimize_model_rate_joint;
 	fused_mix_rate = false;
     linked_alpha = -1.0;
@@ -248,17 +248,12 @@ int PartitionModel::getNParameters(int brlen_type) {
 double PartitionModel::computeFunction(double shape) {
     PhyloSuperTree *tree = (PhyloSuperTree*)site_rate->getTree();
     double res = 0.0;
-    int ntrees = tree->size();
     linked_alpha = shape;
-    if (tree->part_order.empty()) tree->computePartitionOrder();
-#ifdef _OPENMP
-#pragma omp parallel for reduction(+: res) schedule(dynamic) if(tree->num_threads > 1)
-#endif
-    for (int j = 0; j < ntrees; j++) {
-        int i = tree->part_order[j];
+    res = tree->forEachPartition([&](int i) -> double {
         if (tree->at(i)->getRate()->isGammaRate())
-            res += tree->at(i)->getRate()->computeFunction(shape);
-    }
+            return tree->at(i)->getRate()->computeFunction(shape);
+        return 0.0;
+    });
     if (res == 0.0) {
         outError("No partition has Gamma rate heterogeneity!");
     }
@@ -290,20 +285,15 @@ double PartitionModel::targetFunk(double x[]) {
     PhyloSuperTree *tree = (PhyloSuperTree*)site_rate->getTree();
     
     double res = 0;
-    int ntrees = tree->size();
-    if (tree->part_order.empty()) tree->computePartitionOrder();
-#ifdef _OPENMP
-#pragma omp parallel for reduction(+: res) schedule(dynamic) if(tree->num_threads > 1)
-#endif
-    for (int j = 0; j < ntrees; j++) {
-        int i = tree->part_order[j];
+    res = tree->forEachPartition([&](int i) -> double {
         ModelSubst *part_model = tree->at(i)->getModel();
         if (part_model->getName() != model->getName())
-            continue;
+            return 0.0;
         bool fixed = part_model->fixParameters(false);
-        res += part_model->targetFunk(x);
+        double part_res = part_model->targetFunk(x);
         part_model->fixParameters(fixed);
-    }
+        return part_res;
+    });
     if (res == 0.0)
         outError("No partition has model ", model->getName());
     return res;
@@ -463,13 +453,7 @@ double PartitionModel::optimizeParameters(int fixed_len, bool write_info, double
     int ntrees = tree->size();
 
     for (int step = 0; step < Params::getInstance().model_opt_steps; step++) {
-        tree_lh = 0.0;
-        if (tree->part_order.empty()) tree->computePartitionOrder();
-        #ifdef _OPENMP
-        #pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) if(tree->num_threads > 1)
-        #endif
-        for (int i = 0; i < ntrees; i++) {
-            int part = tree->part_order[i];
+        tree_lh = tree->forEachPartition([&](int part) -> double {
             double score;
             if (opt_gamma_invar)
                 score = tree->at(part)->getModelFactory()->optimizeParametersGammaInvar(fixed_len,
@@ -479,7 +463,6 @@ double PartitionModel::optimizeParameters(int fixed_len, bool write_info, double
                 score = tree->at(part)->getModelFactory()->optimizeParameters(fixed_len,
                     write_info && verbose_mode >= VB_MED,
                     logl_epsilon/min(ntrees,10), gradient_epsilon/min(ntrees,10));
-            tree_lh += score;
             if (write_info)
 #ifdef _OPENMP
 #pragma omp critical
@@ -490,7 +473,8 @@ double PartitionModel::optimizeParameters(int fixed_len, bool write_info, double
                      << " / df: " << tree->at(part)->getModelFactory()->getNParameters(fixed_len)
                 << " / LogL: " << score << endl;
             }
-        }
+            return score;
+        });
         //return ModelFactory::optimizeParameters(fixed_len, write_info);
 
         if (!isLinkedModel())
@@ -80,3 +80,13 @@ void RateHeterogeneity::writeSiteRates(const char *file_name) {
 double RateHeterogeneity::targetFunk(double x[]) {
 	return -phylo_tree->computeLikelihood();
 }
+
+double RateHeterogeneity::derivativeFunk(double x[], double dfx[]) {
+    if (!phylo_tree || phylo_tree->getRate() != this || !phylo_tree->isModelGradientSupported())
+        return Optimization::derivativeFunk(x, dfx);
+    double fx = targetFunk(x);
+    if (fx >= 1.0e+12)
+        return Optimization::derivativeFunk(x, dfx);
+    phylo_tree->computeModelGradient(getNDim(), x, dfx, [this](double *v) { getVariables(v); });
+    return fx;
+}
@@ -251,6 +251,15 @@ public:
 	*/
 	virtual double targetFunk(double x[]);
 
+	/**
+		the derivative function, computed analytically if supported by the tree,
+		otherwise by finite differences
+		@param x the input vector x
+		@param dfx the derivative at x
+		@return the function value at x
+	*/
+	virtual double derivativeFunk(double x[], double dfx[]);
+
 	/**
 	 * setup the bounds for joint optimization with BFGS
 	 */
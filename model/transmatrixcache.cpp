@@ -0,0 +1,150 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "transmatrixcache.h"
+#include <string.h>
+
+TransMatrixCache::TransMatrixCache() : arena(NULL), lookups(0), hits(0) {
+    slots = NULL;
+    mat_size = 0;
+    num_sets = 0;
+}
+
+TransMatrixCache::~TransMatrixCache() {
+    delete [] arena.load();
+    delete [] slots;
+}
+
+size_t TransMatrixCache::getSet(uint64_t version, uint64_t time_bits, int64_t kind) {
+    uint64_t h = time_bits * 0x9E3779B97F4A7C15ULL;
+    h ^= (version + (uint64_t)kind * 0xC2B2AE3D27D4EB4FULL) * 0x165667B19E3779F9ULL;
+    h ^= h >> 29;
+    return (h & (num_sets - 1)) * TRANS_CACHE_WAYS;
+}
+
+bool TransMatrixCache::lookup(uint64_t version, int mixture, double time, size_t mat_size,
+                              double *trans_matrix, double *trans_derv1, double *trans_derv2) {
+    uint64_t tick = lookups.fetch_add(1, std::memory_order_relaxed);
+    double *data = arena.load(std::memory_order_acquire);
+    if (!data || mat_size != this->mat_size)
+        return false;
+    uint64_t time_bits;
+    memcpy(&time_bits, &time, sizeof(time));
+    int64_t kind = (int64_t)mixture * 2 + (trans_derv1 ? 1 : 0);
+    size_t first = getSet(version, time_bits, kind);
+    for (size_t i = first; i < first + TRANS_CACHE_WAYS; i++) {
+        TransMatrixSlot &slot = slots[i];
+        uint32_t seq = slot.seq.load(std::memory_order_acquire);
+        if ((seq & 1) || slot.version.load(std::memory_order_relaxed) != version ||
+            slot.time_bits.load(std::memory_order_relaxed) != time_bits ||
+            slot.kind.load(std::memory_order_relaxed) != kind)
+            continue;
+        double *entry = data + i * 3 * mat_size;
+        memcpy(trans_matrix, entry, mat_size * sizeof(double));
+        if (trans_derv1) {
+            memcpy(trans_derv1, entry + mat_size, mat_size * sizeof(double));
+            memcpy(trans_derv2, entry + 2*mat_size, mat_size * sizeof(double));
+        }
+        // the entry may have been replaced while copying
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq)
+            return false;
+        slot.last_used.store(tick, std::memory_order_relaxed);
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void TransMatrixCache::insert(uint64_t version, int mixture, double time, size_t mat_size,
+                              const double *trans_matrix, const double *trans_derv1, const double *trans_derv2) {
+    std::lock_guard<std::mutex> guard(write_lock);
+    double *data = arena.load(std::memory_order_relaxed);
+    if (!data) {
+        // size the arena for the first matrix size seen
+        size_t entry_bytes = 3 * mat_size * sizeof(double);
+        size_t num_entries = TRANS_CACHE_MAX_BYTES / entry_bytes;
+        if (num_entries > TRANS_CACHE_MAX_ENTRIES)
+            num_entries = TRANS_CACHE_MAX_ENTRIES;
+        num_sets = 1;
+        while (num_sets * 2 * TRANS_CACHE_WAYS <= num_entries)
+            num_sets *= 2;
+        this->mat_size = mat_size;
+        slots = new TransMatrixSlot[num_sets * TRANS_CACHE_WAYS];
+        for (size_t i = 0; i < num_sets * TRANS_CACHE_WAYS; i++) {
+            slots[i].seq.store(0, std::memory_order_relaxed);
+            slots[i].version.store(0, std::memory_order_relaxed);
+            slots[i].time_bits.store(0, std::memory_order_relaxed);
+            slots[i].kind.store(0, std::memory_order_relaxed);
+            slots[i].last_used.store(0, std::memory_order_relaxed);
+        }
+        data = new double[num_sets * TRANS_CACHE_WAYS * 3 * mat_size];
+        arena.store(data, std::memory_order_release);
+    }
+    if (mat_size != this->mat_size)
+        return;
+    uint64_t time_bits;
+    memcpy(&time_bits, &time, sizeof(time));
+    int64_t kind = (int64_t)mixture * 2 + (trans_derv1 ? 1 : 0);
+    size_t first = getSet(version, time_bits, kind);
+
+    // take the same key inserted by another thread, an empty entry or the least recently used one
+    size_t victim = first;
+    for (size_t i = first; i < first + TRANS_CACHE_WAYS; i++) {
+        TransMatrixSlot &slot = slots[i];
+        uint64_t slot_version = slot.version.load(std::memory_order_relaxed);
+        if (slot_version == version && slot.time_bits.load(std::memory_order_relaxed) == time_bits &&
+            slot.kind.load(std::memory_order_relaxed) == kind)
+            return;
+        if (slot_version == 0) {
+            victim = i;
+            break;
+        }
+        if (slot.last_used.load(std::memory_order_relaxed) < slots[victim].last_used.load(std::memory_order_relaxed))
+            victim = i;
+    }
+
+    TransMatrixSlot &slot = slots[victim];
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.version.store(version, std::memory_order_relaxed);
+    slot.time_bits.store(time_bits, std::memory_order_relaxed);
+    slot.kind.store(kind, std::memory_order_relaxed);
+    slot.last_used.store(lookups.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    double *entry = data + victim * 3 * mat_size;
+    memcpy(entry, trans_matrix, mat_size * sizeof(double));
+    if (trans_derv1) {
+        memcpy(entry + mat_size, trans_derv1, mat_size * sizeof(double));
+        memcpy(entry + 2*mat_size, trans_derv2, mat_size * sizeof(double));
+    }
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+void TransMatrixCache::clear() {
+    std::lock_guard<std::mutex> guard(write_lock);
+    if (!slots)
+        return;
+    for (size_t i = 0; i < num_sets * TRANS_CACHE_WAYS; i++) {
+        slots[i].version.store(0, std::memory_order_relaxed);
+        slots[i].last_used.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,147 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef TRANSMATRIXCACHE_H
+#define TRANSMATRIXCACHE_H
+
+#include <atomic>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+
+/** number of entries per set of the transition matrix cache */
+const size_t TRANS_CACHE_WAYS = 8;
+
+/** maximum number of entries of the transition matrix cache */
+const size_t TRANS_CACHE_MAX_ENTRIES = 4096;
+
+/** maximum memory of the transition matrix cache in bytes */
+const size_t TRANS_CACHE_MAX_BYTES = 16 << 20;
+
+/**
+    an entry of the transition matrix cache.
+    The key fields are only valid if seq is even and unchanged after reading them (seqlock).
+*/
+struct TransMatrixSlot {
+    /** odd while the entry is being written */
+    std::atomic<uint32_t> seq;
+
+    /** version of the model, 0 for an empty entry */
+    std::atomic<uint64_t> version;
+
+    /** bits of the evolutionary time */
+    std::atomic<uint64_t> time_bits;
+
+    /** mixture class * 2 + 1 if the entry also holds the derivatives */
+    std::atomic<int64_t> kind;
+
+    /** lookup counter at the last use, for LRU replacement */
+    std::atomic<uint64_t> last_used;
+};
+
+/**
+    Cache of transition probability matrices P(t) and their derivatives, shared by all threads.
+    An entry is keyed by the version of the model (see ModelSubst::getTransMatrixVersion()),
+    the mixture class, the exact evolutionary time and whether the derivatives are stored,
+    so that a hit returns exactly what the model would compute. A new eigen-decomposition
+    changes the model version, such that old entries are never hit and age out.
+    The entries are kept in one arena allocated at the first insertion and organized
+    as a set-associative cache with LRU replacement within each set.
+    Lookups are lock-free; insertions are serialized by a mutex.
+*/
+class TransMatrixCache {
+public:
+
+    TransMatrixCache();
+
+    ~TransMatrixCache();
+
+    /**
+        look up a transition matrix
+        @param version model version
+        @param mixture mixture class
+        @param time evolutionary time
+        @param mat_size number of entries of a matrix
+        @param[out] trans_matrix transition matrix
+        @param[out] trans_derv1 1st derivative, NULL to look up the matrix alone
+        @param[out] trans_derv2 2nd derivative, NULL to look up the matrix alone
+        @return TRUE if found, FALSE otherwise (the output is then undefined)
+    */
+    bool lookup(uint64_t version, int mixture, double time, size_t mat_size,
+                double *trans_matrix, double *trans_derv1 = NULL, double *trans_derv2 = NULL);
+
+    /**
+        store a transition matrix, replacing the least recently used entry of its set
+        @param version model version
+        @param mixture mixture class
+        @param time evolutionary time
+        @param mat_size number of entries of a matrix
+        @param trans_matrix transition matrix
+        @param trans_derv1 1st derivative, NULL to store the matrix alone
+        @param trans_derv2 2nd derivative, NULL to store the matrix alone
+    */
+    void insert(uint64_t version, int mixture, double time, size_t mat_size,
+                const double *trans_matrix, const double *trans_derv1 = NULL, const double *trans_derv2 = NULL);
+
+    /**
+        remove all entries, must not be called concurrently with lookup()
+    */
+    void clear();
+
+    /** @return number of successful lookups */
+    uint64_t getHits() { return hits.load(std::memory_order_relaxed); }
+
+    /** @return number of failed lookups */
+    uint64_t getMisses() { return lookups.load(std::memory_order_relaxed) - getHits(); }
+
+    /** @return number of entries, 0 before the first insertion */
+    size_t getCapacity() { return num_sets * TRANS_CACHE_WAYS; }
+
+protected:
+
+    /**
+        @return first entry of the set of a key
+    */
+    size_t getSet(uint64_t version, uint64_t time_bits, int64_t kind);
+
+    /** all entries */
+    TransMatrixSlot *slots;
+
+    /** matrices of all entries, (3*mat_size) doubles per entry */
+    std::atomic<double*> arena;
+
+    /** number of entries of a matrix, fixed at the first insertion */
+    size_t mat_size;
+
+    /** number of sets, a power of 2 */
+    size_t num_sets;
+
+    /** number of lookups */
+    std::atomic<uint64_t> lookups;
+
+    /** number of successful lookups */
+    std::atomic<uint64_t> hits;
+
+    /** serializes the writers */
+    std::mutex write_lock;
+};
+
+#endif // TRANSMATRIXCACHE_H
@@ -0,0 +1,51 @@
+#!/bin/bash -
+#===============================================================================
+#
+#          FILE: bench_mixture_kernel.sh
+#
+#         USAGE: ./bench_mixture_kernel.sh <iqtree_binary> [<ntaxa> <nsites> <model>]
+#
+#   DESCRIPTION: time the partial likelihood kernel of a profile mixture model
+#                with and without class blocking (--mix-block) and single-precision
+#                partial likelihoods (--mixed-precision). An alignment is simulated
+#                with AliSim, branch lengths and model parameters are then
+#                optimized on the true tree, which is dominated by the kernel.
+#
+#       OPTIONS: ntaxa (default 24), nsites (default 2000), model (default LG+C60+G4)
+#  REQUIREMENTS: iqtree2 with AliSim
+#         NOTES: all runs must report the same log-likelihood
+#===============================================================================
+
+set -o nounset                              # Treat unset variables as an error
+
+if [ "$#" -lt 1 ]
+then
+    echo "USAGE: $0 <iqtree_binary> [<ntaxa> <nsites> <model>]" >&2
+    exit 1
+fi
+
+iqtree=$1
+ntaxa=${2:-24}
+nsites=${3:-2000}
+model=${4:-LG+C60+G4}
+outDir=bench_mixture_kernel
+
+mkdir -p ${outDir}
+echo "Simulating ${ntaxa} taxa x ${nsites} sites under ${model}"
+${iqtree} --alisim ${outDir}/sim -m "${model}" -t "RANDOM{yh/${ntaxa}}" --length ${nsites} \
+    -seed 1 -redo > ${outDir}/sim.out 2>&1 || { echo "Simulation failed, see ${outDir}/sim.out"; exit 1; }
+
+run() {
+    name=$1
+    shift
+    start=$(date +%s.%N)
+    ${iqtree} -s ${outDir}/sim.phy -te ${outDir}/sim.treefile -m "${model}" -nt 1 -seed 1 -redo \
+        -pre ${outDir}/${name} "$@" > ${outDir}/${name}.out 2>&1
+    end=$(date +%s.%N)
+    logl=$(grep "BEST SCORE FOUND" ${outDir}/${name}.out | awk '{print $5}')
+    printf "%-24s %10.2f sec   logL %s\n" "${name}" $(echo "${end} ${start}" | awk '{print $1-$2}') "${logl}"
+}
+
+run unblocked --mix-block 0
+run blocked
+run blocked_float --mixed-precision
@@ -0,0 +1,100 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "phylotree.h"
+#include "bootsamples.h"
+
+BootSampleMatrix::BootSampleMatrix() {
+    nsamples = 0;
+    nptn = 0;
+    stride = 0;
+    freq16 = NULL;
+    freq32 = NULL;
+}
+
+BootSampleMatrix::~BootSampleMatrix() {
+    clear();
+}
+
+void BootSampleMatrix::init(int num_samples, size_t num_patterns) {
+    clear();
+    nsamples = num_samples;
+    nptn = num_patterns;
+    stride = get_safe_upper_limit_float(num_patterns);
+    size_t total = stride * nsamples;
+    freq16 = aligned_alloc<uint16_t>(total);
+    memset(freq16, 0, total*sizeof(uint16_t));
+}
+
+void BootSampleMatrix::clear() {
+    if (freq16)
+        aligned_free(freq16);
+    if (freq32)
+        aligned_free(freq32);
+    freq16 = NULL;
+    freq32 = NULL;
+    nsamples = 0;
+    nptn = 0;
+    stride = 0;
+}
+
+void BootSampleMatrix::widen() {
+    ASSERT(freq16 && !freq32);
+    size_t total = stride * nsamples;
+    freq32 = aligned_alloc<uint32_t>(total);
+    for (size_t i = 0; i < total; i++)
+        freq32[i] = freq16[i];
+    aligned_free(freq16);
+    freq16 = NULL;
+}
+
+void BootSampleMatrix::setSample(int sample, IntVector &freq) {
+    ASSERT(sample >= 0 && sample < nsamples);
+    ASSERT(freq.size() >= nptn);
+    if (freq16) {
+        for (size_t ptn = 0; ptn < nptn; ptn++)
+            if (freq[ptn] > UINT16_MAX) {
+                widen();
+                break;
+            }
+    }
+    if (freq16) {
+        uint16_t *row = freq16 + sample*stride;
+        for (size_t ptn = 0; ptn < nptn; ptn++)
+            row[ptn] = freq[ptn];
+    } else {
+        uint32_t *row = freq32 + sample*stride;
+        for (size_t ptn = 0; ptn < nptn; ptn++)
+            row[ptn] = freq[ptn];
+    }
+}
+
+void BootSampleMatrix::getBlock(int sample, size_t start, size_t len, BootValType *out) const {
+    if (freq16) {
+        uint16_t *row = freq16 + sample*stride + start;
+        for (size_t i = 0; i < len; i++)
+            out[i] = row[i];
+    } else {
+        uint32_t *row = freq32 + sample*stride + start;
+        for (size_t i = 0; i < len; i++)
+            out[i] = row[i];
+    }
+}
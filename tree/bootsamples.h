@@ -0,0 +1,103 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef BOOTSAMPLES_H
+#define BOOTSAMPLES_H
+
+#ifndef PHYLOTREE_H
+#error "Please #include phylotree.h before including this header file"
+#endif
+
+/**
+    pattern frequencies of ultrafast bootstrap replicates, stored as a dense
+    (replicates x patterns) matrix in row-major order. Frequencies are kept as
+    16-bit integers and widened to 32-bit only if some frequency does not fit.
+    Rows are padded with zeros up to get_safe_upper_limit_float(#patterns).
+*/
+class BootSampleMatrix {
+public:
+
+    BootSampleMatrix();
+
+    ~BootSampleMatrix();
+
+    /**
+        allocate the matrix with all frequencies set to 0
+        @param num_samples number of bootstrap replicates
+        @param num_patterns number of alignment patterns
+    */
+    void init(int num_samples, size_t num_patterns);
+
+    /** free the memory */
+    void clear();
+
+    /** @return number of bootstrap replicates */
+    size_t size() const { return nsamples; }
+
+    /** @return true if no replicate was allocated */
+    bool empty() const { return nsamples == 0; }
+
+    /** @return padded length of each row */
+    size_t getStride() const { return stride; }
+
+    /**
+        set pattern frequencies of one replicate
+        @param sample replicate index
+        @param freq pattern frequencies as returned by Alignment::createBootstrapAlignment
+    */
+    void setSample(int sample, IntVector &freq);
+
+    /** @return frequency of pattern ptn in replicate sample */
+    int getFreq(int sample, size_t ptn) const {
+        return (freq16) ? freq16[sample*stride + ptn] : freq32[sample*stride + ptn];
+    }
+
+    /**
+        convert a block of frequencies of one replicate to BootValType
+        @param sample replicate index
+        @param start first pattern of the block
+        @param len number of patterns in the block
+        @param[out] out output array of len elements
+    */
+    void getBlock(int sample, size_t start, size_t len, BootValType *out) const;
+
+protected:
+
+    /** widen the storage to 32-bit integers */
+    void widen();
+
+    /** number of replicates */
+    int nsamples;
+
+    /** number of patterns */
+    size_t nptn;
+
+    /** padded row length */
+    size_t stride;
+
+    /** 16-bit frequencies, NULL after widen() */
+    uint16_t *freq16;
+
+    /** 32-bit frequencies, only allocated if some frequency exceeds 65535 */
+    uint32_t *freq32;
+};
+
+#endif // BOOTSAMPLES_H
@@ -238,7 +238,7 @@ int CandidateSet::update(string newTree, double newScore) {
     }
     CandidateTree candidate;
     candidate.score = newScore;
-    candidate.topology = convertTreeString(newTree);
+    candidate.topology = getTopologyKey(newTree);
     candidate.tree = newTree;
 
     int treePos;
@@ -324,7 +324,134 @@ string CandidateSet::getTopology(string tree) {
     return ostr.str();
 }
 
-double CandidateSet::getTopologyScore(string topology) {
+/** finalizer of splitmix64, to scramble 64-bit hashes */
+static inline uint64_t mixTopologyBits(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/** 128-bit hash of a taxon name */
+static TopologyKey hashTaxonName(const char *name, size_t len) {
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (unsigned char)name[i]) * 0x100000001b3ULL;
+    TopologyKey key;
+    key.lo = mixTopologyBits(h);
+    key.hi = mixTopologyBits(h + 0x9e3779b97f4a7c15ULL);
+    return key;
+}
+
+TopologyKey CandidateSet::getTopologyKey(const string &tree) {
+    // a clade: sum of taxon hashes and number of taxa
+    struct Clade {
+        TopologyKey sum;
+        int ntaxa;
+        int nchildren;
+        Clade() : ntaxa(0), nchildren(0) {}
+        void add(const TopologyKey &key, int n) {
+            sum.lo += key.lo;
+            sum.hi += key.hi;
+            ntaxa += n;
+            nchildren++;
+        }
+    };
+    const char *delim = ",():;[ \t\r\n";
+    vector<Clade> stack;
+    vector<Clade> clades; // all inner clades except the outermost one
+    size_t last_top_clade = string::npos; // last inner clade directly below the outermost one
+    Clade top;
+    bool has_root_leaf = false;
+    bool after_close = false; // a name after ')' is an internal node label
+    size_t pos = 0, len = tree.length();
+    while (pos < len && tree[pos] != ';') {
+        char c = tree[pos];
+        if (c == '(') {
+            stack.push_back(Clade());
+            after_close = false;
+            pos++;
+        } else if (c == ')') {
+            if (stack.empty())
+                outError("Invalid tree in candidate set: ", tree);
+            Clade clade = stack.back();
+            stack.pop_back();
+            if (stack.empty()) {
+                top = clade;
+            } else {
+                if (stack.size() == 1)
+                    last_top_clade = clades.size();
+                clades.push_back(clade);
+                stack.back().add(clade.sum, clade.ntaxa);
+            }
+            after_close = true;
+            pos++;
+        } else if (c == ',') {
+            after_close = false;
+            pos++;
+        } else if (c == '[') {
+            // skip comment
+            pos = tree.find(']', pos);
+            if (pos != string::npos)
+                pos++;
+        } else if (c == ':') {
+            // skip branch length
+            pos = tree.find_first_of(delim, pos+1);
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            pos++;
+        } else {
+            size_t start = pos, end;
+            if (c == '\'') {
+                start = pos+1;
+                end = tree.find('\'', start);
+                if (end == string::npos)
+                    outError("Invalid tree in candidate set: ", tree);
+                pos = end+1;
+            } else {
+                end = pos = min(tree.find_first_of(delim, pos), len);
+            }
+            if (!after_close) {
+                if (stack.empty())
+                    outError("Invalid tree in candidate set: ", tree);
+                if (tree.compare(start, end-start, ROOT_NAME) == 0)
+                    has_root_leaf = true;
+                stack.back().add(hashTaxonName(tree.c_str() + start, end-start), 1);
+            }
+        }
+    }
+    if (!stack.empty())
+        outError("Invalid tree in candidate set: ", tree);
+
+    if (top.nchildren == 2 && last_top_clade != string::npos) {
+        if (Params::getInstance().is_rooted) {
+            // root of a rooted tree is an extra taxon
+            if (!has_root_leaf)
+                top.add(hashTaxonName(ROOT_NAME, strlen(ROOT_NAME)), 1);
+        } else {
+            // both sides of a bifurcating root are the same split
+            clades.erase(clades.begin() + last_top_clade);
+        }
+    }
+
+    TopologyKey key;
+    for (auto &clade : clades) {
+        if (clade.ntaxa <= 1 || clade.ntaxa >= top.ntaxa-1)
+            continue;
+        // take the smaller hash of the two sides of the split
+        TopologyKey other;
+        other.lo = top.sum.lo - clade.sum.lo;
+        other.hi = top.sum.hi - clade.sum.hi;
+        TopologyKey split = (clade.sum < other) ? clade.sum : other;
+        key.lo += mixTopologyBits(split.lo ^ mixTopologyBits(split.hi));
+        key.hi += mixTopologyBits(split.hi + mixTopologyBits(split.lo + 0x9e3779b97f4a7c15ULL));
+    }
+    return key;
+}
+
+double CandidateSet::getTopologyScore(const TopologyKey &topology) {
     ASSERT(topologies.find(topology) != topologies.end());
     return topologies[topology];
 }
@@ -364,15 +491,15 @@ void CandidateSet::getAllTrees(vector<string> &trees, vector<double> &scores, in
     }
 }
 
-bool CandidateSet::treeTopologyExist(string topo) {
+bool CandidateSet::treeTopologyExist(const TopologyKey &topo) {
     return (topologies.find(topo) != topologies.end());
 }
 
 bool CandidateSet::treeExist(string tree) {
-    return treeTopologyExist(convertTreeString(tree));
+    return treeTopologyExist(getTopologyKey(tree));
 }
 
-CandidateSet::iterator CandidateSet::getCandidateTree(string topology) {
+CandidateSet::iterator CandidateSet::getCandidateTree(const TopologyKey &topology) {
     for (CandidateSet::reverse_iterator rit = rbegin(); rit != rend(); rit++) {
         if (rit->second.topology == topology)
             return --(rit.base());
@@ -380,7 +507,7 @@ CandidateSet::iterator CandidateSet::getCandidateTree(string topology) {
     return end();
 }
 
-void CandidateSet::removeCandidateTree(string topology) {
+void CandidateSet::removeCandidateTree(const TopologyKey &topology) {
     bool removed = false;
     double treeScore;
     // Find the score of the topology
@@ -501,7 +628,7 @@ void CandidateSet::printTrees(string suffix) {
     outLHs.precision(15);
     for (reverse_iterator rit = rbegin(); rit != rend(); rit++) {
         outLHs << rit->first << endl;
-        outTrees << rit->second.topology << endl;
+        outTrees << convertTreeString(rit->second.tree) << endl;
     }
     outTrees.close();
     outLHs.close();
@@ -32,6 +32,38 @@
 
 class IQTree;
 
+/**
+ * 128-bit key of an unrooted tree topology, computed from the set of its splits.
+ * Each split is hashed from the taxon names on either side (taking the smaller
+ * of the two side hashes, so the key does not depend on the rooting) and
+ * the split hashes are summed, so the key does not depend on the order of
+ * subtrees either. Two topologies are considered identical if their keys are equal.
+ */
+struct TopologyKey {
+    uint64_t lo, hi;
+
+    TopologyKey() : lo(0), hi(0) {}
+
+    bool operator==(const TopologyKey &other) const {
+        return lo == other.lo && hi == other.hi;
+    }
+
+    bool operator<(const TopologyKey &other) const {
+        return (hi < other.hi) || (hi == other.hi && lo < other.lo);
+    }
+};
+
+#ifdef USE_HASH_MAP
+struct hashTopologyKey {
+    size_t operator()(const TopologyKey &key) const {
+        return key.lo;
+    }
+};
+typedef unordered_map<TopologyKey, double, hashTopologyKey> TopologyDoubleMap;
+#else
+typedef map<TopologyKey, double> TopologyDoubleMap;
+#endif
+
 struct CandidateTree {
 
 	/**
@@ -41,11 +73,9 @@ struct CandidateTree {
 	string tree;
 
 	/**
-	 * tree topology WITHOUT branch lengths
-	 * and WITH TAXON ID (instead of taxon names)
-	 * for sorting purpose
+	 * key of the tree topology, for duplicate detection
 	 */
-	string topology;
+	TopologyKey topology;
 
 	/**
 	 * log-likelihood or parsimony score
@@ -182,9 +212,9 @@ public:
      * 	Check if tree topology \a topo already exists
      *
      * 	@param topo
-     * 		Newick string of the tree topology
+     * 		key of the tree topology
      */
-    bool treeTopologyExist(string topo);
+    bool treeTopologyExist(const TopologyKey &topo);
 
     /**
      * 	Check if tree \a tree already exists
@@ -217,16 +247,27 @@ public:
      * 		Newick string of the tree topology
      */
     string getTopology(string tree);
-    
+
+    /**
+     * 	Compute the topology key of a tree directly from its Newick string,
+     * 	without building the tree
+     *
+     * 	@param tree
+     * 		The newick tree string
+     * 	@return
+     * 		key of the tree topology
+     */
+    TopologyKey getTopologyKey(const string &tree);
+
     /**
      * return the score of \a topology
      *
      * @param topology
-     * 		Newick topology
+     * 		key of the topology
      * @return
      * 		Score of the topology
      */
-    double getTopologyScore(string topology);
+    double getTopologyScore(const TopologyKey &topology);
 
     /**
      *  Empty the candidate set
@@ -275,13 +316,13 @@ public:
      * @param topology
      * @return
      */
-    iterator getCandidateTree(string topology);
+    iterator getCandidateTree(const TopologyKey &topology);
 
     /**
      * Remove candidate trees with topology equal to the specified topology
      * @param topology
      */
-    void removeCandidateTree(string topology);
+    void removeCandidateTree(const TopologyKey &topology);
 
     /**
      *  Remove the worst tree in the candidate set
@@ -291,7 +332,7 @@ public:
     /* Getter and Setter function */
 	void setAln(Alignment* aln);
 
-	const StringDoubleHashMap& getTopologies() const {
+	const TopologyDoubleMap& getTopologies() const {
 		return topologies;
 	}
 
@@ -378,9 +419,9 @@ private:
 	SplitIntMap candSplits;
 
     /**
-     *  Map data structure storing <topology_string, score>
+     *  Map data structure storing <topology_key, score>
      */
-    StringDoubleHashMap topologies;
+    TopologyDoubleMap topologies;
 
     /**
      *  Trees used for reproduction
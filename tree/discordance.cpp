@@ -12,6 +12,17 @@
 
 #define PUT_MEANING(value, description) meanings.insert({#value, description})
 
+#if defined (__GNUC__) || defined(__clang__)
+#define quartet_popcnt64 __builtin_popcountll
+#else
+static inline int quartet_popcnt64(uint64_t a) {
+    a = a - ((a >> 1) & 0x5555555555555555ULL);
+    a = (a & 0x3333333333333333ULL) + ((a >> 2) & 0x3333333333333333ULL);
+    a = (a + (a >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (a * 0x0101010101010101ULL) >> 56;
+}
+#endif
+
 void PhyloTree::computeSiteConcordance(map<string,string> &meanings) {
     BranchVector branches;
     getInnerBranches(branches);
@@ -29,6 +40,10 @@ void PhyloTree::computeSiteConcordance(map<string,string> &meanings) {
         }
     }
 
+    // built once before the parallel region, read-only afterwards
+    if (!params->ancestral_site_concordance)
+        aln->buildQuartetBitPlanes();
+
     bool do_openmp = (params->ancestral_site_concordance == 0);
     
 #ifdef _OPENMP
@@ -83,6 +98,8 @@ void PhyloTree::computeSiteConcordance(map<string,string> &meanings) {
 
     if (params->ancestral_site_concordance)
         endMarginalAncestralState(orig_kernel_nonrev, marginal_ancestral_prob, marginal_ancestral_seq);
+    else
+        aln->clearQuartetBitPlanes();
     
     PUT_MEANING(sCF, "Site concordance factor averaged over " + convertIntToString(params->site_concordance) +  " quartets (=sCF_N/sN %)");
     PUT_MEANING(sN, "Number of informative sites averaged over " + convertIntToString(params->site_concordance) +  " quartets");
@@ -97,7 +114,36 @@ void Alignment::computeQuartetSupports(IntVector &quartet, vector<int64_t> &supp
     // sanity check e.g. when having rooted tree
     for (auto q = quartet.begin(); q != quartet.end(); q++)
         ASSERT(*q < getNSeq());
-        
+
+    if (!quartet_word_freq.empty()) {
+        // a pattern supports 12|34 if taxa 1,2 share a state, taxa 3,4 share a state
+        // and the two states differ, i.e. not all 4 taxa share the same state
+        size_t nwords = quartet_plane_words;
+        const uint64_t *plane[4];
+        for (int j = 0; j < 4; j++)
+            plane[j] = quartet_planes.data() + (size_t)quartet[j]*num_states*nwords;
+        for (size_t w = 0; w < nwords; w++) {
+            uint64_t eq01 = 0, eq23 = 0, eq02 = 0, eq13 = 0, eq03 = 0, eq12 = 0, eq_all = 0;
+            for (int x = 0; x < num_states; x++) {
+                size_t offset = x*nwords + w;
+                uint64_t b0 = plane[0][offset], b1 = plane[1][offset];
+                uint64_t b2 = plane[2][offset], b3 = plane[3][offset];
+                eq01 |= b0 & b1;
+                eq23 |= b2 & b3;
+                eq02 |= b0 & b2;
+                eq13 |= b1 & b3;
+                eq03 |= b0 & b3;
+                eq12 |= b1 & b2;
+                eq_all |= b0 & b1 & b2 & b3;
+            }
+            int64_t freq = quartet_word_freq[w];
+            support[0] += freq * quartet_popcnt64(eq01 & eq23 & ~eq_all);
+            support[1] += freq * quartet_popcnt64(eq02 & eq13 & ~eq_all);
+            support[2] += freq * quartet_popcnt64(eq03 & eq12 & ~eq_all);
+        }
+        return;
+    }
+
     for (auto pat = begin(); pat != end(); pat++) {
         if (!pat->isInformative()) continue;
         bool informative = true;
@@ -116,6 +162,60 @@ void Alignment::computeQuartetSupports(IntVector &quartet, vector<int64_t> &supp
     }
 }
 
+void Alignment::buildQuartetBitPlanes() {
+    clearQuartetBitPlanes();
+    if (num_states > 32)
+        return;
+    // group informative patterns by frequency, each group starting at a new word
+    map<int, IntVector> freq_groups;
+    for (size_t ptn = 0; ptn < size(); ptn++)
+        if (at(ptn).isInformative())
+            freq_groups[at(ptn).frequency].push_back(ptn);
+    size_t nwords = 0;
+    for (auto group = freq_groups.begin(); group != freq_groups.end(); group++)
+        nwords += (group->second.size() + 63) / 64;
+    if (nwords == 0)
+        return;
+    size_t nseq = getNSeq();
+    quartet_plane_words = nwords;
+    quartet_word_freq.resize(nwords);
+    quartet_planes.resize(nseq*num_states*nwords, 0);
+    size_t word = 0;
+    for (auto group = freq_groups.begin(); group != freq_groups.end(); group++) {
+        size_t group_size = group->second.size();
+        for (size_t i = 0; i < group_size; i++) {
+            Pattern &pat = at(group->second[i]);
+            size_t w = word + i/64;
+            uint64_t bit = 1ULL << (i%64);
+            // ambiguous states and gaps are left out, as they support no quartet
+            for (size_t seq = 0; seq < nseq; seq++)
+                if (pat[seq] < num_states)
+                    quartet_planes[(seq*num_states + pat[seq])*nwords + w] |= bit;
+        }
+        size_t group_words = (group_size + 63) / 64;
+        for (size_t i = 0; i < group_words; i++)
+            quartet_word_freq[word+i] = group->first;
+        word += group_words;
+    }
+}
+
+void Alignment::clearQuartetBitPlanes() {
+    quartet_planes.clear();
+    quartet_planes.shrink_to_fit();
+    quartet_word_freq.clear();
+    quartet_plane_words = 0;
+}
+
+void SuperAlignment::buildQuartetBitPlanes() {
+    for (auto part = partitions.begin(); part != partitions.end(); part++)
+        (*part)->buildQuartetBitPlanes();
+}
+
+void SuperAlignment::clearQuartetBitPlanes() {
+    for (auto part = partitions.begin(); part != partitions.end(); part++)
+        (*part)->clearQuartetBitPlanes();
+}
+
 void SuperAlignment::computeQuartetSupports(IntVector &quartet, vector<int64_t> &support) {
     for (int part = 0; part < partitions.size(); part++) {
         IntVector part_quartet;
@@ -66,6 +66,9 @@ void IQTree::init() {
     duplication_counter = 0;
     //boot_splits = new SplitGraph;
     pll2iqtree_pattern_index = NULL;
+    rell_batch = false;
+    rell_ptn_lh = NULL;
+    rell_ptn_lh_rows = 0;
 
     treels_name = Params::getInstance().out_prefix;
     treels_name += ".treels";
@@ -344,32 +347,22 @@ void IQTree::initSettings(Params &params) {
         
 //        cout << "Generating " << params.gbo_replicates << " samples for ultrafast "
 //             << RESAMPLE_NAME << " (seed: " << params.ran_seed << ")..." << endl;
-        // allocate memory for boot_samples
-        boot_samples.resize(params.gbo_replicates);
         sample_start = 0;
-        sample_end = boot_samples.size();
+        sample_end = params.gbo_replicates;
 
         // compute the sample_start and sample_end
         if (MPIHelper::getInstance().getNumProcesses() > 1) {
-            int num_samples = boot_samples.size() / MPIHelper::getInstance().getNumProcesses();
-            if (boot_samples.size() % MPIHelper::getInstance().getNumProcesses() != 0)
+            int num_samples = params.gbo_replicates / MPIHelper::getInstance().getNumProcesses();
+            if (params.gbo_replicates % MPIHelper::getInstance().getNumProcesses() != 0)
                 num_samples++;
             sample_start = MPIHelper::getInstance().getProcessID() * num_samples;
             sample_end = sample_start + num_samples;
-            if (sample_end > boot_samples.size())
-                sample_end = boot_samples.size();
+            if (sample_end > params.gbo_replicates)
+                sample_end = params.gbo_replicates;
         }
 
         size_t orig_nptn = getAlnNPattern();
-#ifdef BOOT_VAL_FLOAT
-        size_t nptn = get_safe_upper_limit_float(orig_nptn);
-#else
-        size_t nptn = get_safe_upper_limit(orig_nptn);
-#endif
-        BootValType *mem = aligned_alloc<BootValType>(nptn * (size_t)(params.gbo_replicates));
-        memset(mem, 0, nptn * (size_t)(params.gbo_replicates) * sizeof(BootValType));
-        for (i = 0; i < params.gbo_replicates; i++)
-            boot_samples[i] = mem + i*nptn;
+        boot_samples.init(params.gbo_replicates, orig_nptn);
 
         if (boot_trees.empty()) {
             boot_logl.resize(params.gbo_replicates, -DBL_MAX);
@@ -390,15 +383,13 @@ void IQTree::initSettings(Params &params) {
                     bootstrap_alignment = new Alignment;
                 IntVector this_sample;
                 bootstrap_alignment->createBootstrapAlignment(aln, &this_sample, params.bootstrap_spec);
-                for (size_t j = 0; j < orig_nptn; j++)
-                    boot_samples[i][j] = this_sample[j];
+                boot_samples.setSample(i, this_sample);
                 bootstrap_alignment->printAlignment(params.aln_output_format, bootaln_name.c_str(), true);
                 delete bootstrap_alignment;
             } else {
                 IntVector this_sample;
                 aln->createBootstrapAlignment(this_sample, params.bootstrap_spec);
-                for (size_t j = 0; j < orig_nptn; j++)
-                    boot_samples[i][j] = this_sample[j];
+                boot_samples.setSample(i, this_sample);
             }
         }
         verbose_mode = saved_mode;
@@ -418,9 +409,9 @@ void IQTree::initSettings(Params &params) {
         if(params.ufboot2corr){
             boot_samples_int.resize(params.gbo_replicates);
             for (size_t i = 0; i < params.gbo_replicates; i++) {
-                boot_samples_int[i].resize(nptn, 0);
+                boot_samples_int[i].resize(boot_samples.getStride(), 0);
                 for (size_t j = 0; j < orig_nptn; j++)
-                    boot_samples_int[i][j] = boot_samples[i][j];
+                    boot_samples_int[i][j] = boot_samples.getFreq(i, j);
                }
         }
 
@@ -445,10 +436,11 @@ IQTree::~IQTree() {
     boot_splits.clear();
     //if (boot_splits) delete boot_splits;
 
-    if (!boot_samples.empty()) {
-        aligned_free(boot_samples[0]); // free memory
-        boot_samples.clear();
-    }
+    boot_samples.clear();
+    if (rell_ptn_lh)
+        aligned_free(rell_ptn_lh);
+    for (auto rstream : rell_rstreams)
+        finish_random(rstream);
 }
 
 extern const char *aa_model_names_rax[];
@@ -3271,7 +3263,7 @@ void IQTree::pllInitUFBootData(){
                 if(!pllUFBootDataPtr->boot_samples[i]) outError("Not enough dynamic memory!");
                 for(int j = 0; j < pllAlignment->sequenceLength; j++){
                     pllUFBootDataPtr->boot_samples[i][j] =
-                        boot_samples[i][pll2iqtree_pattern_index[j]];
+                        boot_samples.getFreq(i, pll2iqtree_pattern_index[j]);
                 }
             }
 
@@ -3422,6 +3414,8 @@ void IQTree::setDelete(int _delete) {
 }
 
 void IQTree::evaluateNNIs(Branches &nniBranches, vector<NNIMove>  &positiveNNIs) {
+    // score all NNI trees of this round against the UFBoot replicates at once
+    beginRellBatch();
     for (Branches::iterator it = nniBranches.begin(); it != nniBranches.end(); it++) {
         NNIMove nni = getBestNNIForBran((PhyloNode*) it->second.first, (PhyloNode*) it->second.second, NULL);
         if (nni.newloglh > curScore) {
@@ -3431,9 +3425,11 @@ void IQTree::evaluateNNIs(Branches &nniBranches, vector<NNIMove>  &positiveNNIs)
         // synchronize tree during optimization step
         if (MPIHelper::getInstance().isMaster() && candidateset_changed.size() > 0
             && MPIHelper::getInstance().gotMessage()) {
+            computeRellBatch();
             syncCurrentTree();
         }
     }
+    endRellBatch();
 }
 
 //Branches IQTree::getReducedListOfNNIBranches(Branches &previousNNIBranches) {
@@ -3548,6 +3544,25 @@ void IQTree::estimateNNICutoff(Params* params) {
     delete[] delta;
 }
 
+/** number of patterns per block in computeRellBatch, a multiple of any SIMD width */
+#define RELL_PTN_BLOCK 1024
+
+/** number of replicates sharing each block of pattern log-likelihoods in computeRellBatch */
+#define RELL_SAMPLE_BLOCK 16
+
+/** maximum number of trees collected in batch mode before they are scored */
+#define RELL_MAX_BATCH 32
+
+string IQTree::getUFBootTreeString() {
+    ostringstream ostr;
+    setRootNode(params->root);
+    if (params->print_ufboot_trees == 2)
+        printTree(ostr, WT_TAXON_ID + WT_SORT_TAXA + WT_BR_LEN + WT_BR_LEN_SHORT);
+    else
+        printTree(ostr, WT_TAXON_ID + WT_SORT_TAXA);
+    return ostr.str();
+}
+
 void IQTree::saveCurrentTree(double cur_logl) {
 
     if (logl_cutoff != 0.0 && cur_logl < logl_cutoff - 1.0)
@@ -3558,111 +3573,154 @@ void IQTree::saveCurrentTree(double cur_logl) {
     if (Params::getInstance().write_intermediate_trees)
         printTree(out_treels, WT_NEWLINE | WT_BR_LEN);
 
-    int nptn = getAlnNPattern();
+    size_t nptn = getAlnNPattern();
+    DoubleVector pattern_lh(nptn);
+    computePatternLikelihood(pattern_lh.data(), &cur_logl);
 
-#ifdef BOOT_VAL_FLOAT
-    int maxnptn = get_safe_upper_limit_float(nptn);
-    BootValType *pattern_lh = aligned_alloc<BootValType>(maxnptn);
-    memset(pattern_lh, 0, maxnptn*sizeof(BootValType));
-    double *pattern_lh_orig = aligned_alloc<double>(nptn);
-    computePatternLikelihood(pattern_lh_orig, &cur_logl);
-    for (int i = 0; i < nptn; i++)
-        pattern_lh[i] = (float)pattern_lh_orig[i];
-#else
-    int maxnptn = get_safe_upper_limit(nptn);
-    BootValType *pattern_lh = aligned_alloc<BootValType>(maxnptn);
-    memset(pattern_lh, 0, maxnptn*sizeof(BootValType));
-    computePatternLikelihood(pattern_lh, &cur_logl);
-#endif
+    if (Params::getInstance().print_tree_lh) {
+        out_treelh << cur_logl;
+        double prob;
+        aln->multinomialProb(pattern_lh.data(), prob);
+        out_treelh << "\t" << prob << endl;
 
+        IntVector pattern_index;
+        aln->getSitePatternIndex(pattern_index);
+        out_sitelh << "Site_Lh   ";
+        for (size_t i = 0; i < getAlnNSite(); ++i)
+            out_sitelh << " " << (BootValType)pattern_lh[pattern_index[i]];
+        out_sitelh << endl;
+    }
 
     if (boot_samples.empty()) {
         // for runGuidedBootstrap
-    } else {
-        // online bootstrap
-//        int ptn;
-//        int updated = 0;
-//        int nsamples = boot_samples.size();
-        ostringstream ostr;
-        string tree_str;
-        setRootNode(params->root);
-        if (params->print_ufboot_trees == 2)
-            printTree(ostr, WT_TAXON_ID + WT_SORT_TAXA + WT_BR_LEN + WT_BR_LEN_SHORT);
-        else
-            printTree(ostr, WT_TAXON_ID + WT_SORT_TAXA);
-        tree_str = ostr.str();
+        return;
+    }
 
-    #ifdef _OPENMP
-        int rand_seed = random_int(1000);
-        #pragma omp parallel
-        {
-        int *rstream;
-        init_random(rand_seed + omp_get_thread_num(), false, &rstream);
-        #pragma omp for
-    #else
-        int *rstream = randstream;
-    #endif
-        for (int sample = sample_start; sample < sample_end; sample++) {
-            double rell = 0.0;
+    // online bootstrap: append the pattern log-likelihoods as a new row
+    size_t stride = boot_samples.getStride();
+    int id = rell_batch_logl.size();
+    if (id >= rell_ptn_lh_rows) {
+        int rows = (rell_batch) ? RELL_MAX_BATCH : 1;
+        BootValType *mem = aligned_alloc<BootValType>(stride*rows);
+        if (rell_ptn_lh) {
+            memcpy(mem, rell_ptn_lh, stride*id*sizeof(BootValType));
+            aligned_free(rell_ptn_lh);
+        }
+        rell_ptn_lh = mem;
+        rell_ptn_lh_rows = rows;
+    }
+    BootValType *row = rell_ptn_lh + id*stride;
+    for (size_t ptn = 0; ptn < nptn; ptn++)
+        row[ptn] = pattern_lh[ptn];
+    for (size_t ptn = nptn; ptn < stride; ptn++)
+        row[ptn] = 0.0;
+    rell_batch_logl.push_back(cur_logl);
+
+    if (!rell_batch) {
+        computeRellBatch();
+        return;
+    }
+    // the tree will change before the batch is scored
+    rell_batch_trees.push_back(getUFBootTreeString());
+    if (rell_batch_logl.size() >= RELL_MAX_BATCH)
+        computeRellBatch();
+}
 
-            {
-                // SSE optimized version of the above loop
-                BootValType *boot_sample = boot_samples[sample];
+void IQTree::beginRellBatch() {
+    if (boot_samples.empty())
+        return;
+    ASSERT(rell_batch_logl.empty());
+    rell_batch = true;
+}
 
-                BootValType res = (this->*dotProduct)(pattern_lh, boot_sample, nptn);
+void IQTree::endRellBatch() {
+    if (!rell_batch)
+        return;
+    computeRellBatch();
+    rell_batch = false;
+}
 
-                rell = res;
-            }
+void IQTree::computeRellBatch() {
+    int ntrees = rell_batch_logl.size();
+    if (ntrees == 0)
+        return;
+    size_t stride = boot_samples.getStride();
+    int nsamples = sample_end - sample_start;
+    rell_scores.assign((size_t)nsamples*ntrees, 0.0);
+    // last collected tree that replaced the bootstrap tree of each replicate
+    IntVector improved(nsamples, -1);
 
-            bool better = rell > boot_logl[sample] + params->ufboot_epsilon;
-            if (!better && rell > boot_logl[sample] - params->ufboot_epsilon) {
-                better = (random_double(rstream) <= 1.0 / (boot_counts[sample] + 1));
-            }
-            if (better) {
-                if (rell <= boot_logl[sample] + params->ufboot_epsilon) {
-                    boot_counts[sample]++;
-                } else {
-                    boot_counts[sample] = 1;
-                }
-                boot_logl[sample] = max(boot_logl[sample], rell);
-                boot_orig_logl[sample] = cur_logl;
-                boot_trees[sample] = tree_str;
-            }
-        }
-    #ifdef _OPENMP
-        finish_random(rstream);
+#ifdef _OPENMP
+    if (rell_rstreams.size() < omp_get_max_threads()) {
+        int rand_seed = random_int(1000);
+        for (int i = rell_rstreams.size(); i < omp_get_max_threads(); i++) {
+            int *rstream;
+            init_random(rand_seed + i, false, &rstream);
+            rell_rstreams.push_back(rstream);
         }
-    #endif
     }
-    if (Params::getInstance().print_tree_lh) {
-        out_treelh << cur_logl;
-        double prob;
-#ifdef BOOT_VAL_FLOAT
-        aln->multinomialProb(pattern_lh_orig, prob);
+    #pragma omp parallel
+#endif
+    {
+    BootValType *freq = aligned_alloc<BootValType>(RELL_PTN_BLOCK);
+#ifdef _OPENMP
+    int *rstream = rell_rstreams[omp_get_thread_num()];
+    #pragma omp for schedule(static)
 #else
-        aln->multinomialProb(pattern_lh, prob);
+    int *rstream = randstream;
 #endif
-        out_treelh << "\t" << prob << endl;
+    for (int first = sample_start; first < sample_end; first += RELL_SAMPLE_BLOCK) {
+        int last = min(first + RELL_SAMPLE_BLOCK, sample_end);
+        // RELL scores of all trees for this tile of replicates
+        for (size_t ptn = 0; ptn < stride; ptn += RELL_PTN_BLOCK) {
+            int len = min(stride - ptn, (size_t)RELL_PTN_BLOCK);
+            for (int sample = first; sample < last; sample++) {
+                boot_samples.getBlock(sample, ptn, len, freq);
+                (this->*dotProductMulti)(freq, rell_ptn_lh + ptn, stride, ntrees, len,
+                    &rell_scores[(size_t)(sample-sample_start)*ntrees]);
+            }
+        }
 
-        IntVector pattern_index;
-        aln->getSitePatternIndex(pattern_index);
-        out_sitelh << "Site_Lh   ";
-        for (size_t i = 0; i < getAlnNSite(); ++i)
-            out_sitelh << " " << pattern_lh[pattern_index[i]];
-        out_sitelh << endl;
+        // update bootstrap trees in the order the trees were collected
+        for (int sample = first; sample < last; sample++) {
+            double *rell = &rell_scores[(size_t)(sample-sample_start)*ntrees];
+            for (int tree = 0; tree < ntrees; tree++) {
+                bool better = rell[tree] > boot_logl[sample] + params->ufboot_epsilon;
+                if (!better && rell[tree] > boot_logl[sample] - params->ufboot_epsilon) {
+                    better = (random_double(rstream) <= 1.0 / (boot_counts[sample] + 1));
+                }
+                if (better) {
+                    if (rell[tree] <= boot_logl[sample] + params->ufboot_epsilon) {
+                        boot_counts[sample]++;
+                    } else {
+                        boot_counts[sample] = 1;
+                    }
+                    boot_logl[sample] = max(boot_logl[sample], rell[tree]);
+                    boot_orig_logl[sample] = rell_batch_logl[tree];
+                    improved[sample-sample_start] = tree;
+                }
+            }
+        }
     }
-
-    if (!boot_samples.empty()) {
-#ifdef BOOT_VAL_FLOAT
-        aligned_free(pattern_lh_orig);
-#endif
-        aligned_free(pattern_lh);
-    } else {
-#ifdef BOOT_VAL_FLOAT
-        aligned_free(pattern_lh);
-#endif
+    aligned_free(freq);
     }
 
+    // only print the current tree if some replicate improved
+    string tree_str;
+    for (int sample = sample_start; sample < sample_end; sample++) {
+        int tree = improved[sample-sample_start];
+        if (tree < 0)
+            continue;
+        if (rell_batch_trees.empty()) {
+            if (tree_str.empty())
+                tree_str = getUFBootTreeString();
+            boot_trees[sample] = tree_str;
+        } else {
+            boot_trees[sample] = rell_batch_trees[tree];
+        }
+    }
+    rell_batch_logl.clear();
+    rell_batch_trees.clear();
 }
 
 void IQTree::saveNNITrees(PhyloNode *node, PhyloNode *dad) {
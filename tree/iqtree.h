@@ -27,6 +27,7 @@
 #include <stack>
 #include <vector>
 #include "phylotree.h"
+#include "bootsamples.h"
 #include "phylonode.h"
 #include "utils/stoprule.h"
 #include "mtreeset.h"
@@ -771,8 +772,29 @@ public:
     /** log-likelihood threshold (l_min) */
     double logl_cutoff;
 
-    /** vector of bootstrap alignments generated */
-    vector<BootValType* > boot_samples;
+    /** pattern frequencies of the bootstrap alignments generated */
+    BootSampleMatrix boot_samples;
+
+    /** TRUE if saveCurrentTree collects trees to be scored together by computeRellBatch() */
+    bool rell_batch;
+
+    /** pattern log-likelihoods of the collected trees, one padded row per tree */
+    BootValType *rell_ptn_lh;
+
+    /** number of rows allocated for rell_ptn_lh */
+    int rell_ptn_lh_rows;
+
+    /** log-likelihoods of the collected trees */
+    DoubleVector rell_batch_logl;
+
+    /** NEWICK strings of the collected trees, only filled in batch mode */
+    StrVector rell_batch_trees;
+
+    /** RELL scores of the collected trees, (replicates x trees) */
+    DoubleVector rell_scores;
+
+    /** random streams of each thread for RELL tie breaking, created once */
+    vector<int*> rell_rstreams;
 
     /** starting sample for UFBoot, used for MPI */
     int sample_start;
@@ -867,6 +889,29 @@ protected:
 
     virtual void saveCurrentTree(double logl); // save current tree
 
+    /**
+        start collecting the trees passed to saveCurrentTree, so that a whole
+        round of NNIs is scored against all UFBoot replicates at once
+    */
+    void beginRellBatch();
+
+    /**
+        score the collected trees and stop collecting
+    */
+    void endRellBatch();
+
+    /**
+        compute RELL scores of all collected trees against all UFBoot replicates
+        as one cache-blocked matrix product and update the bootstrap trees.
+        Outside batch mode, the current tree is only printed if some replicate improves
+    */
+    void computeRellBatch();
+
+    /**
+        @return NEWICK string of the current tree as stored in boot_trees
+    */
+    string getUFBootTreeString();
+
 
     void saveNNITrees(PhyloNode *node = NULL, PhyloNode *dad = NULL);
 
@@ -42,6 +42,7 @@ IQTreeMix::IQTreeMix() : IQTree() {
     ptn_like_cat = NULL;
     _ptn_like_cat = NULL;
     ptn_scale_cat = NULL;
+    _ptn_scale_cat = NULL;
     single_ptn_tree_like = NULL;
     ptn_like = NULL;
     _pattern_scaling = NULL;
@@ -75,6 +76,7 @@ IQTreeMix::IQTreeMix(Params &params, Alignment *aln, vector<IQTree*> &trees) : I
         weights.push_back(init_weight);
         weight_logs.push_back(init_weight_log);
     }
+    tree_lh_params.resize(ntree);
     
     // allocate memory for the arrays
     nptn = aln->getNPattern();
@@ -88,6 +90,7 @@ IQTreeMix::IQTreeMix(Params &params, Alignment *aln, vector<IQTree*> &trees) : I
     ptn_like_cat = aligned_alloc<double>(block_size);
     _ptn_like_cat = aligned_alloc<double>(block_size);
     ptn_scale_cat = aligned_alloc<double>(block_size);
+    _ptn_scale_cat = aligned_alloc<double>(block_size);
     patn_parsimony = aligned_alloc<int>(block_size32);
     single_ptn_tree_like = aligned_alloc<double>(get_safe_upper_limit(ntree));
     ptn_like = aligned_alloc<double>(mem_size);
@@ -157,6 +160,9 @@ IQTreeMix::~IQTreeMix() {
     if (ptn_scale_cat != NULL){
         aligned_free(ptn_scale_cat);
     }
+    if (_ptn_scale_cat != NULL) {
+        aligned_free(_ptn_scale_cat);
+    }
     if (ptn_freq != NULL) {
         aligned_free(ptn_freq);
     }
@@ -596,13 +602,86 @@ int IQTreeMix::getNumLhCat(SiteLoglType wsl) {
     return ncat;
 }
 
+void IQTreeMix::computePatternLhTree(int t, bool save_log_value) {
+    ASSERT(t < tree_lh_params.size());
+    DoubleVector lh_params;
+    getTreeLhParams(t, lh_params);
+    lh_params.push_back(save_log_value);
+    if (lh_params == tree_lh_params[t]) {
+        // nothing changed since the last computation
+        return;
+    }
+
+    double* pattern_lh_tree = _ptn_like_cat + t * nptn;
+    // save the site rate's tree
+    PhyloTree* ptree = at(t)->getRate()->getTree();
+    // set the tree t as the site rate's tree
+    // and compute the likelihood values
+    at(t)->getRate()->setTree(at(t));
+    if (tree_lh_params[t].empty()) {
+        // first computation or the tree was marked as changed
+        at(t)->initializeAllPartialLh();
+        at(t)->clearAllPartialLH();
+    }
+    // otherwise the partial likelihoods were kept up to date by the model, the site rate
+    // and the branch length updates, so only the invalidated ones are recomputed
+    at(t)->computeLikelihood(pattern_lh_tree, save_log_value);
+    // set back the previous site rate's tree
+    at(t)->getRate()->setTree(ptree);
+    memcpy(_ptn_scale_cat + t * nptn, at(t)->_pattern_scaling, nptn * sizeof(double));
+    tree_lh_params[t] = lh_params;
+}
+
+void IQTreeMix::getTreeLhParams(int t, DoubleVector &lh_params) {
+    ModelSubst *model = at(t)->getModel();
+    RateHeterogeneity *rate = at(t)->getRate();
+    size_t nstates = model->num_states;
+    size_t nmix = model->getNMixtures();
+    
+    lh_params.clear();
+    at(t)->saveBranchLengths(lh_params);
+    size_t start = lh_params.size();
+    lh_params.resize(start + nmix * (nstates * nstates + nstates + 1));
+    double *param = &lh_params[start];
+    for (size_t m = 0; m < nmix; m++) {
+        model->getQMatrix(param, m);
+        param += nstates * nstates;
+        model->getStateFrequency(param, m);
+        param += nstates;
+        *param++ = model->getMixtureWeight(m);
+    }
+    for (int c = 0; c < rate->getNRate(); c++) {
+        lh_params.push_back(rate->getRate(c));
+        lh_params.push_back(rate->getProp(c));
+    }
+    lh_params.push_back(rate->getPInvar());
+}
+
+void IQTreeMix::restoreTreeBranchLengths(int t, DoubleVector &len) {
+    PhyloTree *tree = at(t);
+    int mixlen = tree->getMixlen();
+    DoubleVector old_len;
+    tree->saveBranchLengths(old_len);
+    tree->restoreBranchLengths(len);
+    
+    NodeVector nodes1, nodes2;
+    tree->getBranches(nodes1, nodes2);
+    for (size_t i = 0; i < nodes1.size(); i++) {
+        int id = nodes1[i]->findNeighbor(nodes2[i])->id;
+        if (equal(old_len.begin() + id * mixlen, old_len.begin() + (id + 1) * mixlen, len.begin() + id * mixlen))
+            continue;
+        // the partial likelihoods containing this branch are out of date
+        ((PhyloNode*)nodes1[i])->clearReversePartialLh((PhyloNode*)nodes2[i]);
+        ((PhyloNode*)nodes2[i])->clearReversePartialLh((PhyloNode*)nodes1[i]);
+    }
+}
+
 // compute the log-likelihood values for every site and tree
 // updated array: _ptn_like_cat
 // update_which_tree: only that tree has been updated
 void IQTreeMix::computeSiteTreeLogLike(int update_which_tree) {
     // cout << "enter IQTreeMix::computeSiteTreeLogLike" << endl;
     // cout << "update_which_tree = " << update_which_tree << endl;
-    PhyloTree* ptree;
     int k,t;
 
     t = update_which_tree;
@@ -617,19 +696,12 @@ void IQTreeMix::computeSiteTreeLogLike(int update_which_tree) {
     
     // compute likelihood for each tree
     double* patternlh_tree = _ptn_like_cat + t*nptn;
-    ptree = at(t)->getRate()->getTree();
-    // set the tree t as the site rate's tree
-    // and compute the likelihood values
-    at(t)->getRate()->setTree(at(t));
+    double* patternscale_tree = _ptn_scale_cat + t*nptn;
     if (isLinkSiteRate && t > 0) {
         // Replace the RHAS variables of tree t by those of tree 0
         copyRHASfrTree0(t);
     }
-    at(t)->initializeAllPartialLh();
-    at(t)->clearAllPartialLH();
-    at(t)->computeLikelihood(patternlh_tree, false);
-    // set back the prevoius site rate's tree
-    at(t)->getRate()->setTree(ptree);
+    computePatternLhTree(t);
 
     // reorganize the array
     k=t;
@@ -643,7 +715,7 @@ void IQTreeMix::computeSiteTreeLogLike(int update_which_tree) {
     for (size_t ptn=0; ptn<nptn; ptn++) {
         double* pattern_lh_tree = ptn_like_cat + ntree * ptn;
         // check whether the scaling factor of the updated tree has much difference
-        double scale_diff = at(t)->_pattern_scaling[ptn] - this->_pattern_scaling[ptn];
+        double scale_diff = patternscale_tree[ptn] - this->_pattern_scaling[ptn];
         double abs_scale_diff = fabs(scale_diff);
         if (abs_scale_diff > TINY_SCALE_DIFF) {
             // the difference in the scaling factor is significant
@@ -664,7 +736,7 @@ void IQTreeMix::computeSiteTreeLogLike(int update_which_tree) {
                         pattern_lh_tree[j] *= SCALING_THRESHOLD;
                     }
                 }
-                this->_pattern_scaling[ptn] = at(t)->_pattern_scaling[ptn];
+                this->_pattern_scaling[ptn] = patternscale_tree[ptn];
             } else {
                 // the scaling factor of the updated tree is smaller
                 if (abs_scale_diff > ONE_LOG_SCALE_DIFF) {
@@ -704,23 +776,11 @@ double IQTreeMix::computeLikelihood(double *pattern_lh, bool save_log_value) {
         if (isNestedOpenmp) {
             omp_set_num_threads(at(t)->num_threads);
         }
-        double* pattern_lh_tree = _ptn_like_cat + nptn * t;
-        // save the site rate's tree
-        PhyloTree* ptree = at(t)->getRate()->getTree();
-        // set the tree t as the site rate's tree
-        // and compute the likelihood values
-        at(t)->getRate()->setTree(at(t));
-        
         if (isLinkSiteRate && t > 0) {
             // Replace the RHAS variables of tree t by those of tree 0
             copyRHASfrTree0(t);
         }
-        
-        at(t)->initializeAllPartialLh();
-        at(t)->clearAllPartialLH();
-        at(t)->computeLikelihood(pattern_lh_tree, false);
-        // set back the prevoius site rate's tree
-        at(t)->getRate()->setTree(ptree);
+        computePatternLhTree(t);
     }
     
     if (isNestedOpenmp) {
@@ -737,7 +797,7 @@ double IQTreeMix::computeLikelihood(double *pattern_lh, bool save_log_value) {
         for (size_t ptn=0; ptn<nptn; ptn++) {
             // cout << setprecision(7) << t << "\t" << ptn << "\t" << _ptn_like_cat[i] << endl;
             ptn_like_cat[j] = _ptn_like_cat[i];
-            ptn_scale_cat[j] = at(t)->_pattern_scaling[ptn];
+            ptn_scale_cat[j] = _ptn_scale_cat[i];
             i++;
             j+=ntree;
         }
@@ -821,21 +881,11 @@ double IQTreeMix::computePatternLhCat(SiteLoglType wsl) {
             if (isNestedOpenmp) {
                 omp_set_num_threads(at(t)->num_threads);
             }
-            double* pattern_lh_tree = _ptn_like_cat + t * nptn;
-            // save the site rate's tree
-            PhyloTree* ptree = at(t)->getRate()->getTree();
-            // set the tree t as the site rate's tree
-            // and compute the likelihood values
-            at(t)->getRate()->setTree(at(t));
             if (isLinkSiteRate && t > 0) {
                 // Replace the RHAS variables of tree t by those of tree 0
                 copyRHASfrTree0(t);
             }
-            at(t)->initializeAllPartialLh();
-            at(t)->clearAllPartialLH();
-            at(t)->computeLikelihood(pattern_lh_tree, save_log_value);
-            // set back the prevoius site rate's tree
-            at(t)->getRate()->setTree(ptree);
+            computePatternLhTree(t, save_log_value);
         }
         if (isNestedOpenmp) {
             // omp_set_nested(0);
@@ -850,7 +900,7 @@ double IQTreeMix::computePatternLhCat(SiteLoglType wsl) {
             int j = t;
             for (size_t ptn=0; ptn<nptn; ptn++) {
                 ptn_like_cat[j] = _ptn_like_cat[i];
-                ptn_scale_cat[j] = at(t)->_pattern_scaling[ptn];
+                ptn_scale_cat[j] = _ptn_scale_cat[i];
                 i++;
                 j += ntree;
             }
@@ -862,11 +912,11 @@ double IQTreeMix::computePatternLhCat(SiteLoglType wsl) {
             // find the max scaling factor among the trees
             double* pattern_lh_tree = ptn_like_cat + ptn * ntree;
             double* pattern_scale_tree = ptn_scale_cat + ptn * ntree;
-            double max_scale = at(0)->_pattern_scaling[ptn];
+            double max_scale = pattern_scale_tree[0];
             int max_tree = 0;
             for (size_t t=1; t<ntree; t++) {
-                if (max_scale < at(t)->_pattern_scaling[ptn]) {
-                    max_scale = at(t)->_pattern_scaling[ptn];
+                if (max_scale < pattern_scale_tree[t]) {
+                    max_scale = pattern_scale_tree[t];
                     max_tree = t;
                 }
             }
@@ -1065,21 +1115,11 @@ void IQTreeMix::computePatternLikelihood(double *pattern_lh, double *cur_logl,
         if (isNestedOpenmp) {
             omp_set_num_threads(at(t)->num_threads);
         }
-        double* pattern_lh_tree = _ptn_like_cat + t * nptn;
-        // save the site rate's tree
-        PhyloTree* ptree = at(t)->getRate()->getTree();
-        // set the tree t as the site rate's tree
-        // and compute the likelihood values
-        at(t)->getRate()->setTree(at(t));
         if (isLinkSiteRate && t > 0) {
             // Replace the RHAS variables of tree t by those of tree 0
             copyRHASfrTree0(t);
         }
-        at(t)->initializeAllPartialLh();
-        at(t)->clearAllPartialLH();
-        at(t)->computeLikelihood(pattern_lh_tree, false);
-        // set back the prevoius site rate's tree
-        at(t)->getRate()->setTree(ptree);
+        computePatternLhTree(t);
     }
     if (isNestedOpenmp) {
         // omp_set_nested(0);
@@ -1094,7 +1134,7 @@ void IQTreeMix::computePatternLikelihood(double *pattern_lh, double *cur_logl,
         int j = t;
         for (size_t ptn=0; ptn<nptn; ptn++) {
             ptn_like_cat[j] = _ptn_like_cat[i];
-            ptn_scale_cat[j] = at(t)->_pattern_scaling[ptn];
+            ptn_scale_cat[j] = _ptn_scale_cat[i];
             if (pattern_lh_cat)
                 pattern_lh_cat[j] = log(ptn_like_cat[j]) + ptn_scale_cat[j];
             i++;
@@ -1146,6 +1186,7 @@ void IQTreeMix::initializeAllPartialLh() {
     size_t i;
     for (i=0; i<size(); i++) {
         at(i)->initializeAllPartialLh();
+        tree_lh_params[i].clear();
     }
 }
 
@@ -1153,6 +1194,7 @@ void IQTreeMix::deleteAllPartialLh() {
     size_t i;
     for (i=0; i<size(); i++) {
         at(i)->deleteAllPartialLh();
+        tree_lh_params[i].clear();
     }
 }
 
@@ -1160,6 +1202,7 @@ void IQTreeMix::clearAllPartialLH(bool make_null) {
     size_t i;
     for (i=0; i<size(); i++) {
         at(i)->clearAllPartialLH(make_null);
+        tree_lh_params[i].clear();
     }
 }
 
@@ -1288,7 +1331,7 @@ void IQTreeMix::setBranchLengths(vector<DoubleVector> &len, Node *node, Node *da
     size_t i;
 
     for (i=0; i<ntree; i++) {
-        at(i)->restoreBranchLengths(len[i]);
+        restoreTreeBranchLengths(i, len[i]);
     }
 }
 
@@ -2680,6 +2723,7 @@ void IQTreeMix::readTreeString(const string &tree_string) {
     ASSERT(substrs.size() == size());
     for (i=0; i<size(); i++) {
         at(i)->readTreeString(substrs[i]);
+        tree_lh_params[i].clear();
     }
 }
 
@@ -2869,7 +2913,14 @@ void IQTreeMix::copyRHASfrTree0(int t) {
     }
 
     // copy the RHAS variables of tree 0 to this
-    at(t)->getRate()->getVariables(rhas_var);
+    // and clear the partial likelihoods only if the variables change
+    int ndim = at(t)->getRate()->getNDim();
+    DoubleVector curr_var(ndim + 1);
+    at(t)->getRate()->setVariables(curr_var.data());
+    if (!equal(curr_var.begin() + 1, curr_var.end(), rhas_var + 1)) {
+        at(t)->getRate()->getVariables(rhas_var);
+        at(t)->clearAllPartialLH();
+    }
 
     if (at(t)->getRate()->isFreeRate()) {
         // for Free Rate model
@@ -2888,6 +2939,51 @@ double IQTreeMix::targetFunk(double x[]) {
     return score;
 }
 
+void IQTreeMix::targetFunkBatch(int npoints, double *points[], double values[]) {
+    if (optim_type != 1 || npoints < 2) {
+        Optimization::targetFunkBatch(npoints, points, values);
+        return;
+    }
+    
+    // normalised tree weights of each point, as computed by getVariables
+    size_t ndim = weight_group_member.size();
+    vector<double> point_weights(npoints * ntree);
+    for (int k = 0; k < npoints; k++) {
+        double sum = 0.0;
+        for (size_t i = 0; i < ndim; i++)
+            sum += points[k][i+1] * weight_group_member[i].size();
+        for (size_t i = 0; i < ndim; i++)
+            for (size_t j = 0; j < weight_group_member[i].size(); j++)
+                point_weights[k * ntree + weight_group_member[i].at(j)] = points[k][i+1] / sum;
+    }
+    
+    // the pattern likelihoods of the trees are read once for all points
+    vector<double> logl(npoints, 0.0);
+    #pragma omp parallel num_threads(num_threads) if (num_threads > 1)
+    {
+        vector<double> thread_logl(npoints, 0.0);
+        #pragma omp for schedule(static)
+        for (size_t ptn=0; ptn<nptn; ptn++) {
+            double *ptn_lh = ptn_like_cat + ptn * ntree;
+            for (int k = 0; k < npoints; k++) {
+                double *w = &point_weights[k * ntree];
+                double subLike = 0.0;
+                for (size_t t=0; t<ntree; t++)
+                    subLike += ptn_lh[t] * w[t];
+                thread_logl[k] += (log(subLike) + _pattern_scaling[ptn]) * ptn_freq[ptn];
+            }
+        }
+        #pragma omp critical
+        for (int k = 0; k < npoints; k++)
+            logl[k] += thread_logl[k];
+    }
+    for (int k = 0; k < npoints; k++)
+        values[k] = -logl[k];
+    
+    // same tree weights as after evaluating the points one by one
+    getVariables(points[npoints-1]);
+}
+
 // read the tree weights and write into "variables"
 void IQTreeMix::setVariables(double *variables) {
     // for tree weights
@@ -64,6 +64,32 @@ public:
     // update_which_tree: only that tree has been updated
     void computeSiteTreeLogLike(int update_which_tree);
     
+    /**
+     compute the pattern likelihoods of tree t into _ptn_like_cat and its scaling factors into _ptn_scale_cat.
+     The cached values are kept if the tree has not been marked as changed by clearAllPartialLH()
+     and its branch lengths, model and RHAS parameters are the same as at the last computation.
+     Otherwise only the partial likelihoods invalidated by the changes are recomputed.
+     @param t tree index
+     @param save_log_value TRUE to store log-likelihoods including the scaling factors
+     */
+    void computePatternLhTree(int t, bool save_log_value = false);
+    
+    /**
+     collect the parameters which determine the pattern likelihoods of tree t
+     @param t tree index
+     @param[out] lh_params branch lengths, Q matrices, state frequencies and weights of the mixture classes,
+     followed by the rates and proportions of the RHAS categories and the proportion of invariable sites
+     */
+    void getTreeLhParams(int t, DoubleVector &lh_params);
+    
+    /**
+     set the branch lengths of tree t, only clearing the partial likelihoods
+     along the paths of the branches whose lengths change
+     @param t tree index
+     @param len branch lengths as from saveBranchLengths()
+     */
+    void restoreTreeBranchLengths(int t, DoubleVector &len);
+    
     virtual double computeLikelihood(double *pattern_lh = NULL, bool save_log_value = true);
     
     virtual double computePatternLhCat(SiteLoglType wsl);
@@ -320,6 +346,17 @@ public:
      */
     double* ptn_scale_cat;
 
+    /**
+     scaling factors of the pattern likelihoods in _ptn_like_cat, nptn per tree
+     */
+    double* _ptn_scale_cat;
+
+    /**
+     parameters of each tree at the last computation of its pattern likelihoods in _ptn_like_cat
+     (see getTreeLhParams()), empty if the pattern likelihoods must be recomputed
+     */
+    vector<DoubleVector> tree_lh_params;
+
     /**
      log-likelihoods of each tree for each pattern
      */
@@ -448,6 +485,10 @@ protected:
     
     double targetFunk(double x[]);
     
+    // evaluate several sets of tree weights in one pass over the pattern likelihoods
+    // (for branch lengths, the points are evaluated one after another)
+    void targetFunkBatch(int npoints, double *points[], double values[]);
+    
     // read the tree weights and write into "variables"
     void setVariables(double *variables);
     
@@ -738,17 +738,7 @@ void IQTreeMixHmm::showParameters(ostream& out) {
 
 // compute the log-likelihoods for a single tree t
 void IQTreeMixHmm::computeLogLikelihoodSingleTree(int t) {
-    double* pattern_lh_tree = _ptn_like_cat + nptn * t;
-    // save the site rate's tree
-    PhyloTree* ptree = at(t)->getRate()->getTree();
-    // set the tree t as the site rate's tree
-    // and compute the likelihood values
-    at(t)->getRate()->setTree(at(t));
-    at(t)->initializeAllPartialLh();
-    at(t)->clearAllPartialLH();
-    at(t)->computeLikelihood(pattern_lh_tree, true); // get the log-likelihood values
-    // set back the previous site rate's tree
-    at(t)->getRate()->setTree(ptree);
+    computePatternLhTree(t, true); // get the log-likelihood values
 }
 
 // get the branch lengths of all trees to the variable allbranchlens
@@ -762,7 +752,7 @@ void IQTreeMixHmm::getAllBranchLengths() {
 // set the branch lengths of all trees from the variable allbranchlens
 void IQTreeMixHmm::setAllBranchLengths() {
     for (size_t i=0; i<ntree; i++)
-        at(i)->restoreBranchLengths(allbranchlens[i]);
+        restoreTreeBranchLengths(i, allbranchlens[i]);
 }
 
 // show the branch lengths of all trees
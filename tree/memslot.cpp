@@ -25,6 +25,13 @@
 const int MEM_LOCKED = 1;
 const int MEM_SPECIAL = 2;
 
+MemSlotVector::MemSlotVector() {
+    num_hits = num_misses = num_recomputes = 0;
+    access_time = 0;
+    cur_epoch = 0;
+    free_count = 0;
+}
+
 void MemSlotVector::init(PhyloTree *tree, int num_slot) {
     if (Params::getInstance().lh_mem_save != LM_MEM_SAVE)
         return;
@@ -45,8 +52,11 @@ void MemSlotVector::reset() {
     for (iterator it = begin(); it != end(); it++) {
         it->status = 0;
         it->nei = NULL;
+        it->last_used = 0;
+        it->pin_epoch = 0;
     }
     nei_id_map.clear();
+    evicted_nei.clear();
     free_count = 0;
 }
 
@@ -64,6 +74,11 @@ void MemSlotVector::addNei(PhyloNeighbor *nei, iterator it) {
     nei->scale_num = it->scale_num;
     it->nei = nei;
     nei_id_map[nei] = it-begin();
+    touch(it);
+}
+
+void MemSlotVector::touch(iterator it) {
+    it->last_used = ++access_time;
 }
 
 
@@ -75,6 +90,8 @@ void MemSlotVector::addSpecialNei(PhyloNeighbor *nei) {
     ms.nei = nei;
     ms.partial_lh = nei->partial_lh;
     ms.scale_num = nei->scale_num;
+    ms.last_used = access_time;
+    ms.pin_epoch = 0;
     push_back(ms);
     nei_id_map[nei] = size()-1;
 }
@@ -99,6 +116,7 @@ bool MemSlotVector::lock(PhyloNeighbor *nei) {
         return false;
     ASSERT((id->status & MEM_LOCKED) == 0);
     id->status |= MEM_LOCKED;
+    touch(id);
     return true;
 }
 
@@ -112,6 +130,8 @@ void MemSlotVector::unlock(PhyloNeighbor *nei) {
         return;
     ASSERT((id->status & MEM_LOCKED) != 0);
     id->status &= ~MEM_LOCKED;
+    // consumed by its parent, no need to keep it pinned
+    id->pin_epoch = 0;
 }
 
 bool MemSlotVector::locked(PhyloNeighbor *nei) {
@@ -130,10 +150,31 @@ bool MemSlotVector::locked(PhyloNeighbor *nei) {
         return true;
 }
 
+MemSlotVector::iterator MemSlotVector::findVictim(bool allow_pinned) {
+    iterator best = end();
+    double min_cost = DBL_MAX;
+    for (iterator it = begin(); it != end(); it++) {
+        if ((it->status & MEM_LOCKED) != 0 || (it->status & MEM_SPECIAL) != 0)
+            continue;
+        if (!allow_pinned && it->pin_epoch == cur_epoch)
+            continue;
+        double cost = (double)it->nei->size / (access_time - it->last_used + 1);
+        if (cost < min_cost) {
+            best = it;
+            min_cost = cost;
+        }
+    }
+    return best;
+}
+
 int MemSlotVector::allocate(PhyloNeighbor *nei) {
     if (Params::getInstance().lh_mem_save != LM_MEM_SAVE)
         return -1;
 
+    num_misses++;
+    if (evicted_nei.erase(nei))
+        num_recomputes++;
+
     // first find a free slot
     if (free_count < size() && (at(free_count).status & MEM_SPECIAL) == 0) {
         iterator it = begin() + free_count;
@@ -143,25 +184,18 @@ int MemSlotVector::allocate(PhyloNeighbor *nei) {
         return it-begin();
     }
 
-    int min_size = INT_MAX;
-    iterator best = end();
-
-
-    // no free slot found, find an unlocked slot with minimal size
-    for (iterator it = begin(); it != end(); it++)
-        if ((it->status & MEM_LOCKED) == 0 && (it->status & MEM_SPECIAL) == 0 && min_size > it->nei->size) {
-            best = it;
-            min_size = it->nei->size;
-            // 2 is the minimum size
-            if (min_size == 2)
-                break;
-        }
+    // no free slot found, evict the cheapest unlocked slot not needed by the current traversal
+    iterator best = findVictim(false);
+    if (best == end())
+        best = findVictim(true);
 
     if (best == end())
         return -1;
 
     // clear mem assigned to it->nei
     best->nei->clearPartialLh();
+    evicted_nei.insert(best->nei);
+    best->pin_epoch = 0;
 
     // assign mem to nei
     addNei(nei, best);
@@ -173,16 +207,52 @@ void MemSlotVector::update(PhyloNeighbor *nei) {
     if (Params::getInstance().lh_mem_save != LM_MEM_SAVE)
         return;
 
+    num_misses++;
+    if (evicted_nei.erase(nei))
+        num_recomputes++;
+
     iterator it = findNei(nei);
 //    if (it->status & MEM_SPECIAL)
 //        return;
     if (it->nei != nei) {
         // clear mem assigned to it->nei
         it->nei->clearPartialLh();
+        evicted_nei.insert(it->nei);
 
         // assign mem to nei
         addNei(nei, it);
-    }
+    } else
+        touch(it);
+}
+
+void MemSlotVector::beginTraversal() {
+    if (Params::getInstance().lh_mem_save != LM_MEM_SAVE)
+        return;
+    cur_epoch++;
+}
+
+void MemSlotVector::pin(PhyloNeighbor *nei) {
+    if (Params::getInstance().lh_mem_save != LM_MEM_SAVE)
+        return;
+    auto it = nei_id_map.find(nei);
+    if (it == nei_id_map.end() || at(it->second).nei != nei)
+        return;
+    at(it->second).pin_epoch = cur_epoch;
+}
+
+void MemSlotVector::hit() {
+    if (Params::getInstance().lh_mem_save != LM_MEM_SAVE)
+        return;
+    num_hits++;
+}
+
+void MemSlotVector::report(ostream &out) {
+    int64_t total = num_hits + num_misses;
+    out << "Partial likelihood memory slots: " << size() << ", "
+        << num_hits << " hits, " << num_misses << " misses (" << num_recomputes << " recomputed after eviction)";
+    if (total > 0)
+        out << ", hit rate " << (100.0*num_hits)/total << "%";
+    out << endl;
 }
 
 /*
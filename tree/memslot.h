@@ -36,6 +36,9 @@ struct MemSlot {
     UBYTE *scale_num; // scale_num assigned to this slot
 
     PhyloNeighbor *saved_nei;
+
+    int64_t last_used; // time stamp of the last access, for LRU-aware eviction
+    int pin_epoch; // traversal in which this slot is pinned (read ahead)
 };
 
 /**
@@ -44,6 +47,8 @@ struct MemSlot {
 class MemSlotVector : public vector<MemSlot> {
 public:
 
+    MemSlotVector();
+
     /** initialize with a specified number of slots */
     void init(PhyloTree *tree, int num_slot);
 
@@ -93,8 +98,53 @@ public:
     /** restore neighbor, after calling replace */
     void restore(PhyloNeighbor *new_nei, PhyloNeighbor *old_nei);
 
+    /** start a new traversal, releasing all slots pinned by the previous one */
+    void beginTraversal();
+
+    /**
+        pin the memory assigned to nei for the current traversal,
+        so that it is only evicted if no other slot is available
+        @param nei neighbor whose computed partial_lh will be reused
+    */
+    void pin(PhyloNeighbor *nei);
+
+    /** record that a computed partial_lh is reused from memory */
+    void hit();
+
+    /** print hit/miss/recompute counters */
+    void report(ostream &out);
+
+    /** number of partial_lh reused from memory */
+    int64_t num_hits;
+
+    /** number of partial_lh that had to be computed */
+    int64_t num_misses;
+
+    /** number of partial_lh recomputed because they were evicted before */
+    int64_t num_recomputes;
+
 protected:
 
+    /** mark the slot as just used */
+    void touch(iterator it);
+
+    /**
+        find an unlocked slot to evict, minimizing the recompute cost
+        (subtree size, the number of patterns is the same for all slots)
+        divided by the time since the slot was last used
+        @param allow_pinned TRUE to also consider slots pinned for the current traversal
+    */
+    iterator findVictim(bool allow_pinned);
+
+    /** time stamp, incremented with every slot access */
+    int64_t access_time;
+
+    /** ID of the current traversal */
+    int cur_epoch;
+
+    /** neighbors whose partial_lh were evicted, to count recomputations */
+    unordered_set<PhyloNeighbor*> evicted_nei;
+
 
     /** 
         map from neighbor to slot ID for fast lookup
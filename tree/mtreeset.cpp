@@ -20,6 +20,20 @@
 #include "mtreeset.h"
 #include "alignment/alignment.h"
 #include "utils/gzstream.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined (__GNUC__) || defined(__clang__)
+#define rf_popcnt64 __builtin_popcountll
+#else
+static inline int rf_popcnt64(uint64_t a) {
+    a = a - ((a >> 1) & 0x5555555555555555ULL);
+    a = (a & 0x3333333333333333ULL) + ((a >> 2) & 0x3333333333333333ULL);
+    a = (a + (a >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (a * 0x0101010101010101ULL) >> 56;
+}
+#endif
 
 MTreeSet::MTreeSet()
 {
@@ -544,66 +558,143 @@ void MTreeSet::computeRFDist(double *rfdist, int mode, double weight_threshold)
 	// exit if less than 2 trees
 	if (size() < 2)
 		return;
-    if (verbose_mode >= VB_MED) {
-#ifdef USE_HASH_MAP
-	cout << "Using hash_map" << endl;
-#else
-	cout << "Using map" << endl;
-#endif
-    }
 	cout << "Computing Robinson-Foulds distance..." << endl;
 
-	vector<string> taxname(front()->leafNum);
-	vector<SplitIntMap*> hs_vec;
-	vector<SplitGraph*> sg_vec;
-
-	front()->getTaxaName(taxname);
-
+	RFDistEngine engine(*this, weight_threshold);
+	int n = size();
+	if (mode == RF_ADJACENT_PAIR) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+		for (int id = 0; id < n-1; id++)
+			rfdist[id] = engine.computeRFDist(id, id+1);
+		return;
+	}
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int id = 0; id < n-1; id++)
+		for (int id2 = id+1; id2 < n; id2++)
+			rfdist[(size_t)id*n + id2] = rfdist[(size_t)id2*n + id] = engine.computeRFDist(id, id2);
+}
 
-	// converting trees into split system then stored in SplitIntMap for efficiency
-	for (iterator it = begin(); it != end(); it++) {
-		SplitGraph *sg = new SplitGraph();
-		SplitIntMap *hs = new SplitIntMap();
+RFDistEngine::RFDistEngine(MTreeSet &trees, double weight_threshold) {
+	ntrees = trees.size();
+	nsplits = 0;
+	has_threshold = false;
+	nwords = 0;
+	if (ntrees == 0)
+		return;
 
-		(*it)->convertSplits(taxname, *sg);
-		// make sure that taxon 0 is included
-		for (SplitGraph::iterator sit = sg->begin(); sit != sg->end(); sit++) {
+	vector<string> taxname(trees.front()->leafNum);
+	trees.front()->getTaxaName(taxname);
+
+	// one copy of each distinct split, mapped to its ID
+	SplitGraph unique_splits;
+	SplitIntMap split_ids;
+	tree_splits.resize(ntrees);
+	tree_counted.resize(ntrees);
+	size_t total_splits = 0;
+	for (int id = 0; id < ntrees; id++) {
+		SplitGraph sg;
+		trees[id]->convertSplits(taxname, sg);
+		vector<pair<int, bool> > ids;
+		for (SplitGraph::iterator sit = sg.begin(); sit != sg.end(); sit++) {
+			// make sure that taxon 0 is included
 			if (!(*sit)->containTaxon(0)) (*sit)->invert();
-			hs->insertSplit((*sit), 1);
+			bool counted = (*sit)->getWeight() >= weight_threshold;
+			if (!counted)
+				has_threshold = true;
+			int split_id;
+			if (!split_ids.findSplit(*sit, split_id)) {
+				split_id = nsplits++;
+				split_ids.insertSplit(*sit, split_id);
+				// move the split to unique_splits
+				unique_splits.push_back(*sit);
+				*sit = NULL;
+			}
+			ids.push_back(make_pair(split_id, counted));
 		}
-		hs_vec.push_back(hs);
-		sg_vec.push_back(sg);
+		sort(ids.begin(), ids.end());
+		for (int i = 0; i < ids.size(); i++)
+			if (i == 0 || ids[i].first != ids[i-1].first) {
+				tree_splits[id].push_back(ids[i].first);
+				tree_counted[id].push_back(ids[i].second);
+			}
+		total_splits += tree_splits[id].size();
 	}
 
-	// now start the RF computation
-	int id = 0;
-	for (vector<SplitIntMap*>::iterator hsit = hs_vec.begin(); hsit+1 != hs_vec.end(); hsit++, id++) {
-		vector<SplitIntMap*>::iterator end_it = hs_vec.end();
-		if (mode == RF_ADJACENT_PAIR) end_it = hsit+2;
-		int id2 = id+1;
-		for (vector<SplitIntMap*>::iterator hsit2 = hsit+1; hsit2 != end_it; hsit2++, id2++) {
-			int diff_splits = 0;
-			SplitIntMap::iterator spit;
-			for (spit = (*hsit2)->begin(); spit != (*hsit2)->end(); spit++) {
-				if (spit->first->getWeight() >= weight_threshold && !(*hsit)->findSplit(spit->first)) diff_splits++;
-			}
-			for (spit = (*hsit)->begin(); spit != (*hsit)->end(); spit++) {
-				if (spit->first->getWeight() >= weight_threshold && !(*hsit2)->findSplit(spit->first)) diff_splits++;
-			}
-			//int rf_val = (*hsit)->size() + (*hsit2)->size() - 2*common_splits;
-			int rf_val = diff_splits;
-			if (mode == RF_ADJACENT_PAIR) 
-				rfdist[id] = rf_val;
-			else {
-				rfdist[id*size() + id2] = rfdist[id2*size() + id] = rf_val;
+	// bitmaps pay off if they are not much larger than the sorted ID vectors
+	size_t words = (nsplits + 63) / 64;
+	if (words * sizeof(uint64_t) <= 4 * (total_splits / ntrees + 1) * sizeof(int)) {
+		nwords = words;
+		bitmaps.resize(nwords * ntrees, 0);
+		if (has_threshold)
+			counted_bitmaps.resize(nwords * ntrees, 0);
+		for (int id = 0; id < ntrees; id++) {
+			uint64_t *bits = &bitmaps[id * nwords];
+			for (int i = 0; i < tree_splits[id].size(); i++) {
+				int split_id = tree_splits[id][i];
+				bits[split_id / 64] |= (uint64_t)1 << (split_id % 64);
+				if (has_threshold && tree_counted[id][i])
+					counted_bitmaps[id * nwords + split_id / 64] |= (uint64_t)1 << (split_id % 64);
 			}
 		}
+		tree_splits.clear();
+		tree_counted.clear();
 	}
-	// delete memory 
-	for (id = size()-1; id >= 0; id--) {
-		delete hs_vec[id];
-		delete sg_vec[id];
+	if (verbose_mode >= VB_MED)
+		cout << nsplits << " distinct splits in " << ntrees << " trees, using "
+			<< ((nwords) ? "split bitmaps" : "sorted split IDs") << endl;
+}
+
+int RFDistEngine::computeRFDist(int tree1, int tree2) {
+	int diff = 0;
+	if (nwords) {
+		uint64_t *a = &bitmaps[tree1 * nwords];
+		uint64_t *b = &bitmaps[tree2 * nwords];
+		if (!has_threshold) {
+			for (size_t w = 0; w < nwords; w++)
+				diff += rf_popcnt64(a[w] ^ b[w]);
+		} else {
+			uint64_t *count_a = &counted_bitmaps[tree1 * nwords];
+			uint64_t *count_b = &counted_bitmaps[tree2 * nwords];
+			for (size_t w = 0; w < nwords; w++)
+				diff += rf_popcnt64(count_a[w] & ~b[w]) + rf_popcnt64(count_b[w] & ~a[w]);
+		}
+		return diff;
 	}
+
+	// merge the sorted split IDs
+	IntVector &a = tree_splits[tree1], &b = tree_splits[tree2];
+	BoolVector &count_a = tree_counted[tree1], &count_b = tree_counted[tree2];
+	size_t i = 0, j = 0;
+	while (i < a.size() && j < b.size()) {
+		if (a[i] == b[j]) {
+			i++;
+			j++;
+		} else if (a[i] < b[j]) {
+			if (count_a[i]) diff++;
+			i++;
+		} else {
+			if (count_b[j]) diff++;
+			j++;
+		}
+	}
+	for (; i < a.size(); i++)
+		if (count_a[i]) diff++;
+	for (; j < b.size(); j++)
+		if (count_b[j]) diff++;
+	return diff;
+}
+
+void RFDistEngine::computeRFDistRows(int first_row, int nrows, double *rfdist) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int row = 0; row < nrows; row++)
+		for (int col = 0; col < ntrees; col++)
+			rfdist[(size_t)row*ntrees + col] = (first_row+row == col) ? 0 : computeRFDist(first_row+row, col);
 }
 
 
@@ -197,4 +197,64 @@ public:
     
 };
 
+/**
+    Robinson-Foulds distances within a tree set. Every distinct split of the set
+    gets an integer ID and every tree becomes a bitmap of split IDs, so that the
+    distance of two trees is the popcount of their symmetric difference.
+    If the set has too many distinct splits for bitmaps to pay off, the sorted
+    split ID vectors of two trees are merged instead.
+*/
+class RFDistEngine {
+public:
+
+    /**
+        assign split IDs to all trees
+        @param trees the tree set
+        @param weight_threshold splits with weight below this are not counted as differences
+    */
+    RFDistEngine(MTreeSet &trees, double weight_threshold = -1000);
+
+    /** @return number of trees */
+    int size() const { return ntrees; }
+
+    /** @return number of distinct splits in the tree set */
+    int getNumSplits() const { return nsplits; }
+
+    /** @return RF distance between tree1 and tree2 */
+    int computeRFDist(int tree1, int tree2);
+
+    /**
+        compute rows [first_row, first_row+nrows) of the all-pair distance matrix
+        in parallel
+        @param[out] rfdist nrows x size() distances
+    */
+    void computeRFDistRows(int first_row, int nrows, double *rfdist);
+
+protected:
+
+    /** number of trees */
+    int ntrees;
+
+    /** number of distinct splits */
+    int nsplits;
+
+    /** TRUE if some split is below the weight threshold */
+    bool has_threshold;
+
+    /** sorted split IDs of each tree, only used without bitmaps */
+    vector<IntVector> tree_splits;
+
+    /** for each entry of tree_splits, TRUE if its weight is at least the threshold */
+    vector<BoolVector> tree_counted;
+
+    /** number of 64-bit words per bitmap, 0 if bitmaps are not used */
+    size_t nwords;
+
+    /** split bitmaps of all trees, nwords per tree */
+    vector<uint64_t> bitmaps;
+
+    /** bitmaps of splits counted as differences, only with has_threshold */
+    vector<uint64_t> counted_bitmaps;
+};
+
 #endif
@@ -7,6 +7,95 @@
 
 #include "phylohmm.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// minimum number of sites per chunk when the recurrences along sites are split among threads
+#define HMM_MIN_CHUNK_SITES 1024
+
+// emission probabilities of a site in linear space, scaled such that the maximum is 1
+// return the log of the scaling factor
+static inline double scaledEmission(double* site_lh, double* emit, int ncat) {
+    double max_lh = site_lh[0];
+    for (int j = 1; j < ncat; j++)
+        if (max_lh < site_lh[j])
+            max_lh = site_lh[j];
+    for (int j = 0; j < ncat; j++)
+        emit[j] = exp(site_lh[j] - max_lh);
+    return max_lh;
+}
+
+// rescale an array by a power of 2 such that its maximum lies in [0.5,1)
+// return the log of the scaling factor
+static inline double rescaleArray(double* x, int n) {
+    double max_x = x[0];
+    int e;
+    for (int i = 1; i < n; i++)
+        if (max_x < x[i])
+            max_x = x[i];
+    frexp(max_x, &e);
+    if (e == 0)
+        return 0.0;
+    double factor = ldexp(1.0, -e);
+    for (int i = 0; i < n; i++)
+        x[i] *= factor;
+    return e * M_LN2;
+}
+
+// v_out = diag(emit) * transit * v_in, rescaled
+// return the log of the scaling factor
+static inline double stepVector(double* transit, double* emit, double* v_in, double* v_out, int ncat) {
+    for (int j = 0; j < ncat; j++) {
+        double sum = 0.0;
+        for (int l = 0; l < ncat; l++)
+            sum += transit[l] * v_in[l];
+        v_out[j] = emit[j] * sum;
+        transit += ncat;
+    }
+    return rescaleArray(v_out, ncat);
+}
+
+// m_out = diag(emit) * transit * m_in for ncat * ncat matrices, rescaled
+// return the log of the scaling factor
+static inline double stepMatrix(double* transit, double* emit, double* m_in, double* m_out, int ncat) {
+    for (int j = 0; j < ncat; j++) {
+        double* row = m_out + j * ncat;
+        for (int m = 0; m < ncat; m++)
+            row[m] = 0.0;
+        for (int l = 0; l < ncat; l++) {
+            double t = emit[j] * transit[l];
+            double* m_row = m_in + l * ncat;
+            for (int m = 0; m < ncat; m++)
+                row[m] += t * m_row[m];
+        }
+        transit += ncat;
+    }
+    return rescaleArray(m_out, ncat * ncat);
+}
+
+// v_out = v_in (x) m in the (max,+) semiring, i.e. v_out[j] = max_l (m[j][l] + v_in[l])
+static inline void maxPlusVector(double* m, double* v_in, double* v_out, int ncat) {
+    for (int j = 0; j < ncat; j++) {
+        double v = m[0] + v_in[0];
+        for (int l = 1; l < ncat; l++)
+            if (v < m[l] + v_in[l])
+                v = m[l] + v_in[l];
+        v_out[j] = v;
+        m += ncat;
+    }
+}
+
+// number of chunks the recurrences along the sites are split into
+static inline int getNumChunks(int nsite) {
+#ifdef _OPENMP
+    int nchunk = min(omp_get_max_threads(), nsite / HMM_MIN_CHUNK_SITES);
+    return max(nchunk, 1);
+#else
+    return 1;
+#endif
+}
+
 PhyloHmm::PhyloHmm() {
     nsite = ncat = 0;
     prob = NULL;
@@ -75,76 +164,260 @@ PhyloHmm::~PhyloHmm() {
 // note: site_like_cat[i * ntree + j] : log-likelihood of site nsite-i-1 and tree j
 double PhyloHmm::computeBackLike(bool showInterRst) {
     int showlines = 5;
-    size_t pre_k = 0;
-    size_t k;
     size_t i,j;
-    double* pre_work;
-    double* work;
-    double* site_lh_arr;
-    double* transit_arr;
-    site_lh_arr = site_like_cat;
-    memcpy(work_arr, site_lh_arr, sizeof(double) * ncat);
-    pre_work = work_arr;
-    for (i = 1; i < nsite; i++) {
-        k = (pre_k + 1) % 2;
-        work = work_arr + k * ncat;
-        site_lh_arr += ncat;
-        transit_arr = modelHmm->getTransitLog(nsite-i);
-        for (j = 0; j < ncat; j++) {
-            work[j] = logDotProd(transit_arr, pre_work, ncat) + site_lh_arr[j];
-            transit_arr += ncat;
-        }
-        pre_k = k;
-        pre_work = work;
+    double* pre_work = work_arr;
+    if (showInterRst) {
         // show the intermediate results
-        if (showInterRst && i <= showlines) {
+        DoubleVector steps(nsite * ncat);
+        computeSumProduct(false, site_like_cat, pre_work, &steps[0]);
+        for (i = 1; i < nsite && i <= showlines; i++) {
             for (j = 0; j < ncat; j++) {
                 if (j > 0)
                     cout << "\t";
-                cout << work[j];
+                cout << steps[(nsite - 1 - i) * ncat + j];
             }
             cout << endl;
         }
+    } else {
+        computeSumProduct(false, site_like_cat, pre_work, NULL);
     }
     return logDotProd(prob_log, pre_work, ncat);
 }
 
+// compute the transition matrices in linear space for all sites
+void PhyloHmm::computeTransitLinear() {
+    vector<double*> transit_logs;
+    double* pre_transit_log = NULL;
+    size_t sq_ncat = ncat * ncat;
+    int id = -1;
+    transit_lin.clear();
+    transit_lin_id.resize(nsite);
+    for (int i = 1; i < nsite; i++) {
+        double* transit_log = modelHmm->getTransitLog(i);
+        if (transit_log != pre_transit_log) {
+            id = find(transit_logs.begin(), transit_logs.end(), transit_log) - transit_logs.begin();
+            if (id == transit_logs.size()) {
+                transit_logs.push_back(transit_log);
+                for (size_t k = 0; k < sq_ncat; k++)
+                    transit_lin.push_back(exp(transit_log[k]));
+            }
+            pre_transit_log = transit_log;
+        }
+        transit_lin_id[i] = id;
+    }
+}
+
+// compute the recurrence v_q = diag(exp(L_q)) * exp(T_q) * v_{q-1} along the sites in scaled linear space.
+// The steps are split into one chunk per thread: the first chunk propagates v_0 while
+// the others compute the product of their matrices, the start vectors of the chunks are then
+// obtained sequentially from these products, and the chunks are finally re-run in parallel
+// from their start vectors if all intermediate vectors are needed.
+void PhyloHmm::computeSumProduct(bool forward, double* init_log, double* final_log, double* all_steps) {
+    int nstep = nsite - 1;
+    int nchunk = getNumChunks(nstep);
+    int chunk_size = (nstep + nchunk - 1) / nchunk;
+    int sq_ncat = ncat * ncat;
+    int c, j;
+
+    // for each chunk: the start vector, the end vector, the product of the matrices and their log scaling factors
+    DoubleVector chunk_vec((nchunk + 1) * ncat), chunk_vec_scale(nchunk + 1);
+    DoubleVector chunk_end(nchunk * ncat), chunk_end_scale(nchunk);
+    DoubleVector chunk_mat(nchunk * sq_ncat), chunk_mat_scale(nchunk);
+    
+    computeTransitLinear();
+
+    // propagate the start vector of chunk c through its steps
+    auto propagateVector = [&](int c) {
+        DoubleVector work(3 * ncat);
+        double* emit = &work[0];
+        double* v_in = &work[ncat];
+        double* v_out = &work[2 * ncat];
+        double scale = chunk_vec_scale[c];
+        int last = min(nstep, (c + 1) * chunk_size);
+        memcpy(v_in, &chunk_vec[c * ncat], sizeof(double) * ncat);
+        for (int q = c * chunk_size + 1; q <= last; q++) {
+            scale += scaledEmission(site_like_cat + (forward ? nsite - q : q) * ncat, emit, ncat);
+            scale += stepVector(&transit_lin[transit_lin_id[forward ? q : nsite - q] * sq_ncat], emit, v_in, v_out, ncat);
+            if (all_steps) {
+                double* out = all_steps + (forward ? q : nsite - 1 - q) * ncat;
+                for (int k = 0; k < ncat; k++)
+                    out[k] = log(v_out[k]) + scale;
+            }
+            swap(v_in, v_out);
+        }
+        memcpy(&chunk_end[c * ncat], v_in, sizeof(double) * ncat);
+        chunk_end_scale[c] = scale;
+    };
+
+    // compute the product of the matrices of chunk c
+    auto multiplyChunk = [&](int c) {
+        DoubleVector work(ncat + 2 * sq_ncat, 0.0);
+        double* emit = &work[0];
+        double* m_in = &work[ncat];
+        double* m_out = &work[ncat + sq_ncat];
+        double scale = 0.0;
+        int last = min(nstep, (c + 1) * chunk_size);
+        for (int k = 0; k < ncat; k++)
+            m_in[k * ncat + k] = 1.0;
+        for (int q = c * chunk_size + 1; q <= last; q++) {
+            scale += scaledEmission(site_like_cat + (forward ? nsite - q : q) * ncat, emit, ncat);
+            scale += stepMatrix(&transit_lin[transit_lin_id[forward ? q : nsite - q] * sq_ncat], emit, m_in, m_out, ncat);
+            swap(m_in, m_out);
+        }
+        memcpy(&chunk_mat[c * sq_ncat], m_in, sizeof(double) * sq_ncat);
+        chunk_mat_scale[c] = scale;
+    };
+
+    chunk_vec_scale[0] = scaledEmission(init_log, &chunk_vec[0], ncat);
+    if (all_steps)
+        memcpy(all_steps + (forward ? 0 : nstep * ncat), init_log, sizeof(double) * ncat);
+
+    double* final_vec = &chunk_end[0];
+    double final_scale = chunk_end_scale[0];
+    if (nchunk == 1) {
+        propagateVector(0);
+        final_scale = chunk_end_scale[0];
+    } else {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) num_threads(nchunk)
+#endif
+        for (c = 0; c < nchunk; c++) {
+            if (c == 0)
+                propagateVector(c);
+            else
+                multiplyChunk(c);
+        }
+
+        // the start vectors of the chunks
+        DoubleVector ones(ncat, 1.0);
+        memcpy(&chunk_vec[ncat], &chunk_end[0], sizeof(double) * ncat);
+        chunk_vec_scale[1] = chunk_end_scale[0];
+        for (c = 1; c < nchunk; c++) {
+            chunk_vec_scale[c + 1] = chunk_vec_scale[c] + chunk_mat_scale[c]
+                + stepVector(&chunk_mat[c * sq_ncat], &ones[0], &chunk_vec[c * ncat], &chunk_vec[(c + 1) * ncat], ncat);
+        }
+
+        if (all_steps) {
+            // re-run the chunks from their start vectors to get all intermediate vectors
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) num_threads(nchunk - 1)
+#endif
+            for (c = 1; c < nchunk; c++)
+                propagateVector(c);
+            final_vec = &chunk_end[(nchunk - 1) * ncat];
+            final_scale = chunk_end_scale[nchunk - 1];
+        } else {
+            final_vec = &chunk_vec[nchunk * ncat];
+            final_scale = chunk_vec_scale[nchunk];
+        }
+    }
+    for (j = 0; j < ncat; j++)
+        final_log[j] = log(final_vec[j]) + final_scale;
+}
+
 // path with max log-likelihood
+// the sites are split into one chunk per thread: the chunks compute their (max,+) matrix products
+// in parallel, the start vectors of the chunks are then obtained sequentially,
+// and the chunks are finally traced in parallel from their start vectors
 double PhyloHmm::computeMaxPath() {
-    size_t pre_k = 0;
-    size_t i,j,k,l;
+    size_t i,j;
+    int c;
+    int nstep = nsite - 1;
+    int nchunk = getNumChunks(nstep);
+    int chunk_size = (nstep + nchunk - 1) / nchunk;
+    int sq_ncat = ncat * ncat;
     double* pre_work;
-    double* work;
-    double* site_lh_arr;
-    double* transit_arr;
-    int* next_cat_arr;
     double v;
-    site_lh_arr = site_like_cat;
-    memcpy(work_arr, site_lh_arr, sizeof(double) * ncat);
-    pre_work = work_arr;
-    
-    for (i = 1; i < nsite; i++) {
-        k = (pre_k + 1) % 2;
-        work = work_arr + k * ncat;
-        site_lh_arr += ncat;
-        transit_arr = modelHmm->getTransitLog(i);
-        next_cat_arr = next_cat + (nsite - i - 1) * ncat;
-        for (j = 0; j < ncat; j++) {
-            work[j] = transit_arr[0] + pre_work[0];
-            next_cat_arr[j] = 0;
-            for (l = 1; l < ncat; l++) {
-                v = transit_arr[l] + pre_work[l];
-                if (work[j] < v) {
-                    work[j] = v;
-                    next_cat_arr[j] = (int) l;
+
+    // start vectors, end vectors and (max,+) matrix products of the chunks
+    DoubleVector chunk_vec(nchunk * ncat);
+    DoubleVector chunk_end(nchunk * ncat);
+    DoubleVector chunk_mat(nchunk * sq_ncat);
+    memcpy(&chunk_vec[0], site_like_cat, sizeof(double) * ncat);
+
+    // trace the start vector of chunk c through its steps
+    auto traceChunk = [&](int c) {
+        DoubleVector work_vec(2 * ncat);
+        double* pre_work = &work_vec[0];
+        double* work = &work_vec[ncat];
+        double* site_lh_arr;
+        double* transit_arr;
+        int* next_cat_arr;
+        double v;
+        int last = min(nstep, (c + 1) * chunk_size);
+        memcpy(pre_work, &chunk_vec[c * ncat], sizeof(double) * ncat);
+        for (int q = c * chunk_size + 1; q <= last; q++) {
+            site_lh_arr = site_like_cat + q * ncat;
+            transit_arr = modelHmm->getTransitLog(q);
+            next_cat_arr = next_cat + (nsite - q - 1) * ncat;
+            for (int k = 0; k < ncat; k++) {
+                work[k] = transit_arr[0] + pre_work[0];
+                next_cat_arr[k] = 0;
+                for (int l = 1; l < ncat; l++) {
+                    v = transit_arr[l] + pre_work[l];
+                    if (work[k] < v) {
+                        work[k] = v;
+                        next_cat_arr[k] = l;
+                    }
+                }
+                work[k] += site_lh_arr[k];
+                transit_arr += ncat;
+            }
+            swap(pre_work, work);
+        }
+        memcpy(&chunk_end[c * ncat], pre_work, sizeof(double) * ncat);
+    };
+
+    // compute the (max,+) product of the matrices of chunk c
+    auto multiplyChunk = [&](int c) {
+        DoubleVector work(2 * sq_ncat, -INFINITY);
+        double* m_in = &work[0];
+        double* m_out = &work[sq_ncat];
+        int last = min(nstep, (c + 1) * chunk_size);
+        for (int k = 0; k < ncat; k++)
+            m_in[k * ncat + k] = 0.0;
+        for (int q = c * chunk_size + 1; q <= last; q++) {
+            double* site_lh_arr = site_like_cat + q * ncat;
+            double* transit_arr = modelHmm->getTransitLog(q);
+            for (int k = 0; k < ncat; k++) {
+                double* row = m_out + k * ncat;
+                for (int m = 0; m < ncat; m++) {
+                    double v = transit_arr[0] + m_in[m];
+                    for (int l = 1; l < ncat; l++)
+                        if (v < transit_arr[l] + m_in[l * ncat + m])
+                            v = transit_arr[l] + m_in[l * ncat + m];
+                    row[m] = v + site_lh_arr[k];
                 }
+                transit_arr += ncat;
             }
-            work[j] += site_lh_arr[j];
-            transit_arr += ncat;
+            swap(m_in, m_out);
         }
-        pre_k = k;
-        pre_work = work;
+        memcpy(&chunk_mat[c * sq_ncat], m_in, sizeof(double) * sq_ncat);
+    };
+
+    if (nchunk == 1) {
+        traceChunk(0);
+    } else {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) num_threads(nchunk)
+#endif
+        for (c = 0; c < nchunk; c++) {
+            if (c == 0)
+                traceChunk(c);
+            else
+                multiplyChunk(c);
+        }
+        // the start vectors of the other chunks
+        memcpy(&chunk_vec[ncat], &chunk_end[0], sizeof(double) * ncat);
+        for (c = 1; c < nchunk - 1; c++)
+            maxPlusVector(&chunk_mat[c * sq_ncat], &chunk_vec[c * ncat], &chunk_vec[(c + 1) * ncat], ncat);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) num_threads(nchunk - 1)
+#endif
+        for (c = 1; c < nchunk; c++)
+            traceChunk(c);
     }
+    pre_work = &chunk_end[(nchunk - 1) * ncat];
     
     // get the start with the max likelihood
     double max_log_like = prob_log[0] + pre_work[0];
@@ -175,31 +448,11 @@ double PhyloHmm::computeMaxPath() {
 
 // optimize probabilities using EM algorithm
 double PhyloHmm::optimizeProbEM() {
-    size_t pre_k = 0;
-    size_t k;
-    size_t i,j;
-    double* pre_work;
-    double* work;
-    double* site_lh_arr;
-    double* transit_arr;
-    site_lh_arr = site_like_cat;
-    memcpy(work_arr, site_lh_arr, sizeof(double) * ncat);
-    pre_work = work_arr;
-    for (i = 1; i < nsite; i++) {
-        k = pre_k ^ 1;
-        work = work_arr + k * ncat;
-        site_lh_arr += ncat;
-        transit_arr = modelHmm->getTransitLog(nsite-i);
-        for (j = 0; j < ncat; j++) {
-            work[j] = logDotProd(transit_arr, pre_work, ncat) + site_lh_arr[j];
-            transit_arr += ncat;
-        }
-        pre_k = k;
-        pre_work = work;
-    }
+    size_t j;
+    double* pre_work = work_arr;
+    double* work = work_arr + ncat;
+    computeSumProduct(false, site_like_cat, pre_work, NULL);
     
-    k = pre_k ^ 1;
-    work = work_arr + k * ncat;
     // compute the max among prob_log[0]+work[0],prob_log[1]+work[1],...
     for (j = 0; j < ncat; j++) {
         work[j] = prob_log[j] + pre_work[j];
@@ -385,55 +638,15 @@ void PhyloHmm::computeLogProb() {
 // prerequisite: array site_like_cat has been updated (i.e. computeLogLikelihoodSiteTree() has been invoked)
 // and save all the intermediate results to the bwd_array array
 double PhyloHmm::computeBackLikeArray() {
-    size_t pre_k = 0;
-    size_t k;
-    double* pre_work;
-    double* work;
-    double* site_lh_arr;
-    double* transit_arr;
-    double score;
-    site_lh_arr = site_like_cat;
-    work = bwd_array + (nsite - 1) * ncat;
-    memcpy(work, site_lh_arr, sizeof(double) * ncat);
-    for (int i = nsite - 1; i >= 1; i--) {
-        pre_work = work;
-        work = bwd_array + (i - 1) * ncat;
-        transit_arr = modelHmm->getTransitLog(i);
-        site_lh_arr += ncat;
-        for (int j = 0; j < ncat; j++) {
-            work[j] = logDotProd(transit_arr, pre_work, ncat) + site_lh_arr[j];
-            transit_arr += ncat;
-        }
-    }
-    score = logDotProd(prob_log, work, ncat);
-    return score;
+    computeSumProduct(false, site_like_cat, work_arr, bwd_array);
+    return logDotProd(prob_log, bwd_array, ncat);
 }
 
 // compute forward log-likelihood
 // and save all the intermediate results to the fwd_array array
 double PhyloHmm::computeFwdLikeArray() {
-    size_t pre_k = 0;
-    size_t k;
-    double* pre_work;
-    double* work;
-    double* site_lh_arr;
-    double* transit_arr;
-    double score;
-    site_lh_arr = site_like_cat + (nsite-1) * ncat;
-    work = fwd_array;
-    memcpy(work, prob_log, sizeof(double) * ncat);
-    for (int i = 1; i < nsite; i++) {
-        pre_work = work;
-        work += ncat;
-        transit_arr = modelHmm->getTransitLog(i);
-        for (int j = 0; j < ncat; j++) {
-            work[j] = logDotProd(transit_arr, pre_work, ncat) + site_lh_arr[j];
-            transit_arr += ncat;
-        }
-        site_lh_arr -= ncat;
-    }
-    score = logDotProd(site_lh_arr, work, ncat);
-    return score;
+    computeSumProduct(true, prob_log, work_arr, fwd_array);
+    return logDotProd(site_like_cat, fwd_array + (nsite - 1) * ncat, ncat);
 }
 
 // verify the backLikeArray and FwdLikeArray
@@ -451,84 +664,79 @@ void PhyloHmm::checkEachSiteBackFwdLikeArray() {
 
 // compute the marginal probabilities for each site
 void PhyloHmm::computeMarginalProb(ostream* out) {
-    double score;
-    double* f_array = fwd_array;
-    double* b_array = bwd_array;
-    double* mprob = marginal_prob;
     int i;
     
     computeBackLikeArray();
     computeFwdLikeArray();
 
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (i=0; i<nsite; i++) {
+        double* f_array = fwd_array + i * ncat;
+        double* b_array = bwd_array + i * ncat;
+        double* mprob = marginal_prob + i * ncat;
+        double score = logDotProd(f_array, b_array, ncat);
+        for (int j=0; j<ncat; j++)
+            mprob[j] = exp(f_array[j]+b_array[j]-score);
+    }
+
     if (out != NULL) {
+        double* mprob = marginal_prob;
         *out << "# Marginal probabilities" << endl;
         *out << "Site";
         for (i=0; i<ncat; i++) {
             *out << "\tCat_" << i+1;
         }
         *out << endl;
-    }
-    for (i=0; i<nsite; i++) {
-        if (out != NULL)
+        for (i=0; i<nsite; i++) {
             *out << i+1;
-        score = logDotProd(f_array, b_array, ncat);
-        for (int j=0; j<ncat; j++) {
-            mprob[j] = exp(f_array[j]+b_array[j]-score);
-            if (out != NULL)
+            for (int j=0; j<ncat; j++)
                 *out << "\t" << mprob[j];
-        }
-        if (out != NULL)
             *out << endl;
-        f_array += ncat;
-        b_array += ncat;
-        mprob += ncat;
+            mprob += ncat;
+        }
     }
 }
 
 // compute the marginal probabilities for transitions between every pair of sites
 void PhyloHmm::computeMarginalTransitProb() {
-    double score, sum;
-    double* f_array = fwd_array;
-    double* b_array = bwd_array + ncat;
-    double* catlike_array = site_like_cat + ncat * (nsite - 1);
-    double* t_array;
-    double* mprob = marginal_tran;
-    double* t1 = new double[ncat * ncat];
-    double* t2 = new double[ncat * ncat];
     int sq_ncat = ncat * ncat;
-    int k;
     
     computeBackLikeArray();
     computeFwdLikeArray();
 
-    // cout << "Marginal transition probabilities:" << endl;
-    for (int i=1; i<=nsite-1; i++) {
-        // cout << "(" << i << "," << i+1 << ")";
-        t_array = modelHmm->getTransitLog(i);
-        k = 0;
-        for (int j1=0; j1<ncat; j1++) {
-            for (int j2=0; j2<ncat; j2++) {
-                t1[k] = f_array[j1] + catlike_array[j1];
-                t2[k] = b_array[j2] + t_array[k];
-                k++;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        double* t1 = new double[sq_ncat];
+        double* t2 = new double[sq_ncat];
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int i=1; i<=nsite-1; i++) {
+            double* f_array = fwd_array + (i - 1) * ncat;
+            double* b_array = bwd_array + i * ncat;
+            double* catlike_array = site_like_cat + ncat * (nsite - i);
+            double* t_array = modelHmm->getTransitLog(i);
+            double* mprob = marginal_tran + (size_t)(i - 1) * sq_ncat;
+            double score;
+            int k = 0;
+            for (int j1=0; j1<ncat; j1++) {
+                for (int j2=0; j2<ncat; j2++) {
+                    t1[k] = f_array[j1] + catlike_array[j1];
+                    t2[k] = b_array[j2] + t_array[k];
+                    k++;
+                }
             }
+            score = logDotProd(t1, t2, sq_ncat);
+            for (k=0; k<sq_ncat; k++)
+                mprob[k] = exp(t1[k] + t2[k] - score);
         }
-        score = logDotProd(t1, t2, sq_ncat);
-        // cout << "[" << score << "]";
-        sum = 0.0;
-        for (k=0; k<sq_ncat; k++) {
-            mprob[k] = exp(t1[k] + t2[k] - score);
-            sum += mprob[k];
-            // cout << " " << mprob[k];
-        }
-        // cout << " {" << sum << "}" << endl;
-        f_array += ncat;
-        b_array += ncat;
-        catlike_array -= ncat;
-        mprob += ncat * ncat;
+        delete[] t1;
+        delete[] t2;
     }
-    delete[] t1;
-    delete[] t2;
 }
 
 void PhyloHmm::showSiteLikeCat() {
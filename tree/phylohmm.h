@@ -18,34 +18,22 @@ using namespace std;
 // compute the log of dotproduct of the logorithm arrays
 inline double logDotProd(double* ln_x, double* ln_y, int n) {
     double max;
-    double max_i;
+    double w;
     size_t i;
-    double* w;
     double ans;
     
-    w = new double[n];
-    for (i = 0; i < n; i++) {
-        w[i] = ln_x[i] + ln_y[i];
-    }
     // find the max
-    max = w[0];
-    max_i = 0;
+    max = ln_x[0] + ln_y[0];
     for (i = 1; i < n; i++) {
-        if (max < w[i]) {
-            max = w[i];
-            max_i = i;
-        }
+        w = ln_x[i] + ln_y[i];
+        if (max < w)
+            max = w;
     }
     // compute the dotproduct
     ans = 0.0;
-    for (i = 0; i < max_i; i++) {
-        ans += exp(w[i] - max);
-    }
-    ans += 1.0;
-    for (i = max_i+1; i < n; i++) {
-        ans += exp(w[i] - max);
+    for (i = 0; i < n; i++) {
+        ans += exp(ln_x[i] + ln_y[i] - max);
     }
-    delete[] w;
     return log(ans) + max;
 }
 
@@ -167,5 +155,24 @@ private:
 
     // compute the log values of prob
     void computeLogProb();
+
+    // compute the transition matrices in linear space for all sites
+    void computeTransitLinear();
+
+    // compute the recurrence v_q = diag(exp(L_q)) * exp(T_q) * v_{q-1}, q = 1 ... nsite-1,
+    // in scaled linear space, where L_q is a row of site_like_cat and T_q a transition matrix.
+    // The sites are split into chunks processed in parallel (parallel prefix of the chunk matrices)
+    // forward = false : T_q = getTransitLog(nsite-q), L_q = row q, v_q is saved at site nsite-1-q
+    // forward = true  : T_q = getTransitLog(q), L_q = row nsite-q, v_q is saved at site q
+    // init_log : log values of v_0
+    // final_log : (output) log values of v_{nsite-1}
+    // all_steps : (output) if not NULL, log values of all v_q
+    void computeSumProduct(bool forward, double* init_log, double* final_log, double* all_steps);
+
+    // transition matrices in linear space, one ncat * ncat block for each distinct matrix
+    DoubleVector transit_lin;
+
+    // transit_lin_id[i] : block in transit_lin of getTransitLog(i)
+    IntVector transit_lin_id;
 };
 #endif
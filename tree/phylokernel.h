@@ -69,6 +69,34 @@ Numeric PhyloTree::dotProductSIMD(Numeric *x, Numeric *y, int size) {
     return horizontal_add(res);
 }
 
+template <class Numeric, class VectorClass>
+void PhyloTree::dotProductMultiSIMD(Numeric *x, Numeric *y, size_t y_stride, int ny, int size, double *res) {
+    int j = 0;
+    // 4 rows of y at a time to reuse each load of x
+    for (; j+4 <= ny; j += 4) {
+        Numeric *y0 = y + j*y_stride, *y1 = y0 + y_stride, *y2 = y1 + y_stride, *y3 = y2 + y_stride;
+        VectorClass r0(0.0), r1(0.0), r2(0.0), r3(0.0);
+        for (int i = 0; i < size; i += VectorClass::size()) {
+            VectorClass xi = VectorClass().load_a(&x[i]);
+            r0 = mul_add(xi, VectorClass().load_a(&y0[i]), r0);
+            r1 = mul_add(xi, VectorClass().load_a(&y1[i]), r1);
+            r2 = mul_add(xi, VectorClass().load_a(&y2[i]), r2);
+            r3 = mul_add(xi, VectorClass().load_a(&y3[i]), r3);
+        }
+        res[j] += horizontal_add(r0);
+        res[j+1] += horizontal_add(r1);
+        res[j+2] += horizontal_add(r2);
+        res[j+3] += horizontal_add(r3);
+    }
+    for (; j < ny; j++) {
+        Numeric *yj = y + j*y_stride;
+        VectorClass r(0.0);
+        for (int i = 0; i < size; i += VectorClass::size())
+            r = mul_add(VectorClass().load_a(&x[i]), VectorClass().load_a(&yj[i]), r);
+        res[j] += horizontal_add(r);
+    }
+}
+
 /************************************************************************************************
  *
  *   Highly optimized vectorized versions of likelihood functions
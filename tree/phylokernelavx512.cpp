@@ -21,6 +21,7 @@
 #define KERNEL_FIX_STATES
 #include "phylokernelnew.h"
 #include "phylokernelnonrev.h"
+#include "phylokernelfloat.h"
 
 
 #if !defined ( __AVX512F__ ) && !defined ( __AVX512__ )
@@ -30,10 +31,13 @@
 void PhyloTree::setDotProductAVX512() {
 #ifdef BOOT_VAL_FLOAT
 		dotProduct = &PhyloTree::dotProductSIMD<float, Vec16f>;
+		dotProductMulti = &PhyloTree::dotProductMultiSIMD<float, Vec16f>;
 #else
 		dotProduct = &PhyloTree::dotProductSIMD<double, Vec8d>;
+		dotProductMulti = &PhyloTree::dotProductMultiSIMD<double, Vec8d>;
 #endif
         dotProductDouble = &PhyloTree::dotProductSIMD<double, Vec8d>;
+        dotProductMultiDouble = &PhyloTree::dotProductMultiSIMD<double, Vec8d>;
 }
 
 void PhyloTree::setLikelihoodKernelAVX512() {
@@ -88,6 +92,45 @@ void PhyloTree::setLikelihoodKernelAVX512() {
         return;
     }
 
+    if (mixed_precision) {
+        // single-precision partial likelihoods (--mixed-precision)
+        vector_size = 16;
+        computeLikelihoodDervMixlenPointer = NULL;
+        computeLikelihoodFromBufferPointer = NULL;
+        if (safe_numeric) {
+            switch (aln->num_states) {
+            case 4:
+                computeLikelihoodBranchPointer  = &PhyloTree::computeLikelihoodBranchFloatSIMD <Vec16f, Vec8d, SAFE_LH, 4, true>;
+                computeLikelihoodDervPointer    = &PhyloTree::computeLikelihoodDervFloatSIMD   <Vec16f, Vec8d, SAFE_LH, 4, true>;
+                computePartialLikelihoodPointer = &PhyloTree::computePartialLikelihoodFloatSIMD<Vec16f, Vec8d, SAFE_LH, 4, true>;
+                break;
+            case 20:
+                computeLikelihoodBranchPointer  = &PhyloTree::computeLikelihoodBranchFloatSIMD <Vec16f, Vec8d, SAFE_LH, 20, true>;
+                computeLikelihoodDervPointer    = &PhyloTree::computeLikelihoodDervFloatSIMD   <Vec16f, Vec8d, SAFE_LH, 20, true>;
+                computePartialLikelihoodPointer = &PhyloTree::computePartialLikelihoodFloatSIMD<Vec16f, Vec8d, SAFE_LH, 20, true>;
+                break;
+            default:
+                ASSERT(0 && "Mixed precision only supported for DNA and protein");
+            }
+        } else {
+            switch (aln->num_states) {
+            case 4:
+                computeLikelihoodBranchPointer  = &PhyloTree::computeLikelihoodBranchFloatSIMD <Vec16f, Vec8d, NORM_LH, 4, true>;
+                computeLikelihoodDervPointer    = &PhyloTree::computeLikelihoodDervFloatSIMD   <Vec16f, Vec8d, NORM_LH, 4, true>;
+                computePartialLikelihoodPointer = &PhyloTree::computePartialLikelihoodFloatSIMD<Vec16f, Vec8d, NORM_LH, 4, true>;
+                break;
+            case 20:
+                computeLikelihoodBranchPointer  = &PhyloTree::computeLikelihoodBranchFloatSIMD <Vec16f, Vec8d, NORM_LH, 20, true>;
+                computeLikelihoodDervPointer    = &PhyloTree::computeLikelihoodDervFloatSIMD   <Vec16f, Vec8d, NORM_LH, 20, true>;
+                computePartialLikelihoodPointer = &PhyloTree::computePartialLikelihoodFloatSIMD<Vec16f, Vec8d, NORM_LH, 20, true>;
+                break;
+            default:
+                ASSERT(0 && "Mixed precision only supported for DNA and protein");
+            }
+        }
+        return;
+    }
+
     if ((model_factory && !model_factory->model->isReversible()) || params->kernel_nonrev) {
         // if nonreversible model
         switch (aln->num_states) {
@@ -0,0 +1,576 @@
+/*
+ * phylokernelfloat.h
+ * Mixed-precision kernel (--mixed-precision): partial likelihoods are stored
+ * and propagated in single precision, twice as many patterns per SIMD vector
+ * and half the memory traffic of the double kernel. Transition matrices are
+ * computed in double, per-category site likelihoods, site log-likelihoods and
+ * branch-length derivatives are accumulated in double.
+ *
+ * Must be included after the KERNEL_FIX_STATES version of phylokernelnew.h,
+ * whose helper functions are reused with Numeric = float.
+ */
+
+#ifndef PHYLOKERNELFLOAT_H_
+#define PHYLOKERNELFLOAT_H_
+
+#include "phylotree.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+/**
+    rescale single-precision partial likelihoods of VectorClass::size() patterns,
+    whose maximum absolute value dropped below FLOAT_SCALING_THRESHOLD
+    @param partial_lh partial likelihoods of VectorClass::size() patterns
+    @param invar likelihoods of invariant sites (double)
+    @param[in,out] scale_num scaling counters of the first pattern
+    @param ncat_mix number of rate categories times mixture classes
+*/
+template <class VectorClass, class DoubleVector, const bool SAFE_NUMERIC, const size_t nstates>
+inline void scaleFloatLikelihood(VectorClass *partial_lh, double *invar, UBYTE *scale_num, size_t ncat_mix) {
+    const size_t VS = VectorClass::size();
+    size_t nblock = SAFE_NUMERIC ? ncat_mix : 1;
+    size_t len = SAFE_NUMERIC ? nstates : nstates*ncat_mix;
+    // only scale for non-constant sites
+    auto variant = (compress(DoubleVector().load_a(invar), DoubleVector().load_a(invar+VS/2)) == 0.0f);
+    for (size_t c = 0; c < nblock; c++) {
+        VectorClass lh_max = 0.0f;
+        for (size_t x = 0; x < len; x++)
+            lh_max = max(lh_max, abs(partial_lh[x]));
+        auto underflown = (lh_max < (float)FLOAT_SCALING_THRESHOLD) & variant;
+        if (horizontal_or(underflown)) {
+            for (size_t x = 0; x < VS; x++)
+            if (underflown[x]) {
+                float *lh = (float*)partial_lh + x;
+                for (size_t i = 0; i < len; i++)
+                    lh[i*VS] = ldexp(lh[i*VS], FLOAT_SCALING_THRESHOLD_EXP);
+                if (SAFE_NUMERIC)
+                    scale_num[x*ncat_mix+c] += 1;
+                else
+                    scale_num[x] += 1;
+            }
+        }
+        partial_lh += len;
+    }
+}
+
+/**
+    @return tip state of a pattern, STATE_UNKNOWN for padded patterns
+*/
+#define FLOAT_KERNEL_TIP_STATE(ptn, leaf_id, stateRow) \
+    (((ptn) < orig_nptn) ? ((stateRow != nullptr) ? (int)stateRow[ptn] : (int)(aln->at(ptn))[leaf_id]) : (int)aln->STATE_UNKNOWN)
+
+template <class VectorClass, class DoubleVector, const bool SAFE_NUMERIC, const int nstates, const bool FMA>
+void PhyloTree::computePartialLikelihoodFloatSIMD(TraversalInfo &info, size_t ptn_lower, size_t ptn_upper, int packet_id) {
+    PhyloNeighbor *dad_branch = info.dad_branch;
+    PhyloNode *dad = info.dad;
+    ASSERT(dad);
+    PhyloNode *node = (PhyloNode*)(dad_branch->node);
+    if (node->isLeaf())
+        return;
+
+    const size_t VS = VectorClass::size();
+    const size_t states_square = nstates*nstates;
+    size_t orig_nptn = aln->size();
+    size_t ncat = site_rate->getNRate();
+    size_t nmixture = model->getNMixtures();
+    size_t ncat_mix = (model_factory->fused_mix_rate) ? ncat : ncat*nmixture;
+    size_t mix_addr[ncat_mix];
+    size_t denom = (model_factory->fused_mix_rate) ? 1 : ncat;
+    for (size_t c = 0; c < ncat_mix; c++)
+        mix_addr[c] = (c/denom)*states_square;
+    size_t block = nstates * ncat_mix;
+    size_t nchild = node->degree()-1;
+    size_t num_leaves = 0;
+    FOR_NEIGHBOR_IT(node, dad, it) {
+        ASSERT(dad_branch->partial_lh != ((PhyloNeighbor*)*it)->partial_lh);
+        if ((*it)->node->isLeaf())
+            num_leaves++;
+    }
+
+    // transition matrices are computed in double by computePartialInfo
+    double *echildren = info.echildren;
+    double *partial_lh_leaves = info.partial_lh_leaves;
+    if (Params::getInstance().buffer_mem_save) {
+        echildren = aligned_alloc<double>(get_safe_upper_limit(block*nstates*nchild));
+        if (num_leaves > 0)
+            partial_lh_leaves = aligned_alloc<double>(get_safe_upper_limit((aln->STATE_UNKNOWN+1)*block*num_leaves));
+        double *buffer_tmp = aligned_alloc<double>(nstates);
+        computePartialInfo<DoubleVector, nstates>(info, (DoubleVector*)buffer_tmp, echildren, partial_lh_leaves);
+        aligned_free(buffer_tmp);
+    }
+
+    // single-precision copies of transition and inverse eigenvector matrices
+    size_t echildren_size = get_safe_upper_limit_float(block*nstates*nchild);
+    float *echildren_float = aligned_alloc<float>(echildren_size + get_safe_upper_limit_float(nmixture*states_square));
+    float *inv_evec_float = echildren_float + echildren_size;
+    for (size_t i = 0; i < block*nstates*nchild; i++)
+        echildren_float[i] = echildren[i];
+    double *inv_evec = model->getInverseEigenvectors();
+    ASSERT(inv_evec);
+    for (size_t i = 0; i < nmixture*states_square; i++)
+        inv_evec_float[i] = inv_evec[i];
+
+    // per-packet buffer at the end of buffer_partial_lh, same region as the double kernel
+    size_t thread_buf_size = (2*block+nstates)*VS/2;
+    double *buffer_partial_lh_ptr = buffer_partial_lh + (getBufferPartialLhSize() - thread_buf_size*num_packets);
+    VectorClass *partial_lh_all = (VectorClass*) &buffer_partial_lh_ptr[thread_buf_size * packet_id];
+    float *vec_tip = (float*)&partial_lh_all[block];
+    size_t scale_step = SAFE_NUMERIC ? VS*ncat_mix : VS;
+
+    for (size_t ptn = ptn_lower; ptn < ptn_upper; ptn+=VS) {
+        for (size_t i = 0; i < block; i++)
+            partial_lh_all[i] = 1.0f;
+        UBYTE *scale_dad = dad_branch->scale_num + (SAFE_NUMERIC ? ptn*ncat_mix : ptn);
+        memset(scale_dad, 0, sizeof(UBYTE)*scale_step);
+
+        double *partial_lh_leaf = partial_lh_leaves;
+        float *echild = echildren_float;
+
+        FOR_NEIGHBOR_IT(node, dad, it) {
+            PhyloNeighbor *child = (PhyloNeighbor*)*it;
+            if (child->node->isLeaf()) {
+                // load real partial likelihoods of the tip
+                auto stateRow = getConvertedSequenceByNumber(child->node->id);
+                for (size_t i = 0; i < VS; i++) {
+                    int state = FLOAT_KERNEL_TIP_STATE(ptn+i, child->node->id, stateRow);
+                    double *child_lh = partial_lh_leaf + block*state;
+                    float *this_vec_tip = vec_tip+i;
+                    for (size_t c = 0; c < block; c++) {
+                        *this_vec_tip = child_lh[c];
+                        this_vec_tip += VS;
+                    }
+                }
+                VectorClass *vtip = (VectorClass*)vec_tip;
+                for (size_t c = 0; c < block; c++)
+                    partial_lh_all[c] *= vtip[c];
+                partial_lh_leaf += (aln->STATE_UNKNOWN+1)*block;
+            } else {
+                VectorClass *partial_lh = partial_lh_all;
+                VectorClass *partial_lh_child = (VectorClass*)((float*)child->partial_lh + ptn*block);
+                UBYTE *scale_child = child->scale_num + (SAFE_NUMERIC ? ptn*ncat_mix : ptn);
+                for (size_t i = 0; i < scale_step; i++)
+                    scale_dad[i] += scale_child[i];
+                float *echild_ptr = echild;
+                for (size_t c = 0; c < ncat_mix; c++) {
+                    // compute real partial likelihood vector
+                    for (size_t x = 0; x < nstates; x++) {
+                        VectorClass vchild;
+                        dotProductVec<VectorClass, float, nstates, FMA>(echild_ptr, partial_lh_child, vchild);
+                        echild_ptr += nstates;
+                        partial_lh[x] *= vchild;
+                    }
+                    partial_lh += nstates;
+                    partial_lh_child += nstates;
+                }
+            }
+            echild += block*nstates;
+            // multifurcating node: rescale after every child
+            if (nchild > 2)
+                scaleFloatLikelihood<VectorClass, DoubleVector, SAFE_NUMERIC, nstates>(partial_lh_all, &ptn_invar[ptn], scale_dad, ncat_mix);
+        } // FOR_NEIGHBOR
+
+        // compute dot-product with inv_eigenvector
+        VectorClass *partial_lh_tmp = partial_lh_all;
+        VectorClass *partial_lh_dad = (VectorClass*)((float*)dad_branch->partial_lh + ptn*block);
+        VectorClass *partial_lh = partial_lh_dad;
+        VectorClass lh_max = 0.0f;
+        for (size_t c = 0; c < ncat_mix; c++) {
+            productVecMat<VectorClass, float, nstates, FMA>(partial_lh_tmp, inv_evec_float + mix_addr[c], partial_lh, lh_max);
+            partial_lh += nstates;
+            partial_lh_tmp += nstates;
+        }
+        if (SAFE_NUMERIC || horizontal_or(lh_max < (float)FLOAT_SCALING_THRESHOLD))
+            scaleFloatLikelihood<VectorClass, DoubleVector, SAFE_NUMERIC, nstates>(partial_lh_dad, &ptn_invar[ptn], scale_dad, ncat_mix);
+    } // FOR ptn
+
+    aligned_free(echildren_float);
+    if (Params::getInstance().buffer_mem_save) {
+        aligned_free(echildren);
+        if (partial_lh_leaves)
+            aligned_free(partial_lh_leaves);
+    }
+}
+
+template <class VectorClass, class DoubleVector, const bool SAFE_NUMERIC, const int nstates, const bool FMA>
+double PhyloTree::computeLikelihoodBranchFloatSIMD(PhyloNeighbor *dad_branch, PhyloNode *dad, bool save_log_value) {
+    PhyloNode *node = (PhyloNode*) dad_branch->node;
+    PhyloNeighbor *node_branch = (PhyloNeighbor*) node->findNeighbor(dad);
+    if (!central_partial_lh)
+        initializeAllPartialLh();
+    if (node->isLeaf()) {
+        PhyloNode *tmp_node = dad;
+        dad = node;
+        node = tmp_node;
+        PhyloNeighbor *tmp_nei = dad_branch;
+        dad_branch = node_branch;
+        node_branch = tmp_nei;
+    }
+
+    computeTraversalInfo<DoubleVector, nstates>(node, dad, false);
+
+    const size_t VS = VectorClass::size();
+    const size_t DVS = DoubleVector::size();
+    size_t ncat = site_rate->getNRate();
+    size_t ncat_mix = (model_factory->fused_mix_rate) ? ncat : ncat*model->getNMixtures();
+    size_t block = ncat_mix * nstates;
+    size_t tip_block = nstates * model->getNMixtures();
+    size_t orig_nptn = aln->size();
+    size_t nptn = roundUpToMultiple(orig_nptn, VS);
+    ASSERT(model_factory->unobserved_ptns.empty());
+
+    size_t mix_addr_nstates[ncat_mix];
+    size_t denom = (model_factory->fused_mix_rate) ? 1 : ncat;
+    double *eval = model->getEigenvalues();
+    ASSERT(eval);
+
+    // exp(eigenvalue*length)*proportion, computed in double
+    double *buffer_partial_lh_ptr = buffer_partial_lh;
+    float *val = (float*)buffer_partial_lh_ptr;
+    buffer_partial_lh_ptr += get_safe_upper_limit(block);
+    for (size_t c = 0; c < ncat_mix; c++) {
+        size_t mycat = c%ncat;
+        size_t m = c/denom;
+        mix_addr_nstates[c] = m*nstates;
+        double len = site_rate->getRate(mycat)*dad_branch->getLength(mycat);
+        double prop = site_rate->getProp(mycat) * model->getMixtureWeight(m);
+        for (size_t i = 0; i < nstates; i++)
+            val[c*nstates+i] = exp(eval[mix_addr_nstates[c]+i]*len) * prop;
+    }
+
+    float *partial_lh_node = NULL;
+    if (dad->isLeaf()) {
+        // precompute information from one tip
+        partial_lh_node = (float*)buffer_partial_lh_ptr;
+        buffer_partial_lh_ptr += get_safe_upper_limit((aln->STATE_UNKNOWN+1)*block);
+        for (int state = 0; state <= aln->STATE_UNKNOWN; state++) {
+            float *lh_node = partial_lh_node + state*block;
+            double *lh_tip = tip_partial_lh + state*tip_block;
+            for (size_t c = 0; c < ncat_mix; c++)
+                for (size_t i = 0; i < nstates; i++)
+                    lh_node[c*nstates+i] = val[c*nstates+i] * lh_tip[mix_addr_nstates[c]+i];
+        }
+    }
+    auto stateRow = dad->isLeaf() ? getConvertedSequenceByNumber(dad->id) : nullptr;
+
+    double all_tree_lh(0.0);
+    vector<size_t> limits;
+    computeBounds<VectorClass>(num_threads, num_packets, nptn, limits);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic,1) num_threads(num_threads) reduction(+:all_tree_lh)
+#endif
+    for (int packet_id = 0; packet_id < num_packets; packet_id++) {
+        size_t ptn_lower = limits[packet_id];
+        size_t ptn_upper = limits[packet_id+1];
+        DoubleVector vc_tree_lh(0.0);
+
+        // first compute partial_lh
+        for (auto it = traversal_info.begin(); it != traversal_info.end(); it++) {
+            computePartialLikelihood(*it, ptn_lower, ptn_upper, packet_id);
+        }
+        float *vec_tip = (float*)buffer_partial_lh_ptr + block*VS*packet_id;
+
+        for (size_t ptn = ptn_lower; ptn < ptn_upper; ptn+=VS) {
+            double *lh_cat = _pattern_lh_cat + ptn*ncat_mix;
+            VectorClass *partial_lh_dad = (VectorClass*)((float*)dad_branch->partial_lh + ptn*block);
+
+            // compute likelihood per category in single precision, store it in double
+            if (dad->isLeaf()) {
+                for (size_t i = 0; i < VS; i++) {
+                    int state = FLOAT_KERNEL_TIP_STATE(ptn+i, dad->id, stateRow);
+                    float *lh_tip = partial_lh_node + block*state;
+                    float *this_vec_tip = vec_tip+i;
+                    for (size_t c = 0; c < block; c++) {
+                        *this_vec_tip = lh_tip[c];
+                        this_vec_tip += VS;
+                    }
+                }
+                VectorClass *lh_node = (VectorClass*)vec_tip;
+                for (size_t c = 0; c < ncat_mix; c++) {
+                    VectorClass lh;
+                    dotProductVec<VectorClass, VectorClass, nstates, FMA>(lh_node, partial_lh_dad, lh);
+                    extend_low(lh).store_a(lh_cat + c*VS);
+                    extend_high(lh).store_a(lh_cat + c*VS + DVS);
+                    lh_node += nstates;
+                    partial_lh_dad += nstates;
+                }
+            } else {
+                VectorClass *partial_lh_node = (VectorClass*)((float*)node_branch->partial_lh + ptn*block);
+                float *val_tmp = val;
+                for (size_t c = 0; c < ncat_mix; c++) {
+                    VectorClass lh;
+                    dotProduct3Vec<VectorClass, float, nstates, FMA>(val_tmp, partial_lh_node, partial_lh_dad, lh);
+                    extend_low(lh).store_a(lh_cat + c*VS);
+                    extend_high(lh).store_a(lh_cat + c*VS + DVS);
+                    partial_lh_node += nstates;
+                    partial_lh_dad += nstates;
+                    val_tmp += nstates;
+                }
+            }
+
+            // compute scaling factor per pattern
+            double min_scale[VS];
+            UBYTE *scale_dad = dad_branch->scale_num + (SAFE_NUMERIC ? ptn*ncat_mix : ptn);
+            UBYTE *scale_node = dad->isLeaf() ? NULL : node_branch->scale_num + (SAFE_NUMERIC ? ptn*ncat_mix : ptn);
+            if (SAFE_NUMERIC) {
+                UBYTE sum_scale[ncat_mix];
+                for (size_t i = 0; i < VS; i++) {
+                    for (size_t c = 0; c < ncat_mix; c++)
+                        sum_scale[c] = scale_dad[c] + (scale_node ? scale_node[c] : 0);
+                    UBYTE scale = *min_element(sum_scale, sum_scale+ncat_mix);
+                    min_scale[i] = scale;
+                    double *this_lh_cat = lh_cat + i;
+                    for (size_t c = 0; c < ncat_mix; c++) {
+                        // rescale lh_cat if neccessary
+                        if (sum_scale[c] == scale+1)
+                            this_lh_cat[c*VS] *= FLOAT_SCALING_THRESHOLD;
+                        else if (sum_scale[c] > scale+1)
+                            this_lh_cat[c*VS] = 0.0;
+                    }
+                    scale_dad += ncat_mix;
+                    if (scale_node)
+                        scale_node += ncat_mix;
+                }
+            } else {
+                for (size_t i = 0; i < VS; i++)
+                    min_scale[i] = scale_dad[i] + (scale_node ? scale_node[i] : 0);
+            }
+
+            // now sum up in double precision
+            for (size_t half = 0; half < VS; half += DVS) {
+                DoubleVector lh_ptn(0.0);
+                for (size_t c = 0; c < ncat_mix; c++)
+                    lh_ptn += DoubleVector().load_a(lh_cat + c*VS + half);
+                DoubleVector vc_min_scale = DoubleVector().load(min_scale + half) * LOG_FLOAT_SCALING_THRESHOLD;
+                // Sum later to avoid underflow of invariant sites
+                lh_ptn = abs(lh_ptn) + DoubleVector().load_a(&ptn_invar[ptn+half]);
+                if (save_log_value) {
+                    lh_ptn = log(lh_ptn) + vc_min_scale;
+                    lh_ptn.store_a(&_pattern_lh[ptn+half]);
+                } else {
+                    lh_ptn.store_a(&_pattern_lh[ptn+half]);
+                    vc_min_scale.store_a(&_pattern_scaling[ptn+half]);
+                    lh_ptn = log(lh_ptn) + vc_min_scale;
+                }
+                vc_tree_lh = mul_add(lh_ptn, DoubleVector().load_a(&ptn_freq[ptn+half]), vc_tree_lh);
+            }
+        } // FOR ptn
+        all_tree_lh += horizontal_add(vc_tree_lh);
+    } // FOR packet
+
+    double tree_lh = all_tree_lh;
+    if (!std::isfinite(tree_lh)) {
+        // leave it to computeLikelihood() to switch to the double kernel
+        mixed_precision_failed = true;
+        tree_lh = 0.0;
+        for (size_t ptn = 0; ptn < orig_nptn; ptn++) {
+            if (!std::isfinite(_pattern_lh[ptn])) {
+                if (save_log_value) {
+                    _pattern_lh[ptn] = LOG_SCALING_THRESHOLD*4; // log(2^(-1024))
+                } else {
+                    _pattern_lh[ptn] = 1.0;
+                    _pattern_scaling[ptn] = LOG_SCALING_THRESHOLD*4;
+                }
+            }
+            tree_lh += (save_log_value ? _pattern_lh[ptn] : log(_pattern_lh[ptn]) + _pattern_scaling[ptn]) * ptn_freq[ptn];
+        }
+    }
+    return tree_lh;
+}
+
+template <class VectorClass, class DoubleVector, const bool SAFE_NUMERIC, const int nstates, const bool FMA>
+void PhyloTree::computeLikelihoodBufferFloatSIMD(PhyloNeighbor *dad_branch, PhyloNode *dad, size_t ptn_lower, size_t ptn_upper, int packet_id) {
+    PhyloNode *node = (PhyloNode*) dad_branch->node;
+    PhyloNeighbor *node_branch = (PhyloNeighbor*) node->findNeighbor(dad);
+
+    const size_t VS = VectorClass::size();
+    size_t orig_nptn = aln->size();
+    size_t ncat = site_rate->getNRate();
+    size_t ncat_mix = (model_factory->fused_mix_rate) ? ncat : ncat*model->getNMixtures();
+    size_t block = ncat_mix * nstates;
+    size_t tip_block = nstates * model->getNMixtures();
+    size_t mix_addr_nstates[ncat_mix];
+    size_t denom = (model_factory->fused_mix_rate) ? 1 : ncat;
+    for (size_t c = 0; c < ncat_mix; c++)
+        mix_addr_nstates[c] = (c/denom)*nstates;
+
+    // reserve 3*block for computeLikelihoodDervFloatSIMD
+    double *buffer_partial_lh_ptr = buffer_partial_lh + 3*get_safe_upper_limit(block);
+
+    // first compute partial_lh
+    for (auto it = traversal_info.begin(); it != traversal_info.end(); it++) {
+        computePartialLikelihood(*it, ptn_lower, ptn_upper, packet_id);
+    }
+
+    float *vec_tip = (float*)buffer_partial_lh_ptr + tip_block*VS*packet_id;
+    auto stateRow = dad->isLeaf() ? getConvertedSequenceByNumber(dad->id) : nullptr;
+
+    for (size_t ptn = ptn_lower; ptn < ptn_upper; ptn+=VS) {
+        float *theta_ptn = (float*)theta_all + ptn*block;
+        VectorClass *theta = (VectorClass*)theta_ptn;
+        VectorClass *partial_lh_dad = (VectorClass*)((float*)dad_branch->partial_lh + ptn*block);
+        UBYTE *scale_dad = dad_branch->scale_num + (SAFE_NUMERIC ? ptn*ncat_mix : ptn);
+        UBYTE *scale_node = NULL;
+        if (dad->isLeaf()) {
+            // load tip vector
+            for (size_t i = 0; i < VS; i++) {
+                int state = FLOAT_KERNEL_TIP_STATE(ptn+i, dad->id, stateRow);
+                double *this_tip_partial_lh = tip_partial_lh + tip_block*state;
+                float *this_vec_tip = vec_tip+i;
+                for (size_t c = 0; c < tip_block; c++) {
+                    *this_vec_tip = this_tip_partial_lh[c];
+                    this_vec_tip += VS;
+                }
+            }
+            for (size_t c = 0; c < ncat_mix; c++) {
+                VectorClass *lh_tip = (VectorClass*)(vec_tip + mix_addr_nstates[c]*VS);
+                for (size_t i = 0; i < nstates; i++)
+                    theta[i] = lh_tip[i] * partial_lh_dad[i];
+                partial_lh_dad += nstates;
+                theta += nstates;
+            }
+        } else {
+            VectorClass *partial_lh_node = (VectorClass*)((float*)node_branch->partial_lh + ptn*block);
+            for (size_t i = 0; i < block; i++)
+                theta[i] = partial_lh_node[i] * partial_lh_dad[i];
+            scale_node = node_branch->scale_num + (SAFE_NUMERIC ? ptn*ncat_mix : ptn);
+        }
+
+        if (SAFE_NUMERIC) {
+            // numerical scaling per category
+            UBYTE sum_scale[ncat_mix];
+            for (size_t i = 0; i < VS; i++) {
+                for (size_t c = 0; c < ncat_mix; c++)
+                    sum_scale[c] = scale_dad[c] + (scale_node ? scale_node[c] : 0);
+                UBYTE min_scale = *min_element(sum_scale, sum_scale+ncat_mix);
+                buffer_scale_all[ptn+i] = min_scale * LOG_FLOAT_SCALING_THRESHOLD;
+                for (size_t c = 0; c < ncat_mix; c++) {
+                    if (sum_scale[c] <= min_scale)
+                        continue;
+                    float *this_theta = theta_ptn + c*nstates*VS + i;
+                    for (size_t x = 0; x < nstates; x++) {
+                        if (sum_scale[c] == min_scale+1)
+                            this_theta[x*VS] *= (float)FLOAT_SCALING_THRESHOLD;
+                        else
+                            this_theta[x*VS] = 0.0f;
+                    }
+                }
+                scale_dad += ncat_mix;
+                if (scale_node)
+                    scale_node += ncat_mix;
+            }
+        } else {
+            for (size_t i = 0; i < VS; i++)
+                buffer_scale_all[ptn+i] = (scale_dad[i] + (scale_node ? scale_node[i] : 0)) * LOG_FLOAT_SCALING_THRESHOLD;
+        }
+    } // FOR ptn
+}
+
+template <class VectorClass, class DoubleVector, const bool SAFE_NUMERIC, const int nstates, const bool FMA>
+void PhyloTree::computeLikelihoodDervFloatSIMD(PhyloNeighbor *dad_branch, PhyloNode *dad, double *df, double *ddf) {
+    PhyloNode *node = (PhyloNode*) dad_branch->node;
+    PhyloNeighbor *node_branch = (PhyloNeighbor*) node->findNeighbor(dad);
+    if (!central_partial_lh)
+        initializeAllPartialLh();
+    if (node->isLeaf()) {
+        PhyloNode *tmp_node = dad;
+        dad = node;
+        node = tmp_node;
+        PhyloNeighbor *tmp_nei = dad_branch;
+        dad_branch = node_branch;
+        node_branch = tmp_nei;
+    }
+
+    computeTraversalInfo<DoubleVector, nstates>(node, dad, false);
+
+    const size_t VS = VectorClass::size();
+    const size_t DVS = DoubleVector::size();
+    size_t ncat = site_rate->getNRate();
+    size_t ncat_mix = (model_factory->fused_mix_rate) ? ncat : ncat*model->getNMixtures();
+    size_t block = ncat_mix * nstates;
+    size_t orig_nptn = aln->size();
+    size_t nptn = roundUpToMultiple(orig_nptn, VS);
+    size_t denom = (model_factory->fused_mix_rate) ? 1 : ncat;
+    double *eval = model->getEigenvalues();
+    ASSERT(eval);
+    ASSERT(theta_all);
+
+    // transition probabilities and their derivatives, computed in double
+    float *val0 = (float*)buffer_partial_lh;
+    float *val1 = (float*)(buffer_partial_lh + get_safe_upper_limit(block));
+    float *val2 = (float*)(buffer_partial_lh + 2*get_safe_upper_limit(block));
+    for (size_t c = 0; c < ncat_mix; c++) {
+        size_t m = c/denom;
+        size_t mycat = c%ncat;
+        double *eval_ptr = eval + m*nstates;
+        double prop = site_rate->getProp(mycat) * model->getMixtureWeight(m);
+        double len = dad_branch->getLength(mycat);
+        double myrate = site_rate->getRate(mycat);
+        for (size_t i = 0; i < nstates; i++) {
+            double cof = eval_ptr[i]*myrate;
+            double val = exp(cof*len) * prop;
+            val0[c*nstates+i] = val;
+            val1[c*nstates+i] = cof*val;
+            val2[c*nstates+i] = cof*cof*val;
+        }
+    }
+
+    vector<size_t> limits;
+    computeBounds<VectorClass>(num_threads, num_packets, nptn, limits);
+
+    double all_df(0.0), all_ddf(0.0);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic,1) num_threads(num_threads) reduction(+:all_df,all_ddf)
+#endif
+    for (int packet_id = 0; packet_id < num_packets; packet_id++) {
+        DoubleVector my_df(0.0), my_ddf(0.0);
+        size_t ptn_lower = limits[packet_id];
+        size_t ptn_upper = limits[packet_id+1];
+
+        if (!theta_computed)
+            computeLikelihoodBufferFloatSIMD<VectorClass, DoubleVector, SAFE_NUMERIC, nstates, FMA>(dad_branch, dad, ptn_lower, ptn_upper, packet_id);
+
+        for (size_t ptn = ptn_lower; ptn < ptn_upper; ptn+=VS) {
+            VectorClass *theta = (VectorClass*)((float*)theta_all + ptn*block);
+            VectorClass lh_ptn, df_ptn, ddf_ptn;
+            dotProductTriple<VectorClass, float, nstates, FMA, false>(val0, val1, val2, theta, lh_ptn, df_ptn, ddf_ptn, block);
+
+            // accumulate derivatives in double precision
+            for (size_t half = 0; half < VS; half += DVS) {
+                DoubleVector lh = (half == 0) ? extend_low(lh_ptn) : extend_high(lh_ptn);
+                DoubleVector df_frac = (half == 0) ? extend_low(df_ptn) : extend_high(df_ptn);
+                DoubleVector ddf_frac = (half == 0) ? extend_low(ddf_ptn) : extend_high(ddf_ptn);
+                lh = 1.0 / (abs(lh) + DoubleVector().load_a(&ptn_invar[ptn+half]));
+                df_frac *= lh;
+                ddf_frac *= lh;
+                DoubleVector freq;
+                freq.load_a(&ptn_freq[ptn+half]);
+                DoubleVector tmp1 = df_frac * freq;
+                DoubleVector tmp2 = ddf_frac * freq;
+                my_df += tmp1;
+                my_ddf += nmul_add(tmp1, df_frac, tmp2);
+            }
+        } // FOR ptn
+        all_df  += horizontal_add(my_df);
+        all_ddf += horizontal_add(my_ddf);
+    } // FOR packet
+
+    // mark buffer as computed
+    theta_computed = true;
+
+    *df  = all_df;
+    *ddf = all_ddf;
+    if (!std::isfinite(*df) || !std::isfinite(*ddf)) {
+        // leave it to computeLikelihood() to switch to the double kernel
+        mixed_precision_failed = true;
+        *df = *ddf = 0.0;
+    }
+}
+
+#undef FLOAT_KERNEL_TIP_STATE
+
+#endif /* PHYLOKERNELFLOAT_H_ */
@@ -1187,6 +1187,11 @@ void PhyloTree::computeTraversalInfo(PhyloNode *node, PhyloNode *dad, bool compu
 
     PhyloNeighbor *dad_branch = (PhyloNeighbor*)dad->findNeighbor(node);
     PhyloNeighbor *node_branch = (PhyloNeighbor*)node->findNeighbor(dad);
+    if (params->lh_mem_save == LM_MEM_SAVE) {
+        mem_slots.beginTraversal();
+        pinTraversalPartialLh(dad_branch, dad);
+        pinTraversalPartialLh(node_branch, node);
+    }
     bool dad_locked = computeTraversalInfo(dad_branch, dad, buffer);
     bool node_locked = computeTraversalInfo(node_branch, node, buffer);
     if (params->lh_mem_save == LM_MEM_SAVE) {
@@ -1404,7 +1409,163 @@ void PhyloTree::computePartialLikelihoodGenericSIMD(TraversalInfo &info
         len_right = etmp;
 	}
 
-    if (node->degree() > 3) {
+    // large mixtures: matrices of all classes do not fit into cache, loop over classes outside patterns
+    size_t mix_block = 0;
+    if (!SITE_MODEL && node->degree() == 3 && ncat_mix > 1 && Params::getInstance().lh_mix_block > 0 &&
+        block*nstates*2*sizeof(double) >= MIX_BLOCK_MIN_BYTES && ptn_upper-ptn_lower > VectorClass::size() &&
+        Params::getInstance().lh_mix_block + 3*nstates <= 2*block+nstates)
+        mix_block = Params::getInstance().lh_mix_block * VectorClass::size();
+
+    if (mix_block) {
+        /*--------------------- LARGE MIXTURE, bifurcating node ------------------*/
+
+        // the transition and inverse eigenvector matrices of one class are reused over mix_block patterns
+        const size_t VS = VectorClass::size();
+        VectorClass *partial_lh_tmp = (VectorClass*)(buffer_partial_lh_ptr + thread_buf_size * packet_id);
+        VectorClass *vleft = partial_lh_tmp + nstates;
+        VectorClass *vright = vleft + nstates;
+        VectorClass *lh_max_block = vright + nstates;
+        bool left_tip = left->node->isLeaf(), right_tip = right->node->isLeaf();
+        double *partial_lh_left = partial_lh_leaves;
+        double *partial_lh_right = partial_lh_leaves + (aln->STATE_UNKNOWN+1)*block;
+        auto leftStateRow  = left_tip ? this->getConvertedSequenceByNumber(left->node->id) : nullptr;
+        auto rightStateRow = right_tip ? this->getConvertedSequenceByNumber(right->node->id) : nullptr;
+        int left_states[mix_block], right_states[mix_block];
+        auto tipState = [&](size_t ptn, int leaf_id, const char *stateRow) -> int {
+            if (ptn < orig_nptn)
+                return (stateRow != nullptr) ? stateRow[ptn] : (aln->at(ptn))[leaf_id];
+            if (ptn >= max_orig_nptn && ptn < nptn)
+                return model_factory->unobserved_ptns[ptn-max_orig_nptn][leaf_id];
+            return aln->STATE_UNKNOWN;
+        };
+
+        // scale numbers of the children are added up front
+        UBYTE *scale_dad = dad_branch->scale_num + (SAFE_NUMERIC ? ptn_lower*ncat_mix : ptn_lower);
+        if (left_tip && right_tip)
+            memset(scale_dad, 0, scale_size * sizeof(UBYTE));
+        else if (left_tip)
+            memcpy(scale_dad, right->scale_num + (SAFE_NUMERIC ? ptn_lower*ncat_mix : ptn_lower), scale_size * sizeof(UBYTE));
+        else {
+            UBYTE *scale_left = left->scale_num + (SAFE_NUMERIC ? ptn_lower*ncat_mix : ptn_lower);
+            UBYTE *scale_right = right->scale_num + (SAFE_NUMERIC ? ptn_lower*ncat_mix : ptn_lower);
+            for (size_t i = 0; i < scale_size; i++)
+                scale_dad[i] = scale_left[i] + scale_right[i];
+        }
+
+        for (size_t ptn_start = ptn_lower; ptn_start < ptn_upper; ptn_start += mix_block) {
+            size_t ptn_end = min(ptn_start + mix_block, ptn_upper);
+            size_t nvec = (ptn_end - ptn_start) / VS;
+            for (size_t ptn = ptn_start; ptn < ptn_end; ptn++) {
+                if (left_tip)
+                    left_states[ptn-ptn_start] = tipState(ptn, left->node->id, leftStateRow);
+                if (right_tip)
+                    right_states[ptn-ptn_start] = tipState(ptn, right->node->id, rightStateRow);
+            }
+            for (size_t v = 0; v < nvec; v++)
+                lh_max_block[v] = 0.0;
+
+            double *eleft_ptr = eleft, *eright_ptr = eright;
+            for (size_t c = 0; c < ncat_mix; c++) {
+                double *inv_evec_ptr = inv_evec + mix_addr[c];
+                for (size_t v = 0; v < nvec; v++) {
+                    size_t ptn = ptn_start + v*VS;
+                    VectorClass *partial_lh = (VectorClass*)(dad_branch->partial_lh + ptn*block) + c*nstates;
+                    VectorClass lh_max = SAFE_NUMERIC ? VectorClass(0.0) : lh_max_block[v];
+                    // load class c of the tips
+                    for (size_t x = 0; x < VS; x++) {
+                        if (left_tip) {
+                            double *tip = partial_lh_left + block*left_states[v*VS+x] + c*nstates;
+                            for (size_t i = 0; i < nstates; i++)
+                                ((double*)vleft)[i*VS+x] = tip[i];
+                        }
+                        if (right_tip) {
+                            double *tip = partial_lh_right + block*right_states[v*VS+x] + c*nstates;
+                            for (size_t i = 0; i < nstates; i++)
+                                ((double*)vright)[i*VS+x] = tip[i];
+                        }
+                    }
+
+                    if (left_tip && right_tip) {
+                        /*--------------------- TIP-TIP (cherry) case ------------------*/
+                        for (size_t x = 0; x < nstates; x++)
+                            partial_lh_tmp[x] = vleft[x] * vright[x];
+#ifdef KERNEL_FIX_STATES
+                        productVecMat<VectorClass, double, nstates, FMA>(partial_lh_tmp, inv_evec_ptr, partial_lh);
+#else
+                        productVecMat<VectorClass, double, FMA> (partial_lh_tmp, inv_evec_ptr, partial_lh, nstates);
+#endif
+                        continue;
+                    }
+
+                    VectorClass *partial_lh_child_right = (VectorClass*)(right->partial_lh + ptn*block) + c*nstates;
+                    if (left_tip) {
+                        /*--------------------- TIP-INTERNAL NODE case ------------------*/
+                        for (size_t x = 0; x < nstates; x++) {
+                            VectorClass vchild;
+#ifdef KERNEL_FIX_STATES
+                            dotProductVec<VectorClass, double, nstates, FMA>(eright_ptr + x*nstates, partial_lh_child_right, vchild);
+#else
+                            dotProductVec<VectorClass, double, FMA>(eright_ptr + x*nstates, partial_lh_child_right, vchild, nstates);
+#endif
+                            partial_lh_tmp[x] = vleft[x] * (vchild);
+                        }
+                    } else {
+                        /*--------------------- INTERNAL-INTERNAL NODE case ------------------*/
+                        VectorClass *partial_lh_child_left = (VectorClass*)(left->partial_lh + ptn*block) + c*nstates;
+                        for (size_t x = 0; x < nstates; x++) {
+#ifdef KERNEL_FIX_STATES
+                            dotProductDualVec<VectorClass, double, nstates, FMA>(eleft_ptr + x*nstates, partial_lh_child_left,
+                                eright_ptr + x*nstates, partial_lh_child_right, partial_lh_tmp[x]);
+#else
+                            dotProductDualVec<VectorClass, double, FMA>(eleft_ptr + x*nstates, partial_lh_child_left,
+                                eright_ptr + x*nstates, partial_lh_child_right, partial_lh_tmp[x], nstates);
+#endif
+                        }
+                    }
+#ifdef KERNEL_FIX_STATES
+                    productVecMat<VectorClass, double, nstates, FMA>(partial_lh_tmp, inv_evec_ptr, partial_lh, lh_max);
+#else
+                    productVecMat<VectorClass, double, FMA> (partial_lh_tmp, inv_evec_ptr, partial_lh, lh_max, nstates);
+#endif
+                    if (!SAFE_NUMERIC) {
+                        lh_max_block[v] = lh_max;
+                        continue;
+                    }
+                    // check if one should scale partial likelihoods of this class
+                    auto underflown = ((lh_max < SCALING_THRESHOLD) & (VectorClass().load_a(&ptn_invar[ptn]) == 0.0));
+                    if (horizontal_or(underflown)) {
+                        for (size_t x = 0; x < VS; x++)
+                        if (underflown[x]) {
+                            double *partial_lh = dad_branch->partial_lh + (ptn*block + c*nstates*VS + x);
+                            for (size_t i = 0; i < nstates; i++)
+                                partial_lh[i*VS] = ldexp(partial_lh[i*VS], SCALING_THRESHOLD_EXP);
+                            dad_branch->scale_num[(ptn+x)*ncat_mix+c] += 1;
+                        }
+                    }
+                }
+                eleft_ptr += nstates*nstates;
+                eright_ptr += nstates*nstates;
+            } // FOR class
+
+            if (!SAFE_NUMERIC && !(left_tip && right_tip)) {
+                // check if one should scale partial likelihoods of all classes
+                for (size_t v = 0; v < nvec; v++) {
+                    size_t ptn = ptn_start + v*VS;
+                    auto underflown = (lh_max_block[v] < SCALING_THRESHOLD) & (VectorClass().load_a(&ptn_invar[ptn]) == 0.0);
+                    if (horizontal_or(underflown)) {
+                        for (size_t x = 0; x < VS; x++)
+                        if (underflown[x]) {
+                            double *partial_lh = dad_branch->partial_lh + (ptn*block + x);
+                            for (size_t i = 0; i < block; i++)
+                                partial_lh[i*VS] = ldexp(partial_lh[i*VS], SCALING_THRESHOLD_EXP);
+                            dad_branch->scale_num[ptn+x] += 1;
+                        }
+                    }
+                }
+            }
+        } // FOR pattern block
+
+    } else if (node->degree() > 3) {
         /*--------------------- multifurcating node ------------------*/
 
         // now for-loop computing partial_lh over all site-patterns
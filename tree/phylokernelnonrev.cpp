@@ -410,7 +410,7 @@ void PhyloTree::computeNonrevLikelihoodDerv(PhyloNeighbor *dad_branch, PhyloNode
         double *this_trans_mat = &trans_mat[c*nstatesqr];
         double *this_trans_derv1 = &trans_derv1[c*nstatesqr];
         double *this_trans_derv2 = &trans_derv2[c*nstatesqr];
-        model->computeTransDerv(len, this_trans_mat, this_trans_derv1, this_trans_derv2);
+        model_factory->computeTransDerv(len, this_trans_mat, this_trans_derv1, this_trans_derv2);
         double prop_rate = prop*site_rate->getRate(c);
         double prop_rate_2 = prop_rate * site_rate->getRate(c); 
 		for (i = 0; i < nstatesqr; i++) {
@@ -639,7 +639,7 @@ double PhyloTree::computeNonrevLikelihoodBranch(PhyloNeighbor *dad_branch, Phylo
 		double len = site_rate->getRate(c)*dad_branch->length;
 		double prop = site_rate->getProp(c);
         double *this_trans_mat = &trans_mat[c*nstatesqr];
-        model->computeTransMatrix(len, this_trans_mat);
+        model_factory->computeTransMatrix(len, this_trans_mat);
 		for (i = 0; i < nstatesqr; i++)
 			this_trans_mat[i] *= prop;
 	}
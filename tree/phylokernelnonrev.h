@@ -634,7 +634,7 @@ void PhyloTree::computeNonrevLikelihoodDervGenericSIMD(PhyloNeighbor *dad_branch
         double* this_trans_mat = &trans_mat[c*nstatesqr];
         double* this_trans_derv1 = &trans_derv1[c*nstatesqr];
         double* this_trans_derv2 = &trans_derv2[c*nstatesqr];
-        model->computeTransDerv(len, this_trans_mat, this_trans_derv1, this_trans_derv2, m);
+        model_factory->computeTransDerv(len, this_trans_mat, this_trans_derv1, this_trans_derv2, m);
         double  prop_rate = prop * cat_rate;
         double  prop_rate_2 = prop_rate * cat_rate;
         for (size_t i = 0; i < nstatesqr; i++) {
@@ -1114,7 +1114,7 @@ double PhyloTree::computeNonrevLikelihoodBranchGenericSIMD(PhyloNeighbor *dad_br
 		double len = site_rate->getRate(mycat) * dad_branch->length;
 		double prop = site_rate->getProp(mycat) * model->getMixtureWeight(m);
         double *this_trans_mat = &trans_mat[c*nstatesqr];
-        model->computeTransMatrix(len, this_trans_mat, m);
+        model_factory->computeTransMatrix(len, this_trans_mat, m);
         for (size_t i = 0; i < nstatesqr; i++) {
 			this_trans_mat[i] *= prop;
         }
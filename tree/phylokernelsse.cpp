@@ -39,10 +39,13 @@ void PhyloTree::setParsimonyKernelSSE() {
 void PhyloTree::setDotProductSSE() {
 #ifdef BOOT_VAL_FLOAT
 		dotProduct = &PhyloTree::dotProductSIMD<float, Vec4f>;
+		dotProductMulti = &PhyloTree::dotProductMultiSIMD<float, Vec4f>;
 #else
 		dotProduct = &PhyloTree::dotProductSIMD<double, Vec2d>;
+		dotProductMulti = &PhyloTree::dotProductMultiSIMD<double, Vec2d>;
 #endif
         dotProductDouble = &PhyloTree::dotProductSIMD<double, Vec2d>;
+        dotProductMultiDouble = &PhyloTree::dotProductMultiSIMD<double, Vec2d>;
 }
 
 void PhyloTree::setLikelihoodKernelSSE() {
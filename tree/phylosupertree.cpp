@@ -225,9 +225,9 @@ void PhyloSuperTree::changeLikelihoodKernel(LikelihoodKernel lk) {
 }
 
 void PhyloSuperTree::setNumThreads(int num_threads) {
-    PhyloTree::setNumThreads((size() >= num_threads) ? num_threads : 1);
-    for (iterator it = begin(); it != end(); it++)
-        (*it)->setNumThreads((size() >= num_threads) ? 1 : num_threads);
+    PhyloTree::setNumThreads(num_threads);
+    // the threads of each partition tree are set by the schedule
+    computePartitionSchedule();
 }
 
 void PhyloSuperTree::printResultTree(string suffix) {
@@ -698,6 +698,106 @@ void PhyloSuperTree::computePartitionOrder() {
 #endif // OPENMP
 }
 
+void PhyloSuperTree::computePartitionSchedule() {
+    int i, ntrees = size();
+    int nthreads = max(num_threads, 1);
+    part_large.clear();
+    part_bins.clear();
+    if (ntrees == 0)
+        return;
+
+    // use measured costs once all partitions were measured
+    bool measured = (part_info.size() >= ntrees);
+    for (i = 0; measured && i < ntrees; i++)
+        if (part_info[i].cost <= 0.0) {
+            measured = false;
+            break;
+        }
+    DoubleVector cost(ntrees);
+    double total_cost = 0.0;
+    for (i = 0; i < ntrees; i++) {
+        Alignment *part_aln = at(i)->aln;
+        if (measured)
+            cost[i] = part_info[i].cost;
+        else
+            cost[i] = ((double)part_aln->getNSeq())*part_aln->getNPattern()*part_aln->num_states;
+        total_cost += cost[i];
+    }
+
+    // partitions in descending order of cost
+    IntVector order(ntrees);
+    for (i = 0; i < ntrees; i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return cost[a] > cost[b]; });
+
+    // large partitions get all threads, provided they have enough patterns for all threads
+    IntVector small;
+    for (auto part : order) {
+        if (nthreads > 1 && cost[part]*nthreads >= total_cost && at(part)->aln->getNPattern() >= 8*nthreads)
+            part_large.push_back(part);
+        else
+            small.push_back(part);
+    }
+
+    // longest-processing-time-first bin packing of the small partitions
+    part_bins.resize(min(nthreads, (int)small.size()));
+    DoubleVector load(part_bins.size(), 0.0);
+    for (auto part : small) {
+        size_t bin = min_element(load.begin(), load.end()) - load.begin();
+        part_bins[bin].push_back(part);
+        load[bin] += cost[part];
+    }
+
+    for (auto part : part_large)
+        at(part)->setNumThreads(nthreads);
+    for (auto part : small)
+        at(part)->setNumThreads(1);
+
+    if (verbose_mode >= VB_MED && nthreads > 1) {
+        cout << "Partition schedule (" << (measured ? "measured" : "estimated") << " costs): "
+             << part_large.size() << " partitions with " << nthreads << " threads, "
+             << small.size() << " partitions in " << part_bins.size() << " single-thread bins" << endl;
+    }
+}
+
+double PhyloSuperTree::forEachPartition(const std::function<double(int)> &func, bool measure_cost) {
+    int ntrees = size();
+    size_t nscheduled = part_large.size();
+    for (auto bin = part_bins.begin(); bin != part_bins.end(); bin++)
+        nscheduled += bin->size();
+    if (nscheduled != ntrees)
+        computePartitionSchedule();
+    DoubleVector part_value(ntrees, 0.0);
+
+    // large partitions one after another, each parallelized over its patterns
+    for (auto part : part_large) {
+        double start = getRealTime();
+        part_value[part] = func(part);
+        if (measure_cost)
+            part_info[part].cost = (getRealTime() - start) * at(part)->num_threads;
+    }
+
+    // small partitions in parallel, one bin per thread
+    int nbins = part_bins.size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) num_threads(max(nbins, 1)) if(nbins > 1)
+#endif
+    for (int bin = 0; bin < nbins; bin++) {
+        for (auto part : part_bins[bin]) {
+            double start = getRealTime();
+            part_value[part] = func(part);
+            if (measure_cost)
+                part_info[part].cost = getRealTime() - start;
+        }
+    }
+
+    // sum up in partition order for reproducible results
+    double sum = 0.0;
+    for (int part = 0; part < ntrees; part++)
+        sum += part_value[part];
+    return sum;
+}
+
 double PhyloSuperTree::computeLikelihood(double *pattern_lh, bool save_log_value) {
     // TODO: the case for save_log_value = false
 	double tree_lh = 0.0;
@@ -712,15 +812,14 @@ double PhyloSuperTree::computeLikelihood(double *pattern_lh, bool save_log_value
 			pattern_lh += at(i)->getAlnNPattern();
 		}
 	} else {
-        if (part_order.empty()) computePartitionOrder();
-		#ifdef _OPENMP
-		#pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) if(num_threads > 1)
-		#endif
-		for (int j = 0; j < ntrees; j++) {
-            int i = part_order[j];
+		tree_lh = forEachPartition([&](int i) -> double {
 			part_info[i].cur_score = at(i)->computeLikelihood();
-			tree_lh += part_info[i].cur_score;
-		}
+			return part_info[i].cur_score;
+		}, true);
+		// re-balance the schedule after the first and every 100th measurement
+		part_cost_updates++;
+		if (part_cost_updates % 100 == 1)
+			computePartitionSchedule();
 	}
 	return tree_lh;
 }
@@ -773,17 +872,12 @@ void PhyloSuperTree::computePatternProbabilityCategory(double *ptn_prob_cat, Sit
 double PhyloSuperTree::optimizeAllBranches(int my_iterations, double tolerance, int maxNRStep) {
 	double tree_lh = 0.0;
 	int ntrees = size();
-    if (part_order.empty()) computePartitionOrder();
-	#ifdef _OPENMP
-	#pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) if(num_threads > 1)
-	#endif
-	for (int j = 0; j < ntrees; j++) {
-        int i = part_order[j];
+	tree_lh = forEachPartition([&](int i) -> double {
 		part_info[i].cur_score = at(i)->optimizeAllBranches(my_iterations, tolerance/min(ntrees,10), maxNRStep);
-		tree_lh += part_info[i].cur_score;
 		if (verbose_mode >= VB_MAX)
 			at(i)->printTree(cout, WT_BR_LEN + WT_NEWLINE);
-	}
+		return part_info[i].cur_score;
+	});
 
 	if (my_iterations >= 100) computeBranchLengths();
 	return tree_lh;
@@ -909,16 +1003,12 @@ NNIMove PhyloSuperTree::getBestNNIForBran(PhyloNode *node1, PhyloNode *node2, NN
 
 	int ntrees = size(), part;
 	double nni_score1 = 0.0, nni_score2 = 0.0;
-	int local_totalNNIs = 0, local_evalNNIs = 0;
-
-    if (part_order.empty()) computePartitionOrder();
-	#ifdef _OPENMP
-	#pragma omp parallel for reduction(+: nni_score1, nni_score2, local_totalNNIs, local_evalNNIs) private(part) schedule(dynamic) if(num_threads>1)
-	#endif
-	for (int treeid = 0; treeid < ntrees; treeid++) {
-        part = part_order_by_nptn[treeid];
+	int local_totalNNIs = ntrees, local_evalNNIs = 0;
+	DoubleVector part_nni_score2(ntrees, 0.0);
+	IntVector part_evaluated(ntrees, 0);
+
+	nni_score1 = forEachPartition([&](int part) -> double {
 		bool is_nni = true;
-		local_totalNNIs++;
 		FOR_NEIGHBOR_DECLARE(node1, NULL, nit) {
 			if (! ((SuperNeighbor*)*nit)->link_neighbors[part]) { is_nni = false; break; }
 		}
@@ -931,12 +1021,11 @@ NNIMove PhyloSuperTree::getBestNNIForBran(PhyloNode *node1, PhyloNode *node2, NN
 				if (save_all_trees == 2 || nniMoves)
 					at(part)->computePatternLikelihood(part_info[part].cur_ptnlh, &part_info[part].cur_score);
 			}
-			nni_score1 += part_info[part].cur_score;
-			nni_score2 += part_info[part].cur_score;
-			continue;
+			part_nni_score2[part] = part_info[part].cur_score;
+			return part_info[part].cur_score;
 		}
 
-		local_evalNNIs++;
+		part_evaluated[part] = 1;
 		part_info[part].evalNNIs++;
 
 		PhyloNeighbor *nei1_part = nei1->link_neighbors[part];
@@ -970,15 +1059,18 @@ NNIMove PhyloSuperTree::getBestNNIForBran(PhyloNode *node1, PhyloNode *node2, NN
 			part_info[part].nniMoves[0] = part_info[part].nniMoves[1];
 			part_info[part].nniMoves[1] = tmp;
 		}
-		nni_score1 += part_info[part].nniMoves[0].newloglh;
-		nni_score2 += part_info[part].nniMoves[1].newloglh;
+		part_nni_score2[part] = part_info[part].nniMoves[1].newloglh;
 		int numlen = 1;
 		if (params->nni5) numlen = 5;
 		for (int i = 0; i < numlen; i++) {
 			part_info[part].nni1_brlen[brid*numlen + i] = part_info[part].nniMoves[0].newLen[i];
 			part_info[part].nni2_brlen[brid*numlen + i] = part_info[part].nniMoves[1].newLen[i];
 		}
-
+		return part_info[part].nniMoves[0].newloglh;
+	});
+	for (part = 0; part < ntrees; part++) {
+		nni_score2 += part_nni_score2[part];
+		local_evalNNIs += part_evaluated[part];
 	}
 	totalNNIs += local_totalNNIs;
 	evalNNIs += local_evalNNIs;
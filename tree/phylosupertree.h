@@ -20,6 +20,7 @@
 #ifndef PHYLOSUPERTREE_H
 #define PHYLOSUPERTREE_H
 
+#include <functional>
 #include "iqtree.h"
 #include "supernode.h"
 #include "alignment/superalignment.h"
@@ -31,6 +32,7 @@ struct PartitionInfo {
     double cur_score;    // current log-likelihood
     double part_rate;    // partition heterogeneity rate
     int    evalNNIs;    // number of evaluated NNIs on subtree
+    double cost = 0.0;  // measured CPU time of one likelihood evaluation, 0 if not measured yet
     
     //DoubleVector null_score; // log-likelihood of each branch collapsed to zero
     //DoubleVector opt_score;  // optimized log-likelihood for every branch
@@ -365,6 +367,32 @@ public:
     /* compute part_order vector */
     void computePartitionOrder();
 
+    /**
+        hybrid partition schedule: partitions at least as costly as the fair share of one thread
+        are computed one after another, each with all threads over its patterns.
+        The remaining partitions are bin-packed onto single threads (one bin per thread).
+        Costs are measured by computeLikelihood, or estimated from #sequences x #patterns x #states
+        before the first measurement. Also sets the number of threads of each partition tree.
+    */
+    void computePartitionSchedule();
+
+    /**
+        run a function on all partitions following the partition schedule
+        @param func function of the partition ID, returning a value to be summed up
+        @param measure_cost TRUE to record the running time of each partition into part_info
+        @return sum of the returned values in the order of partitions
+    */
+    double forEachPartition(const std::function<double(int)> &func, bool measure_cost = false);
+
+    /* partitions computed with all threads, in descending order of cost */
+    IntVector part_large;
+
+    /* bins of partitions computed by a single thread each */
+    vector<IntVector> part_bins;
+
+    /* number of computeLikelihood calls with measured partition costs */
+    int part_cost_updates = 0;
+
     /**
             get the name of the model
     */
@@ -277,17 +277,13 @@ void PhyloSuperTreePlen::optimizeOneBranch(PhyloNode *node1, PhyloNode *node2, b
 	//this->clearAllPartialLH();
 	PhyloTree::optimizeOneBranch(node1, node2, false, maxNRStep);
 
-    if (part_order.empty()) computePartitionOrder();
 	// bug fix: assign cur_score into part_info
-    #ifdef _OPENMP
-    #pragma omp parallel for private(part) schedule(dynamic) if(num_threads > 1)
-    #endif    
-    for (int partid = 0; partid < size(); partid++) {
-        part = part_order_by_nptn[partid];
+    forEachPartition([&](int part) -> double {
         if (((SuperNeighbor*)current_it)->link_neighbors[part]) {
             part_info[part].cur_score = at(part)->computeLikelihoodFromBuffer();
         }
-    }
+        return 0.0;
+    });
 
 	if(clearLH && current_len != current_it->length){
 		for (int part = 0; part < size(); part++) {
@@ -318,12 +314,7 @@ double PhyloSuperTreePlen::computeFunction(double value) {
 	SuperNeighbor *nei2 = (SuperNeighbor*)current_it->node->findNeighbor(current_it_back->node);
 	ASSERT(nei1 && nei2);
 
-    if (part_order.empty()) computePartitionOrder();
-    #ifdef _OPENMP
-    #pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) if(num_threads > 1)
-    #endif    
-	for (int partid = 0; partid < ntrees; partid++) {
-            int part = part_order_by_nptn[partid];
+	tree_lh = forEachPartition([&](int part) -> double {
 			PhyloNeighbor *nei1_part = nei1->link_neighbors[part];
 			PhyloNeighbor *nei2_part = nei2->link_neighbors[part];
 			if (nei1_part && nei2_part) {
@@ -332,13 +323,12 @@ double PhyloSuperTreePlen::computeFunction(double value) {
 				nei1_part->length += lambda*part_info[part].part_rate;
 				nei2_part->length += lambda*part_info[part].part_rate;
 				part_info[part].cur_score = at(part)->computeLikelihoodBranch(nei2_part,(PhyloNode*)nei1_part->node);
-				tree_lh += part_info[part].cur_score;
 			} else {
 				if (part_info[part].cur_score == 0.0)
 					part_info[part].cur_score = at(part)->computeLikelihood();
-				tree_lh += part_info[part].cur_score;
 			}
-		}
+			return part_info[part].cur_score;
+		});
     return -tree_lh;
 }
 
@@ -376,12 +366,8 @@ void PhyloSuperTreePlen::computeFuncDerv(double value, double &df_ret, double &d
 	SuperNeighbor *nei2 = (SuperNeighbor*)current_it->node->findNeighbor(current_it_back->node);
 	ASSERT(nei1 && nei2);
 
-    if (part_order.empty()) computePartitionOrder();
-    #ifdef _OPENMP
-    #pragma omp parallel for reduction(+: df, ddf) schedule(dynamic) if(num_threads > 1)
-    #endif    
-	for (int partid = 0; partid < ntrees; partid++) {
-        int part = part_order_by_nptn[partid];
+    DoubleVector part_ddf(ntrees, 0.0);
+    df = forEachPartition([&](int part) -> double {
         double df_aux, ddf_aux;
         PhyloNeighbor *nei1_part = nei1->link_neighbors[part];
         PhyloNeighbor *nei2_part = nei2->link_neighbors[part];
@@ -398,15 +384,18 @@ void PhyloSuperTreePlen::computeFuncDerv(double value, double &df_ret, double &d
                 outError("shit!!   ",__func__);
             }
             at(part)->computeLikelihoodDerv(nei2_part,(PhyloNode*)nei1_part->node, &df_aux, &ddf_aux);
-            df += part_info[part].part_rate*df_aux;
-            ddf += part_info[part].part_rate*part_info[part].part_rate*ddf_aux;
+            part_ddf[part] = part_info[part].part_rate*part_info[part].part_rate*ddf_aux;
+            return part_info[part].part_rate*df_aux;
         }
         else {
             if (part_info[part].cur_score == 0.0) {
                 part_info[part].cur_score = at(part)->computeLikelihood();
             }
+            return 0.0;
         }
-    }
+    });
+    for (int part = 0; part < ntrees; part++)
+        ddf += part_ddf[part];
     df_ret = -df;
     ddf_ret = -ddf;
 }
@@ -198,17 +198,15 @@ double PhyloSuperTreeUnlinked::treeLengthInternal( double epsilon, Node *node, N
 
 pair<int, int> PhyloSuperTreeUnlinked::doNNISearch(bool write_info) {
     int NNIs = 0, NNI_steps = 0;
-    double score = 0.0;
-#pragma omp parallel for schedule(dynamic) num_threads(num_threads) if (num_threads > 1) reduction(+: NNIs, NNI_steps, score)
-    for (int i = 0; i < size(); i++) {
-        IQTree *part_tree = (IQTree*)at(part_order[i]);
+    IntVector part_NNIs(size(), 0), part_NNI_steps(size(), 0);
+    double score = forEachPartition([&](int part) -> double {
+        IQTree *part_tree = (IQTree*)at(part);
         Checkpoint *ckp = new Checkpoint;
         getCheckpoint()->getSubCheckpoint(ckp, part_tree->aln->name);
         part_tree->setCheckpoint(ckp);
         auto num_NNIs = part_tree->doNNISearch(false);
-        NNIs += num_NNIs.first;
-        NNI_steps += num_NNIs.second;
-        score += part_tree->getCurScore();
+        part_NNIs[part] = num_NNIs.first;
+        part_NNI_steps[part] = num_NNIs.second;
 #pragma omp critical
         {
         getCheckpoint()->putSubCheckpoint(ckp, part_tree->aln->name);
@@ -216,6 +214,11 @@ pair<int, int> PhyloSuperTreeUnlinked::doNNISearch(bool write_info) {
         }
         delete ckp;
         part_tree->setCheckpoint(getCheckpoint());
+        return part_tree->getCurScore();
+    });
+    for (int part = 0; part < size(); part++) {
+        NNIs += part_NNIs[part];
+        NNI_steps += part_NNI_steps[part];
     }
 
     setCurScore(score);
@@ -231,9 +234,6 @@ double PhyloSuperTreeUnlinked::doTreeSearch() {
     cout << "|                SEPARATE TREE SEARCH FOR PARTITIONS               |" << endl;
     cout << "--------------------------------------------------------------------" << endl;
 
-    if (part_order.empty())
-        computePartitionOrder();
-
     int saved_flag = params->suppress_output_flags;
     params->suppress_output_flags |= OUT_TREEFILE + OUT_LOG;
     VerboseMode saved_mode = verbose_mode;
@@ -241,14 +241,12 @@ double PhyloSuperTreeUnlinked::doTreeSearch() {
     bool saved_print_ufboot_trees = params->print_ufboot_trees;
     params->print_ufboot_trees = false;
 
-#pragma omp parallel for schedule(dynamic) num_threads(num_threads) if (num_threads > 1) reduction(+: tree_lh)
-    for (int i = 0; i < size(); i++) {
-        IQTree *part_tree = (IQTree*)at(part_order[i]);
+    tree_lh = forEachPartition([&](int part) -> double {
+        IQTree *part_tree = (IQTree*)at(part);
         Checkpoint *ckp = new Checkpoint;
         getCheckpoint()->getSubCheckpoint(ckp, part_tree->aln->name);
         part_tree->setCheckpoint(ckp);
         double score = part_tree->doTreeSearch();
-        tree_lh += score;
 #pragma omp critical
         {
             getCheckpoint()->putSubCheckpoint(ckp, part_tree->aln->name);
@@ -261,7 +259,8 @@ double PhyloSuperTreeUnlinked::doTreeSearch() {
         }
         delete ckp;
         part_tree->setCheckpoint(getCheckpoint());
-    }
+        return score;
+    });
 
     verbose_mode = saved_mode;
     params->suppress_output_flags= saved_flag;
@@ -330,13 +329,10 @@ int PhyloSuperTreeUnlinked::testAllBranches(int threshold, double best_score, do
     ptn_lh[0] = pattern_lh;
     for (id = 1; id < size(); id++)
         ptn_lh[id] = ptn_lh[id-1] + at(id-1)->getAlnNPattern();
-#ifdef _OPENMP
-#pragma omp parallel for reduction(+: num_low_support)
-#endif
-    for (int id = 0; id < size(); id++) {
-        num_low_support += at(id)->testAllBranches(threshold, at(id)->getCurScore(), ptn_lh[id],
+    num_low_support = (int)forEachPartition([&](int id) -> double {
+        return at(id)->testAllBranches(threshold, at(id)->getCurScore(), ptn_lh[id],
                             reps, lbp_reps, aLRT_test, aBayes_test);
-    }
+    });
     return num_low_support;
 }
 
@@ -108,6 +108,9 @@ void PhyloTree::init() {
     dist_matrix = NULL;
     var_matrix = NULL;
     params = NULL;
+    mixed_precision = false;
+    mixed_precision_failed = false;
+    mixed_precision_suspended = false;
     setLikelihoodKernel(LK_SSE2);  // FOR TUNG: you forgot to initialize this variable!
     setNumThreads(1);
     num_threads = 0;
@@ -988,13 +991,13 @@ uint64_t PhyloTree::getMemoryRequired(size_t ncategory, bool full_mem) {
 
     // memory for UFBoot
     if (params->gbo_replicates)
-        mem_size += params->gbo_replicates*nptn*sizeof(BootValType);
+        mem_size += params->gbo_replicates*nptn*sizeof(uint16_t);
 
     // memory for model
     if (model)
         mem_size += model->getMemoryRequired();
 
-    int64_t lh_scale_size = block_size * sizeof(double) + scale_block_size * sizeof(UBYTE);
+    int64_t lh_scale_size = block_size * (mixed_precision ? sizeof(float) : sizeof(double)) + scale_block_size * sizeof(UBYTE);
 
     max_lh_slots = leafNum-2;
 
@@ -1063,7 +1066,7 @@ void PhyloTree::initializeAllPartialLh(int &index, int &indexlh, PhyloNode *node
     size_t nptn = get_safe_upper_limit(aln->size())+ max(get_safe_upper_limit(aln->num_states), get_safe_upper_limit(model_factory->unobserved_ptns.size()));
     uint64_t block_size;
     uint64_t scale_block_size = nptn * site_rate->getNRate() * ((model_factory->fused_mix_rate)? 1 : model->getNMixtures());
-    block_size = scale_block_size * model->num_states;
+    block_size = getPartialLhSize();
 
     if (!node) {
         node = (PhyloNode*) root;
@@ -1196,6 +1199,9 @@ size_t PhyloTree::getPartialLhSize() {
     size_t block_size = get_safe_upper_limit(aln->size())+max(get_safe_upper_limit(aln->num_states),
         get_safe_upper_limit(model_factory->unobserved_ptns.size()));
     block_size *= model->num_states * site_rate->getNRate() * ((model_factory->fused_mix_rate)? 1 : model->getNMixtures());
+    if (mixed_precision)
+        // single-precision entries, two per double
+        block_size = get_safe_upper_limit((block_size+1)/2);
     return block_size;
 }
 
@@ -1234,6 +1240,9 @@ double PhyloTree::computeLikelihood(double *pattern_lh, bool save_log_value) {
     ASSERT(model);
     ASSERT(site_rate);
     ASSERT(root->isLeaf());
+    // allocating the partial likelihoods resets current_it, e.g. after switching precision
+    if (!central_partial_lh)
+        initializeAllPartialLh();
     if (!current_it) {
         Node *leaf = findFarthestLeaf();
         current_it = (PhyloNeighbor*)leaf->neighbors[0];
@@ -1254,6 +1263,12 @@ double PhyloTree::computeLikelihood(double *pattern_lh, bool save_log_value) {
 //    } else {
         score = computeLikelihoodBranch(current_it, (PhyloNode*) current_it_back->node, save_log_value);
 //    }
+    if (mixed_precision && mixed_precision_failed) {
+        // single precision was not good enough: redo everything in double precision
+        outWarning("Numerical problem with single-precision partial likelihoods, switching to double precision");
+        setLikelihoodKernel(sse);
+        return computeLikelihood(pattern_lh, save_log_value);
+    }
     if (pattern_lh)
         memmove(pattern_lh, _pattern_lh, aln->size() * sizeof(double));
 
@@ -1526,6 +1541,7 @@ void PhyloTree::computePatternLikelihood(double *ptn_lh, double *cur_logl, doubl
     
     // New kernel
     int ptn;
+    double log_scaling = (mixed_precision) ? LOG_FLOAT_SCALING_THRESHOLD : LOG_SCALING_THRESHOLD;
     PhyloNeighbor *nei1 = current_it;
     PhyloNeighbor *nei2 = current_it_back;
     if (!nei1->node->isLeaf() && nei2->node->isLeaf()) {
@@ -1543,7 +1559,7 @@ void PhyloTree::computePatternLikelihood(double *ptn_lh, double *cur_logl, doubl
             // per-category scaling
             for (ptn = 0; ptn < nptn; ptn++) {
                 for (i = 0; i < ncat; i++) {
-                    out_lh_cat[i] = log(lh_cat[i]) + nei2_scale[i] * LOG_SCALING_THRESHOLD;
+                    out_lh_cat[i] = log(lh_cat[i]) + nei2_scale[i] * log_scaling;
                 }
                 lh_cat += ncat;
                 out_lh_cat += ncat;
@@ -1552,7 +1568,7 @@ void PhyloTree::computePatternLikelihood(double *ptn_lh, double *cur_logl, doubl
         } else {
             // normal scaling
             for (ptn = 0; ptn < nptn; ptn++) {
-                double scale = nei2_scale[ptn] * LOG_SCALING_THRESHOLD;
+                double scale = nei2_scale[ptn] * log_scaling;
                 for (i = 0; i < ncat; i++)
                     out_lh_cat[i] = log(lh_cat[i]) + scale;
                 lh_cat += ncat;
@@ -1569,7 +1585,7 @@ void PhyloTree::computePatternLikelihood(double *ptn_lh, double *cur_logl, doubl
             // per-category scaling
             for (ptn = 0; ptn < nptn; ptn++) {
                 for (i = 0; i < ncat; i++) {
-                    out_lh_cat[i] = log(lh_cat[i]) + (nei1_scale[i]+nei2_scale[i]) * LOG_SCALING_THRESHOLD;
+                    out_lh_cat[i] = log(lh_cat[i]) + (nei1_scale[i]+nei2_scale[i]) * log_scaling;
                 }
                 lh_cat += ncat;
                 out_lh_cat += ncat;
@@ -1579,7 +1595,7 @@ void PhyloTree::computePatternLikelihood(double *ptn_lh, double *cur_logl, doubl
         } else {
             // normal scaling
             for (ptn = 0; ptn < nptn; ptn++) {
-                double scale = (nei1_scale[ptn] + nei2_scale[ptn]) * LOG_SCALING_THRESHOLD;
+                double scale = (nei1_scale[ptn] + nei2_scale[ptn]) * log_scaling;
                 for (i = 0; i < ncat; i++)
                     out_lh_cat[i] = log(lh_cat[i]) + scale;
                 lh_cat += ncat;
@@ -5915,12 +5931,27 @@ void PhyloTree::reorientPartialLh(PhyloNeighbor* dad_branch, Node *dad) {
         helper functions for computing tree traversal
  ****************************************************************************/
 
+void PhyloTree::pinTraversalPartialLh(PhyloNeighbor *dad_branch, PhyloNode *dad) {
+    PhyloNode *node = (PhyloNode*)dad_branch->node;
+    if (node->isLeaf())
+        return;
+    if (dad_branch->partial_lh_computed & 1) {
+        // frontier of the traversal: computed and reused as is
+        mem_slots.pin(dad_branch);
+        return;
+    }
+    FOR_NEIGHBOR_IT(node, dad, it)
+        pinTraversalPartialLh((PhyloNeighbor*)(*it), node);
+}
+
 bool PhyloTree::computeTraversalInfo(PhyloNeighbor *dad_branch, PhyloNode *dad, double* &buffer) {
 
     size_t nstates = aln->num_states;
     PhyloNode *node = (PhyloNode*)dad_branch->node;
 
     if ((dad_branch->partial_lh_computed & 1) || node->isLeaf()) {
+        if (!node->isLeaf())
+            mem_slots.hit();
         return mem_slots.lock(dad_branch);
     }
 
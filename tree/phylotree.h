@@ -47,6 +47,7 @@
 #include "constrainttree.h"
 #include "memslot.h"
 #include "utils/progress.h"
+#include <functional>
 
 class AlignmentPairwise;
 
@@ -79,6 +80,14 @@ const double TOL_LIKELIHOOD_PARAMOPT = 0.001; // BQM: newly introduced for Model
 //#define LOG_SCALING_THRESHOLD log(SCALING_THRESHOLD)
 #define LOG_SCALING_THRESHOLD -177.4456782233459932741
 
+// scaling threshold for single-precision partial likelihoods (--mixed-precision): 2^{-48}
+#define FLOAT_SCALING_THRESHOLD_EXP 48
+#define FLOAT_SCALING_THRESHOLD 3.552713678800501e-15
+#define LOG_FLOAT_SCALING_THRESHOLD -33.27106466687737
+
+// mixtures whose transition matrices of two children exceed this size are computed class by class (--mix-block)
+const size_t MIX_BLOCK_MIN_BYTES = 1 << 18;
+
 const int SPR_DEPTH = 2;
 
 //using namespace Eigen;
@@ -613,6 +622,21 @@ public:
 
     double dotProductDoubleCall(double *x, double *y, int size);
 
+    /**
+        dot products of one vector x with ny vectors y, used for batched RELL
+        @param x aligned vector of size elements
+        @param y ny aligned vectors, stored y_stride elements apart
+        @param[in,out] res the ny dot products are added to res
+    */
+    template <class Numeric, class VectorClass>
+    void dotProductMultiSIMD(Numeric *x, Numeric *y, size_t y_stride, int ny, int size, double *res);
+
+    typedef void (PhyloTree::*DotProductMultiType)(BootValType *x, BootValType *y, size_t y_stride, int ny, int size, double *res);
+    DotProductMultiType dotProductMulti;
+
+    typedef void (PhyloTree::*DotProductMultiDoubleType)(double *x, double *y, size_t y_stride, int ny, int size, double *res);
+    DotProductMultiDoubleType dotProductMultiDouble;
+
 #if defined(BINARY32) || defined(__NOAVX__)
     void setDotProductAVX() {}
     void setDotProductFMA() {}
@@ -772,6 +796,13 @@ public:
      */
     virtual void deleteAllPartialLh();
 
+    /**
+            print hit/miss statistics of memory slots (memory saving technique)
+     */
+    void reportMemSlots(ostream &out) {
+        mem_slots.report(out);
+    }
+
     /**
             initialize partial_lh vector of all PhyloNeighbors, allocating central_partial_lh
             @param node the current node
@@ -834,6 +865,15 @@ public:
     /** true if using safe numeric for likelihood kernel */
     bool safe_numeric;
 
+    /** true if partial likelihoods are stored in single precision (--mixed-precision) */
+    bool mixed_precision;
+
+    /** true if single-precision kernel ran into numerical problems, always use double afterwards */
+    bool mixed_precision_failed;
+
+    /** true if single-precision partial likelihoods are temporarily switched off */
+    bool mixed_precision_suspended;
+
     /** number of threads used for likelihood kernel */
     int num_threads;
 
@@ -1317,6 +1357,24 @@ public:
     template <class VectorClass, const bool SAFE_NUMERIC, const bool FMA = false, const bool SITE_MODEL = false>
     void computeLikelihoodDervMixlenGenericSIMD(PhyloNeighbor *dad_branch, PhyloNode *dad, double &df, double &ddf);
 
+    /****************************************************************************
+            Mixed-precision kernels: single-precision partial likelihoods,
+            double-precision site likelihoods and derivatives (phylokernelfloat.h)
+            VectorClass is the float vector, DoubleVector its double counterpart
+     ****************************************************************************/
+
+    template <class VectorClass, class DoubleVector, const bool SAFE_NUMERIC, const int nstates, const bool FMA = false>
+    void computePartialLikelihoodFloatSIMD(TraversalInfo &info, size_t ptn_lower, size_t ptn_upper, int thread_id);
+
+    template <class VectorClass, class DoubleVector, const bool SAFE_NUMERIC, const int nstates, const bool FMA = false>
+    double computeLikelihoodBranchFloatSIMD(PhyloNeighbor *dad_branch, PhyloNode *dad, bool save_log_value = true);
+
+    template <class VectorClass, class DoubleVector, const bool SAFE_NUMERIC, const int nstates, const bool FMA = false>
+    void computeLikelihoodBufferFloatSIMD(PhyloNeighbor *dad_branch, PhyloNode *dad, size_t ptn_lower, size_t ptn_upper, int thread_id);
+
+    template <class VectorClass, class DoubleVector, const bool SAFE_NUMERIC, const int nstates, const bool FMA = false>
+    void computeLikelihoodDervFloatSIMD(PhyloNeighbor *dad_branch, PhyloNode *dad, double *df, double *ddf);
+
 
     /*
     template <class VectorClass, const int VCSIZE, const int nstates>
@@ -1345,6 +1403,25 @@ public:
     typedef void (PhyloTree::*ComputeLikelihoodDervMixlenType)(PhyloNeighbor *, PhyloNode *, double &, double &);
     ComputeLikelihoodDervMixlenType computeLikelihoodDervMixlenPointer;
 
+    /**
+            @return TRUE if computeModelGradient() supports the current model, rate heterogeneity and kernel
+     */
+    bool isModelGradientSupported();
+
+    /**
+            compute the gradient of the negative log-likelihood with respect to model parameters.
+            The derivatives with respect to the rate matrices, state frequencies, rate categories
+            and invariant sites are accumulated analytically over all branches in one traversal;
+            they are then chained to the parameters by central differences of these cheap
+            quantities, without recomputing any likelihood.
+            The partial likelihoods must be valid for parameters x.
+            @param ndim number of parameters
+            @param x parameters, indexed from 1
+            @param[out] dfx derivatives, indexed from 1
+            @param set_variables assign a parameter vector to the model without decomposing the rate matrix
+     */
+    void computeModelGradient(int ndim, double x[], double dfx[], const std::function<void(double*)> &set_variables);
+
     /****************************************************************************
             Stepwise addition (greedy) by maximum parsimony
      ****************************************************************************/
@@ -2035,6 +2112,13 @@ public:
 
     virtual void setLikelihoodKernel(LikelihoodKernel lk);
 
+    /**
+        temporarily use double-precision partial likelihoods with --mixed-precision,
+        e.g. while optimizing model parameters with numerical derivatives
+        @param suspend TRUE to switch to double, FALSE to switch back to single precision
+    */
+    void suspendMixedPrecision(bool suspend);
+
     virtual void setNumThreads(int num_threads);
 
 #if defined(BINARY32) || defined(__NOAVX__)
@@ -2401,6 +2485,15 @@ protected:
 
     virtual void reorientPartialLh(PhyloNeighbor* dad_branch, Node *dad);
 
+    /**
+        read ahead for memory saving technique: pin the memory slots of all computed
+        partial_lh that the upcoming traversal towards dad_branch will reuse,
+        so that allocating slots for other subtrees does not evict them
+        @param dad_branch the branch leading to the subtree
+        @param dad its dad, used to direct the traversal
+    */
+    void pinTraversalPartialLh(PhyloNeighbor *dad_branch, PhyloNode *dad);
+
     //----------- memory saving technique ------//
 
     /** maximum number of partial_lh_slots */
@@ -19,6 +19,7 @@
 #define KERNEL_FIX_STATES
 #include "phylokernelnew.h"
 #include "phylokernelnonrev.h"
+#include "phylokernelfloat.h"
 
 #ifndef __AVX__
 #if !defined(__ARM_NEON)
@@ -41,10 +42,13 @@ void PhyloTree::setParsimonyKernelAVX() {
 void PhyloTree::setDotProductAVX() {
 #ifdef BOOT_VAL_FLOAT
 		dotProduct = &PhyloTree::dotProductSIMD<float, Vec8f>;
+		dotProductMulti = &PhyloTree::dotProductMultiSIMD<float, Vec8f>;
 #else
 		dotProduct = &PhyloTree::dotProductSIMD<double, Vec4d>;
+		dotProductMulti = &PhyloTree::dotProductMultiSIMD<double, Vec4d>;
 #endif
         dotProductDouble = &PhyloTree::dotProductSIMD<double, Vec4d>;
+        dotProductMultiDouble = &PhyloTree::dotProductMultiSIMD<double, Vec4d>;
 }
 
 void PhyloTree::setLikelihoodKernelAVX() {
@@ -102,6 +106,45 @@ void PhyloTree::setLikelihoodKernelAVX() {
         return;
     }
 
+    if (mixed_precision) {
+        // single-precision partial likelihoods (--mixed-precision)
+        vector_size = 8;
+        computeLikelihoodDervMixlenPointer = NULL;
+        computeLikelihoodFromBufferPointer = NULL;
+        if (safe_numeric) {
+            switch (aln->num_states) {
+            case 4:
+                computeLikelihoodBranchPointer  = &PhyloTree::computeLikelihoodBranchFloatSIMD <Vec8f, Vec4d, SAFE_LH, 4>;
+                computeLikelihoodDervPointer    = &PhyloTree::computeLikelihoodDervFloatSIMD   <Vec8f, Vec4d, SAFE_LH, 4>;
+                computePartialLikelihoodPointer = &PhyloTree::computePartialLikelihoodFloatSIMD<Vec8f, Vec4d, SAFE_LH, 4>;
+                break;
+            case 20:
+                computeLikelihoodBranchPointer  = &PhyloTree::computeLikelihoodBranchFloatSIMD <Vec8f, Vec4d, SAFE_LH, 20>;
+                computeLikelihoodDervPointer    = &PhyloTree::computeLikelihoodDervFloatSIMD   <Vec8f, Vec4d, SAFE_LH, 20>;
+                computePartialLikelihoodPointer = &PhyloTree::computePartialLikelihoodFloatSIMD<Vec8f, Vec4d, SAFE_LH, 20>;
+                break;
+            default:
+                ASSERT(0 && "Mixed precision only supported for DNA and protein");
+            }
+        } else {
+            switch (aln->num_states) {
+            case 4:
+                computeLikelihoodBranchPointer  = &PhyloTree::computeLikelihoodBranchFloatSIMD <Vec8f, Vec4d, NORM_LH, 4>;
+                computeLikelihoodDervPointer    = &PhyloTree::computeLikelihoodDervFloatSIMD   <Vec8f, Vec4d, NORM_LH, 4>;
+                computePartialLikelihoodPointer = &PhyloTree::computePartialLikelihoodFloatSIMD<Vec8f, Vec4d, NORM_LH, 4>;
+                break;
+            case 20:
+                computeLikelihoodBranchPointer  = &PhyloTree::computeLikelihoodBranchFloatSIMD <Vec8f, Vec4d, NORM_LH, 20>;
+                computeLikelihoodDervPointer    = &PhyloTree::computeLikelihoodDervFloatSIMD   <Vec8f, Vec4d, NORM_LH, 20>;
+                computePartialLikelihoodPointer = &PhyloTree::computePartialLikelihoodFloatSIMD<Vec8f, Vec4d, NORM_LH, 20>;
+                break;
+            default:
+                ASSERT(0 && "Mixed precision only supported for DNA and protein");
+            }
+        }
+        return;
+    }
+
     if ((model_factory && !model_factory->model->isReversible()) || params->kernel_nonrev) {
         // if nonreversible model
         if (safe_numeric) {
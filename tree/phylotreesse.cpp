@@ -88,6 +88,13 @@ void PhyloTree::setParsimonyKernel(LikelihoodKernel lk) {
     ASSERT(0);
 }
 
+void PhyloTree::suspendMixedPrecision(bool suspend) {
+    if (!params || !params->lh_mixed_precision || mixed_precision_suspended == suspend)
+        return;
+    mixed_precision_suspended = suspend;
+    setLikelihoodKernel(sse);
+}
+
 void PhyloTree::setLikelihoodKernel(LikelihoodKernel lk) {
 
 	sse = lk;
@@ -95,6 +102,22 @@ void PhyloTree::setLikelihoodKernel(LikelihoodKernel lk) {
     safe_numeric = (params && (params->lk_safe_scaling || leafNum >= params->numseq_safe_scaling)) ||
         (aln && aln->num_states != 4 && aln->num_states != 20);
 
+    //--- single-precision partial likelihoods, see phylokernelfloat.h ---
+    bool float_lh = params && params->lh_mixed_precision && !mixed_precision_failed && !mixed_precision_suspended &&
+        lk >= LK_AVX &&
+        aln && (aln->num_states == 4 || aln->num_states == 20) && !isSuperTree() && !isMixlen() &&
+        model_factory && model_factory->model->useRevKernel() && !model_factory->model->isSiteSpecificModel() &&
+        model_factory->getASC() == ASC_NONE && params->robust_phy_keep >= 1.0 && !params->robust_median;
+    if (float_lh != mixed_precision) {
+        // layout of partial likelihoods changes, memory will be reallocated on demand
+        if (central_partial_lh)
+            deleteAllPartialLh();
+        mixed_precision = float_lh;
+        // number of memory slots under -mem depends on the size of one entry
+        if (params->lh_mem_save == LM_MEM_SAVE)
+            max_lh_slots = 0;
+    }
+
     //--- parsimony kernel ---
     setParsimonyKernel(lk);
 
@@ -121,6 +144,7 @@ void PhyloTree::setLikelihoodKernel(LikelihoodKernel lk) {
 		dotProduct = &PhyloTree::dotProductSIMD<double, Vec1d>;
 #endif
         dotProductDouble = &PhyloTree::dotProductSIMD<double, Vec1d>;
+        dotProductMultiDouble = &PhyloTree::dotProductMultiSIMD<double, Vec1d>;
 #endif
 	}
 
@@ -1904,3 +1928,320 @@ void PhyloTree::computeAncestralState(PhyloNeighbor *dad_branch, PhyloNode *dad,
 
 
 
+
+/****************************************************************************
+    Analytic gradient of the log-likelihood with respect to model parameters.
+
+    For a reversible model Q = V diag(lambda) V^-1, the partial likelihoods of both
+    sides of a branch are stored in the eigen space (a = V^-1 A, b = V^-1 B), so that
+    the likelihood of category c is sum_i a_i b_i exp(lambda_i s), s = rate_c * t.
+    The derivative of P(s) = exp(Q s) in direction dQ is V (Phi o V^-1 dQ V) V^-1 with
+    Phi_ij = (exp(lambda_i s) - exp(lambda_j s)) / (lambda_i - lambda_j), hence
+
+        dlnL/dQ_xy = sum_branches sum_ij V^-1_ix V_yj Phi_ij sum_ptn w_ptn/L_ptn a_i b_j,
+
+    where a belongs to the side of the root leaf. Together with the derivatives with
+    respect to the root frequencies, category proportions and rates and the invariant
+    site likelihoods, this gives the derivative with respect to every quantity entering
+    the kernel after one traversal of the tree.
+ ****************************************************************************/
+
+/** relative step to differentiate the mapping from model parameters to rate matrices */
+const double MODEL_GRADIENT_STEP = 1e-6;
+
+/**
+    @return (exp(li*s) - exp(lj*s)) / (li - lj), the divided difference of exp(lambda*s)
+*/
+inline double dividedDifferenceExp(double li, double lj, double s) {
+    double d = (li - lj) * s;
+    if (fabs(d) < 1e-8)
+        return s * exp(lj * s) * (1.0 + 0.5 * d);
+    return exp(lj * s) * expm1(d) / (li - lj);
+}
+
+bool PhyloTree::isModelGradientSupported() {
+    if (!params->analytic_gradient || !model_factory || !model || !site_rate || !root || !root->isLeaf())
+        return false;
+    if (params->matrix_exp_technique != MET_EIGEN_DECOMPOSITION &&
+        params->matrix_exp_technique != MET_EIGEN3LIB_DECOMPOSITION)
+        return false;
+    if (!model->useRevKernel() || model->isSiteSpecificModel() || model->containDNAerror() ||
+        site_rate->isSiteSpecificRate() || isMixlen() || isSuperTree() || mixed_precision)
+        return false;
+    if (aln->seq_type == SEQ_POMO || model->num_states != aln->num_states)
+        return false;
+    if (!model_factory->unobserved_ptns.empty() || model_factory->getASC() != ASC_NONE)
+        return false;
+    if (params->robust_phy_keep < 1.0 || params->robust_median)
+        return false;
+    size_t nstates = aln->num_states;
+    size_t nmix = model->getNMixtures();
+    DoubleVector q_mat(nmix*nstates*nstates), freq(nmix*nstates);
+    return model->computeNormalizedRateMatrix(q_mat.data(), freq.data());
+}
+
+void PhyloTree::computeModelGradient(int ndim, double x[], double dfx[], const std::function<void(double*)> &set_variables) {
+    size_t nstates = aln->num_states;
+    size_t nsq = nstates * nstates;
+    size_t nmix = model->getNMixtures();
+    size_t ncat = site_rate->getNRate();
+    size_t ncat_mix = (model_factory->fused_mix_rate) ? ncat : ncat*nmix;
+    size_t denom = (model_factory->fused_mix_rate) ? 1 : ncat;
+    size_t block = ncat_mix * nstates;
+    size_t tip_block = nstates * nmix;
+    size_t nptn = aln->size();
+    size_t V = vector_size;
+
+    // layout of the quantities entering the kernel and of their gradient
+    size_t q_offset = 0;
+    size_t freq_offset = q_offset + nmix*nsq;
+    size_t prop_offset = freq_offset + nmix*nstates;
+    size_t rate_offset = prop_offset + ncat_mix;
+    size_t invar_offset = rate_offset + ncat_mix;
+    size_t total = invar_offset + nptn;
+    DoubleVector grad(total, 0.0);
+
+    double *eval = model->getEigenvalues();
+    double *evec = model->getEigenvectors();
+    double *inv_evec = model->getInverseEigenvectors();
+
+    // branches ordered from the root leaf, first node is closer to the root
+    vector<pair<PhyloNode*, PhyloNode*> > branches;
+    vector<pair<PhyloNode*, PhyloNode*> > stack;
+    stack.push_back(make_pair((PhyloNode*)nullptr, (PhyloNode*)root));
+    while (!stack.empty()) {
+        PhyloNode *node = stack.back().second;
+        PhyloNode *dad = stack.back().first;
+        stack.pop_back();
+        if (dad)
+            branches.push_back(make_pair(dad, node));
+        FOR_NEIGHBOR_IT(node, dad, it)
+            stack.push_back(make_pair(node, (PhyloNode*)(*it)->node));
+    }
+
+    int nthreads = 1;
+#ifdef _OPENMP
+    nthreads = max(num_threads, 1);
+#endif
+    // sum over patterns of w_ptn/L_ptn * a * b^T per category, one copy per thread
+    DoubleVector outer(nthreads * ncat_mix * nsq);
+    DoubleVector cat_exp(block);
+
+    // tip likelihood vectors of all tip states repeated for all categories
+    size_t ntipstates = aln->STATE_UNKNOWN+1;
+    DoubleVector tip_lh(ntipstates*block);
+    for (size_t state = 0; state < ntipstates; state++)
+        for (size_t c = 0; c < ncat_mix; c++)
+            memcpy(&tip_lh[state*block + c*nstates], tip_partial_lh + state*tip_block + (c/denom)*nstates, nstates*sizeof(double));
+
+    for (auto branch = branches.begin(); branch != branches.end(); branch++) {
+        PhyloNode *dad = branch->first;
+        PhyloNode *node = branch->second;
+        PhyloNeighbor *dad_branch = (PhyloNeighbor*)dad->findNeighbor(node);
+        PhyloNeighbor *node_branch = (PhyloNeighbor*)node->findNeighbor(dad);
+        bool is_root_branch = (dad == root);
+        computeLikelihoodBranch(dad_branch, dad);
+
+        // for a terminal branch, sum the weighted internal vectors per tip state first
+        PhyloNode *leaf = dad->isLeaf() ? dad : (node->isLeaf() ? node : nullptr);
+        const char *leaf_row = leaf ? getConvertedSequenceByNumber(leaf->id) : nullptr;
+        double len = dad_branch->length;
+        double cat_len[ncat_mix], cat_prop[ncat_mix];
+        for (size_t c = 0; c < ncat_mix; c++) {
+            size_t mycat = c%ncat;
+            cat_len[c] = site_rate->getRate(mycat) * len;
+            cat_prop[c] = site_rate->getProp(mycat) * model->getMixtureWeight(c/denom);
+            for (size_t i = 0; i < nstates; i++)
+                cat_exp[c*nstates+i] = exp(eval[(c/denom)*nstates+i] * cat_len[c]);
+        }
+        std::fill(outer.begin(), outer.end(), 0.0);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+        {
+            int thread_id = 0;
+#ifdef _OPENMP
+            thread_id = omp_get_thread_num();
+#endif
+            double *this_outer = &outer[thread_id * ncat_mix * nsq];
+            DoubleVector tip_sum(leaf ? ntipstates*block : 0, 0.0);
+            double lh_cat[ncat_mix], scale_cat[ncat_mix], weight[ncat_mix];
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (size_t ptn = 0; ptn < nptn; ptn++) {
+                // a: side of the root leaf, b: the other side, with strides in the partial likelihood layout
+                size_t offset = (ptn - ptn%V)*block + ptn%V;
+                int state = 0;
+                if (leaf)
+                    state = leaf_row ? leaf_row[ptn] : (*aln)[ptn][leaf->id];
+                const double *lh_a, *lh_b;
+                size_t stride_a = V, stride_b = V;
+                if (dad->isLeaf()) {
+                    lh_a = &tip_lh[state*block];
+                    stride_a = 1;
+                } else
+                    lh_a = node_branch->partial_lh + offset;
+                if (node->isLeaf()) {
+                    lh_b = &tip_lh[state*block];
+                    stride_b = 1;
+                } else
+                    lh_b = dad_branch->partial_lh + offset;
+
+                // likelihood per category with its scaling count
+                double scale_min = 0.0;
+                for (size_t c = 0; c < ncat_mix; c++) {
+                    double lh = 0.0;
+                    for (size_t i = c*nstates; i < (c+1)*nstates; i++)
+                        lh += lh_a[i*stride_a] * lh_b[i*stride_b] * cat_exp[i];
+                    lh_cat[c] = lh;
+                    size_t scale_id = safe_numeric ? ptn*ncat_mix+c : ptn;
+                    scale_cat[c] = (dad->isLeaf() ? 0 : node_branch->scale_num[scale_id]) +
+                                   (node->isLeaf() ? 0 : dad_branch->scale_num[scale_id]);
+                    if (c == 0 || scale_cat[c] < scale_min)
+                        scale_min = scale_cat[c];
+                }
+                // likelihood of the pattern relative to the least scaled category
+                double lh_ptn = 0.0;
+                for (size_t c = 0; c < ncat_mix; c++) {
+                    scale_cat[c] = (scale_cat[c] == scale_min) ? 1.0 :
+                        ldexp(1.0, -SCALING_THRESHOLD_EXP * (int)(scale_cat[c] - scale_min));
+                    lh_ptn += cat_prop[c] * scale_cat[c] * fabs(lh_cat[c]);
+                }
+                if (scale_min == 0.0)
+                    lh_ptn += ptn_invar[ptn];
+                if (lh_ptn <= 0.0)
+                    continue;
+                double ptn_weight = ptn_freq[ptn] / lh_ptn;
+                if (is_root_branch && scale_min == 0.0)
+                    grad[invar_offset + ptn] = ptn_weight;
+                for (size_t c = 0; c < ncat_mix; c++)
+                    weight[c] = ptn_weight * scale_cat[c];
+
+                if (leaf) {
+                    const double *lh_inner = dad->isLeaf() ? lh_b : lh_a;
+                    double *this_sum = &tip_sum[state*block];
+                    for (size_t c = 0; c < ncat_mix; c++)
+                        for (size_t i = c*nstates; i < (c+1)*nstates; i++)
+                            this_sum[i] += weight[c] * lh_inner[i*V];
+                    continue;
+                }
+                for (size_t c = 0; c < ncat_mix; c++) {
+                    double *outer_cat = this_outer + c*nsq;
+                    const double *b = lh_b + c*nstates*V;
+                    for (size_t i = 0; i < nstates; i++) {
+                        double wa = weight[c] * lh_a[(c*nstates+i)*V];
+                        for (size_t j = 0; j < nstates; j++)
+                            outer_cat[i*nstates+j] += wa * b[j*V];
+                    }
+                }
+            }
+            // expand the per-state sums with the tip vectors
+            for (size_t state = 0; leaf && state < ntipstates; state++) {
+                double *this_sum = &tip_sum[state*block];
+                double *this_tip = &tip_lh[state*block];
+                for (size_t c = 0; c < ncat_mix; c++) {
+                    double *outer_cat = this_outer + c*nsq;
+                    for (size_t i = 0; i < nstates; i++)
+                        for (size_t j = 0; j < nstates; j++)
+                            outer_cat[i*nstates+j] += dad->isLeaf() ?
+                                this_tip[c*nstates+i] * this_sum[c*nstates+j] :
+                                this_sum[c*nstates+i] * this_tip[c*nstates+j];
+                }
+            }
+        }
+        for (int t = 1; t < nthreads; t++)
+            for (size_t i = 0; i < ncat_mix*nsq; i++)
+                outer[i] += outer[t*ncat_mix*nsq + i];
+
+        // derivatives of this branch, rate matrices still in the eigen space
+        for (size_t c = 0; c < ncat_mix; c++) {
+            size_t m = c/denom;
+            double *eval_ptr = eval + m*nstates;
+            double *outer_cat = &outer[c*nsq];
+            double s = cat_len[c];
+            double *grad_q = &grad[q_offset + m*nsq];
+            double *expval = &cat_exp[c*nstates];
+            for (size_t i = 0; i < nstates; i++)
+                for (size_t j = 0; j < nstates; j++)
+                    grad_q[i*nstates+j] += cat_prop[c] * outer_cat[i*nstates+j] * dividedDifferenceExp(eval_ptr[i], eval_ptr[j], s);
+            double diag = 0.0, diag_rate = 0.0;
+            for (size_t i = 0; i < nstates; i++) {
+                diag += outer_cat[i*nstates+i] * expval[i];
+                diag_rate += outer_cat[i*nstates+i] * eval_ptr[i] * len * expval[i];
+            }
+            grad[rate_offset + c] += cat_prop[c] * diag_rate;
+            if (!is_root_branch)
+                continue;
+            grad[prop_offset + c] = diag;
+            // root frequencies: A_x = sum_i V_xi a_i and (P B)_x = sum_j V_xj exp(lambda_j s) b_j
+            double *evec_ptr = evec + m*nsq;
+            double *grad_freq = &grad[freq_offset + m*nstates];
+            for (size_t x = 0; x < nstates; x++) {
+                double sum = 0.0;
+                for (size_t i = 0; i < nstates; i++) {
+                    double row = 0.0;
+                    for (size_t j = 0; j < nstates; j++)
+                        row += outer_cat[i*nstates+j] * expval[j] * evec_ptr[x*nstates+j];
+                    sum += evec_ptr[x*nstates+i] * row;
+                }
+                grad_freq[x] += cat_prop[c] * sum;
+            }
+        }
+    }
+
+    // transform to the state space: dlnL/dQ_xy = sum_ij Vinv_ix M_ij V_yj
+    DoubleVector tmp(nsq);
+    for (size_t m = 0; m < nmix; m++) {
+        double *grad_q = &grad[q_offset + m*nsq];
+        double *evec_ptr = evec + m*nsq;
+        double *inv_evec_ptr = inv_evec + m*nsq;
+        for (size_t x = 0; x < nstates; x++)
+            for (size_t j = 0; j < nstates; j++) {
+                double sum = 0.0;
+                for (size_t i = 0; i < nstates; i++)
+                    sum += inv_evec_ptr[i*nstates+x] * grad_q[i*nstates+j];
+                tmp[x*nstates+j] = sum;
+            }
+        for (size_t x = 0; x < nstates; x++)
+            for (size_t y = 0; y < nstates; y++) {
+                double sum = 0.0;
+                for (size_t j = 0; j < nstates; j++)
+                    sum += tmp[x*nstates+j] * evec_ptr[y*nstates+j];
+                grad_q[x*nstates+y] = sum;
+            }
+    }
+
+    // chain rule: differentiate the cheap mapping from parameters to kernel quantities
+    auto getKernelQuantities = [&](DoubleVector &values) {
+        values.resize(total);
+        model->computeNormalizedRateMatrix(&values[q_offset], &values[freq_offset]);
+        for (size_t c = 0; c < ncat_mix; c++) {
+            values[prop_offset + c] = site_rate->getProp(c%ncat) * model->getMixtureWeight(c/denom);
+            values[rate_offset + c] = site_rate->getRate(c%ncat);
+        }
+        computePtnInvar();
+        memcpy(&values[invar_offset], ptn_invar, nptn*sizeof(double));
+    };
+    DoubleVector values_plus, values_minus;
+    for (int k = 1; k <= ndim; k++) {
+        double saved = x[k];
+        double h = MODEL_GRADIENT_STEP * fabs(saved);
+        if (h == 0.0)
+            h = MODEL_GRADIENT_STEP;
+        x[k] = saved + h;
+        set_variables(x);
+        getKernelQuantities(values_plus);
+        x[k] = saved - h;
+        set_variables(x);
+        getKernelQuantities(values_minus);
+        x[k] = saved;
+        double dlnl = 0.0;
+        for (size_t i = 0; i < total; i++)
+            dlnl += grad[i] * (values_plus[i] - values_minus[i]);
+        dfx[k] = -dlnl / (2.0 * h);
+    }
+    set_variables(x);
+    computePtnInvar();
+}
@@ -11,6 +11,7 @@
 
 #include "phylotree.h"
 #include "phylosupertree.h"
+#include "quartetengine.h"
 #include "model/partitionmodel.h"
 #include "alignment/alignment.h"
 #if 0 // (HAS-bla)
@@ -828,6 +829,17 @@ void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info
     
     // fprintf(stderr,"XXX - #quarts: %d; #groups: %d, A: %d, B:%d, C:%d, D:%d\n", LMGroups.uniqueQuarts, LMGroups.numGroups, sizeA, sizeB, sizeC, sizeD);
     
+    // use the dedicated 4-taxon engine unless the model needs the generic machinery
+    bool use_quartet_engine = QuartetEngine::isSupported(this);
+    AlignmentSummary *quartet_summary = NULL;
+    if (use_quartet_engine) {
+        // sequence matrix of all sites, shared by the quartet engines of all threads
+        quartet_summary = new AlignmentSummary(aln, true, true);
+        if (!quartet_summary->constructSequenceMatrix(false))
+            use_quartet_engine = false;
+    }
+    if (!use_quartet_engine && verbose_mode >= VB_MED)
+        cout << "Quartet likelihoods are computed with the generic likelihood kernel" << endl;
 
 #ifdef _OPENMP
     #pragma omp parallel
@@ -837,6 +849,9 @@ void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info
 #else
     int *rstream = randstream;
 #endif    
+    QuartetEngine *quartet_engine = NULL;
+    if (use_quartet_engine)
+        quartet_engine = new QuartetEngine(this, quartet_summary);
 
 #ifdef _OPENMP
     #pragma omp for schedule(guided)
@@ -891,92 +906,96 @@ void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info
 	// *** taxa should not be sorted, because that changes the corners a dot is assigned to - removed HAS ;^)
         // obsolete: sort(lmap_quartet_info[qid].seqID, lmap_quartet_info[qid].seqID+4); // why sort them?!? HAS ;^)
 
-        // initialize sub-alignment and sub-tree
-        Alignment *quartet_aln;
-        if (aln->isSuperAlignment()) {
-            quartet_aln = new SuperAlignment;
-        } else {
-            quartet_aln = new Alignment;
-        }
-        IntVector seq_id;
-        seq_id.insert(seq_id.begin(), lmap_quartet_info[qid].seqID, lmap_quartet_info[qid].seqID+4);
-        IntVector kept_partitions;
-        // only keep partitions with at least 3 sequences
-        quartet_aln->extractSubAlignment(aln, seq_id, 0, 3, &kept_partitions);
-                
-        if (kept_partitions.size() == 0) {
-            // nothing kept
-            for (int k = 0; k < 3; k++) {
-                lmap_quartet_info[qid].logl[k] = -1.0;
-            }
+        if (quartet_engine) {
+            quartet_engine->computeQuartetLikelihoods(lmap_quartet_info[qid].seqID, lmap_quartet_info[qid].logl);
         } else {
-            // something partition kept, do computations
-            if (quartet_aln->ordered_pattern.empty())
-                quartet_aln->orderPatternByNumChars(PAT_VARIANT);
-            PhyloTree *quartet_tree;
-            if (isSuperTree()) {
-                quartet_tree = new PhyloSuperTree((SuperAlignment*)quartet_aln, (PhyloSuperTree*)this);
+            // initialize sub-alignment and sub-tree
+            Alignment *quartet_aln;
+            if (aln->isSuperAlignment()) {
+                quartet_aln = new SuperAlignment;
             } else {
-                quartet_tree = new PhyloTree(quartet_aln);
+                quartet_aln = new Alignment;
             }
-
-            // set up parameters
-            quartet_tree->setParams(params);
-            quartet_tree->optimize_by_newton = params->optimize_by_newton;
-            quartet_tree->setLikelihoodKernel(params->SSE);
-            quartet_tree->setNumThreads(num_threads);
-
-            // set model and rate
-            quartet_tree->setModelFactory(model_factory);
-            quartet_tree->setModel(getModel());
-            quartet_tree->setRate(getRate());
-
-            // set up partition model
-            if (isSuperTree()) {
-                PhyloSuperTree *quartet_super_tree = (PhyloSuperTree*)quartet_tree;
-                PhyloSuperTree *super_tree = (PhyloSuperTree*)this;
-                for (int i = 0; i < quartet_super_tree->size(); i++) {
-                    quartet_super_tree->at(i)->setModelFactory(super_tree->at(kept_partitions[i])->getModelFactory());
-                    quartet_super_tree->at(i)->setModel(super_tree->at(kept_partitions[i])->getModel());
-                    quartet_super_tree->at(i)->setRate(super_tree->at(kept_partitions[i])->getRate());
-                    //quartet_super_tree->at(i)->aln->buildSeqStates(quartet_super_tree->at(i)->getModel()->seq_states);
+            IntVector seq_id;
+            seq_id.insert(seq_id.begin(), lmap_quartet_info[qid].seqID, lmap_quartet_info[qid].seqID+4);
+            IntVector kept_partitions;
+            // only keep partitions with at least 3 sequences
+            quartet_aln->extractSubAlignment(aln, seq_id, 0, 3, &kept_partitions);
+                
+            if (kept_partitions.size() == 0) {
+                // nothing kept
+                for (int k = 0; k < 3; k++) {
+                    lmap_quartet_info[qid].logl[k] = -1.0;
                 }
             } else {
-                //quartet_aln->buildSeqStates(getModel()->seq_states);
-            }
+                // something partition kept, do computations
+                if (quartet_aln->ordered_pattern.empty())
+                    quartet_aln->orderPatternByNumChars(PAT_VARIANT);
+                PhyloTree *quartet_tree;
+                if (isSuperTree()) {
+                    quartet_tree = new PhyloSuperTree((SuperAlignment*)quartet_aln, (PhyloSuperTree*)this);
+                } else {
+                    quartet_tree = new PhyloTree(quartet_aln);
+                }
+
+                // set up parameters
+                quartet_tree->setParams(params);
+                quartet_tree->optimize_by_newton = params->optimize_by_newton;
+                quartet_tree->setLikelihoodKernel(params->SSE);
+                quartet_tree->setNumThreads(num_threads);
+
+                // set model and rate
+                quartet_tree->setModelFactory(model_factory);
+                quartet_tree->setModel(getModel());
+                quartet_tree->setRate(getRate());
+
+                // set up partition model
+                if (isSuperTree()) {
+                    PhyloSuperTree *quartet_super_tree = (PhyloSuperTree*)quartet_tree;
+                    PhyloSuperTree *super_tree = (PhyloSuperTree*)this;
+                    for (int i = 0; i < quartet_super_tree->size(); i++) {
+                        quartet_super_tree->at(i)->setModelFactory(super_tree->at(kept_partitions[i])->getModelFactory());
+                        quartet_super_tree->at(i)->setModel(super_tree->at(kept_partitions[i])->getModel());
+                        quartet_super_tree->at(i)->setRate(super_tree->at(kept_partitions[i])->getRate());
+                        //quartet_super_tree->at(i)->aln->buildSeqStates(quartet_super_tree->at(i)->getModel()->seq_states);
+                    }
+                } else {
+                    //quartet_aln->buildSeqStates(getModel()->seq_states);
+                }
             
-            // NOTE: we don't need to set phylo_tree in model and rate because parameters are not reoptimized
+                // NOTE: we don't need to set phylo_tree in model and rate because parameters are not reoptimized
             
             
             
-            // loop over 3 quartets to compute likelihood
-            for (int k = 0; k < 3; k++) {
-                string quartet_tree_str;
-                quartet_tree_str = "(" + quartet_aln->getSeqName(qc[k*4]) + "," + quartet_aln->getSeqName(qc[k*4+1]) + ",(" + 
-                    quartet_aln->getSeqName(qc[k*4+2]) + "," + quartet_aln->getSeqName(qc[k*4+3]) + "));";
-                quartet_tree->readTreeStringSeqName(quartet_tree_str);
-                quartet_tree->initializeAllPartialLh();
-                quartet_tree->wrapperFixNegativeBranch(true);
-                // optimize branch lengths with logl_epsilon=0.1 accuracy
-                lmap_quartet_info[qid].logl[k] = quartet_tree->optimizeAllBranches(10, 0.1);
-            }
-            // reset model & rate so that they are not deleted
-            quartet_tree->setModel(NULL);
-            quartet_tree->setModelFactory(NULL);
-            quartet_tree->setRate(NULL);
-
-            if (isSuperTree()) {
-                PhyloSuperTree *quartet_super_tree = (PhyloSuperTree*)quartet_tree;
-                for (int i = 0; i < quartet_super_tree->size(); i++) {
-                    quartet_super_tree->at(i)->setModelFactory(NULL);
-                    quartet_super_tree->at(i)->setModel(NULL);
-                    quartet_super_tree->at(i)->setRate(NULL);
+                // loop over 3 quartets to compute likelihood
+                for (int k = 0; k < 3; k++) {
+                    string quartet_tree_str;
+                    quartet_tree_str = "(" + quartet_aln->getSeqName(qc[k*4]) + "," + quartet_aln->getSeqName(qc[k*4+1]) + ",(" + 
+                        quartet_aln->getSeqName(qc[k*4+2]) + "," + quartet_aln->getSeqName(qc[k*4+3]) + "));";
+                    quartet_tree->readTreeStringSeqName(quartet_tree_str);
+                    quartet_tree->initializeAllPartialLh();
+                    quartet_tree->wrapperFixNegativeBranch(true);
+                    // optimize branch lengths with logl_epsilon=0.1 accuracy
+                    lmap_quartet_info[qid].logl[k] = quartet_tree->optimizeAllBranches(10, 0.1);
                 }
+                // reset model & rate so that they are not deleted
+                quartet_tree->setModel(NULL);
+                quartet_tree->setModelFactory(NULL);
+                quartet_tree->setRate(NULL);
+
+                if (isSuperTree()) {
+                    PhyloSuperTree *quartet_super_tree = (PhyloSuperTree*)quartet_tree;
+                    for (int i = 0; i < quartet_super_tree->size(); i++) {
+                        quartet_super_tree->at(i)->setModelFactory(NULL);
+                        quartet_super_tree->at(i)->setModel(NULL);
+                        quartet_super_tree->at(i)->setRate(NULL);
+                    }
+                }
+                delete quartet_tree;
             }
-            delete quartet_tree;
-        }
         
-        delete quartet_aln;
+            delete quartet_aln;
+        }
 
         // determine likelihood order
         int qworder[3]; // local (thread-safe) vector for sorting
@@ -1147,11 +1166,16 @@ void PhyloTree::computeQuartetLikelihoods(vector<QuartetInfo> &lmap_quartet_info
 		}
 	}
     } /*** end draw lmap_num_quartets quartets randomly ***/
+    if (quartet_engine)
+        delete quartet_engine;
 #ifdef _OPENMP
     finish_random(rstream);
     }
 #endif
 
+    if (quartet_summary)
+        delete quartet_summary;
+
     if ((params->lmap_num_quartets % 5000) != 0) {
 	cout << ". : " << params->lmap_num_quartets << flush << endl << endl;
     } else cout << endl;
@@ -0,0 +1,451 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "phylotree.h"
+#include "quartetengine.h"
+#include "model/modelfactory.h"
+
+/** max size of the lookup table of quartet patterns (e.g. 24^4 for amino acids) */
+#define QUARTET_MAX_LOOKUP (1 << 20)
+
+/** max number of rounds over the 5 branches, as in optimizeAllBranches(10, 0.1) */
+#define QUARTET_MAX_ROUNDS 10
+
+/** stop if a round improves the log-likelihood by less than this */
+#define QUARTET_LOGL_EPS 0.1
+
+QuartetEngine::QuartetEngine(PhyloTree *tree, AlignmentSummary *aln_summary) {
+    aln = tree->aln;
+    summary = aln_summary;
+    ModelSubst *model = tree->getModel();
+    RateHeterogeneity *site_rate = tree->getRate();
+    nstates = model->num_states;
+    ntipstates = aln->STATE_UNKNOWN+1;
+    ncat = site_rate->getNRate();
+    ASSERT(summary->sequenceMatrix);
+
+    size_t mat_size = nstates*nstates;
+    eval = aligned_alloc<double>(nstates);
+    evec = aligned_alloc<double>(mat_size);
+    inv_evec = aligned_alloc<double>(mat_size);
+    state_freq = aligned_alloc<double>(nstates);
+    memcpy(eval, model->getEigenvalues(), nstates*sizeof(double));
+    memcpy(evec, model->getEigenvectors(), mat_size*sizeof(double));
+    memcpy(inv_evec, model->getInverseEigenvectors(), mat_size*sizeof(double));
+    inv_evec_t = aligned_alloc<double>(mat_size);
+    for (int x = 0; x < nstates; x++)
+        for (int k = 0; k < nstates; k++)
+            inv_evec_t[x*nstates+k] = inv_evec[k*nstates+x];
+    model->getStateFrequency(state_freq);
+
+    cat_rate = aligned_alloc<double>(ncat);
+    cat_prop = aligned_alloc<double>(ncat);
+    for (int c = 0; c < ncat; c++) {
+        cat_rate[c] = site_rate->getRate(c);
+        cat_prop[c] = site_rate->getProp(c);
+    }
+    p_invar = site_rate->getPInvar();
+
+    tip_lh = aligned_alloc<double>(ntipstates*nstates);
+    tip_eigen = aligned_alloc<double>(ntipstates*nstates);
+    for (int state = 0; state < ntipstates; state++) {
+        double *lh = &tip_lh[state*nstates];
+        model->computeTipLikelihood(state, lh);
+        // tip vector of a terminal branch in eigen space: sum_x pi_x lh_x evec_xk
+        for (int k = 0; k < nstates; k++) {
+            double sum = 0.0;
+            for (int x = 0; x < nstates; x++)
+                sum += state_freq[x] * lh[x] * evec[x*nstates+k];
+            tip_eigen[state*nstates+k] = sum;
+        }
+    }
+
+    for (int i = 0; i < 4; i++)
+        tip_trans[i] = aligned_alloc<double>(ntipstates*ncat*nstates);
+    internal_trans = aligned_alloc<double>(ncat*mat_size);
+    tip_mat = aligned_alloc<double>(ncat*mat_size);
+    val0 = aligned_alloc<double>(ncat*nstates);
+    val1 = aligned_alloc<double>(ncat*nstates);
+    val2 = aligned_alloc<double>(ncat*nstates);
+
+    // number of quartet patterns is bounded by the number of tip state combinations
+    ptn_lookup.resize(ntipstates*ntipstates*ntipstates*ntipstates, -1);
+    max_quartptn = min(summary->sequenceLength, ptn_lookup.size());
+    theta = aligned_alloc<double>(max(max_quartptn, (size_t)1)*ncat*nstates);
+    far_partial = aligned_alloc<double>(max(max_quartptn, (size_t)1)*ncat*nstates);
+    nquartptn = 0;
+
+    Params &params = Params::getInstance();
+    min_brlen = params.min_branch_length;
+    max_brlen = params.max_branch_length;
+}
+
+QuartetEngine::~QuartetEngine() {
+    aligned_free(far_partial);
+    aligned_free(theta);
+    aligned_free(val2);
+    aligned_free(val1);
+    aligned_free(val0);
+    aligned_free(tip_mat);
+    aligned_free(internal_trans);
+    for (int i = 3; i >= 0; i--)
+        aligned_free(tip_trans[i]);
+    aligned_free(tip_eigen);
+    aligned_free(tip_lh);
+    aligned_free(cat_prop);
+    aligned_free(cat_rate);
+    aligned_free(state_freq);
+    aligned_free(inv_evec_t);
+    aligned_free(inv_evec);
+    aligned_free(evec);
+    aligned_free(eval);
+}
+
+bool QuartetEngine::isSupported(PhyloTree *tree) {
+    if (tree->isSuperTree())
+        return false;
+    ModelSubst *model = tree->getModel();
+    RateHeterogeneity *site_rate = tree->getRate();
+    if (!model || !site_rate || !tree->getModelFactory())
+        return false;
+    if (!model->useRevKernel() || model->isMixture() || model->isSiteSpecificModel())
+        return false;
+    if (site_rate->isSiteSpecificRate() || site_rate->isHeterotachy())
+        return false;
+    if (tree->getModelFactory()->getASC() != ASC_NONE)
+        return false;
+    if (tree->aln->seq_type == SEQ_POMO)
+        return false;
+    // for larger state spaces the vectorized kernels of PhyloTree are faster
+    if (tree->aln->num_states > 4)
+        return false;
+    // states must fit the lookup table of quartet patterns
+    int ntipstates = tree->aln->STATE_UNKNOWN+1;
+    if (ntipstates > 127 || ntipstates*ntipstates*ntipstates*ntipstates > QUARTET_MAX_LOOKUP)
+        return false;
+    return true;
+}
+
+void QuartetEngine::compressPatterns(int *seq_id) {
+    // walk the 4 rows of the sequence matrix and count the distinct state combinations
+    size_t nsite = summary->sequenceLength;
+    const int *site_freq = summary->siteFrequencies.data();
+    const unsigned char *row[4];
+    for (int i = 0; i < 4; i++)
+        row[i] = (const unsigned char*)summary->sequenceMatrix + seq_id[i]*nsite;
+    ptn_states.clear();
+    ptn_freq.clear();
+    for (size_t site = 0; site < nsite; site++) {
+        int key = ((row[0][site]*ntipstates + row[1][site])*ntipstates + row[2][site])*ntipstates + row[3][site];
+        int id = ptn_lookup[key];
+        if (id < 0) {
+            id = ptn_lookup[key] = ptn_freq.size();
+            for (int i = 0; i < 4; i++)
+                ptn_states.push_back(row[i][site]);
+            ptn_freq.push_back(0.0);
+        }
+        ptn_freq[id] += site_freq[site];
+    }
+    nquartptn = ptn_freq.size();
+
+    // reset only the touched entries of the lookup table
+    ptn_invar.resize(nquartptn);
+    for (size_t ptn = 0; ptn < nquartptn; ptn++) {
+        StateType *states = &ptn_states[ptn*4];
+        ptn_lookup[((states[0]*ntipstates + states[1])*ntipstates + states[2])*ntipstates + states[3]] = -1;
+        // likelihood of the invariant category: pi_x * prod_i tip_i[x]
+        double lh_invar = 0.0;
+        if (p_invar != 0.0) {
+            for (int x = 0; x < nstates; x++) {
+                double lh = state_freq[x];
+                for (int i = 0; i < 4; i++)
+                    lh *= tip_lh[states[i]*nstates + x];
+                lh_invar += lh;
+            }
+            lh_invar *= p_invar;
+        }
+        ptn_invar[ptn] = lh_invar;
+    }
+
+    if (nquartptn > max_quartptn) {
+        aligned_free(far_partial);
+        aligned_free(theta);
+        max_quartptn = nquartptn;
+        theta = aligned_alloc<double>(max_quartptn*ncat*nstates);
+        far_partial = aligned_alloc<double>(max_quartptn*ncat*nstates);
+    }
+
+    // JC distances between the 4 sequences, used as starting branch lengths
+    for (int i = 0; i < 4; i++) {
+        pair_dist[i*4+i] = 0.0;
+        for (int j = i+1; j < 4; j++) {
+            double total = 0.0, diff = 0.0;
+            for (size_t ptn = 0; ptn < nquartptn; ptn++) {
+                StateType si = ptn_states[ptn*4+i], sj = ptn_states[ptn*4+j];
+                if (si < nstates && sj < nstates) {
+                    total += ptn_freq[ptn];
+                    if (si != sj)
+                        diff += ptn_freq[ptn];
+                }
+            }
+            double dist = (total > 0.0) ? aln->computeJCDistanceFromObservedDistance(diff/total) : MAX_GENETIC_DIST;
+            pair_dist[i*4+j] = pair_dist[j*4+i] = dist;
+        }
+    }
+}
+
+void QuartetEngine::initBranchLengths() {
+    // least-squares branch lengths of topology {a,b}|{c,d} from pairwise distances
+    int a = leaf_order[0]*4, b = leaf_order[1]*4, c = leaf_order[2]*4, d = leaf_order[3]*4;
+    double d_ab = pair_dist[a+leaf_order[1]], d_cd = pair_dist[c+leaf_order[3]];
+    double d_ac = pair_dist[a+leaf_order[2]], d_ad = pair_dist[a+leaf_order[3]];
+    double d_bc = pair_dist[b+leaf_order[2]], d_bd = pair_dist[b+leaf_order[3]];
+    brlen[0] = 0.5*d_ab + 0.25*(d_ac + d_ad - d_bc - d_bd);
+    brlen[1] = 0.5*d_ab + 0.25*(d_bc + d_bd - d_ac - d_ad);
+    brlen[2] = 0.5*d_cd + 0.25*(d_ac + d_bc - d_ad - d_bd);
+    brlen[3] = 0.5*d_cd + 0.25*(d_ad + d_bd - d_ac - d_bc);
+    brlen[4] = 0.25*(d_ac + d_ad + d_bc + d_bd) - 0.5*(d_ab + d_cd);
+    for (int i = 0; i < 5; i++)
+        brlen[i] = min(max(brlen[i], min_brlen), max_brlen);
+}
+
+void QuartetEngine::computeTransMatrix(double len, double *trans_mat, bool transposed) {
+    double expval[nstates];
+    for (int c = 0; c < ncat; c++) {
+        for (int k = 0; k < nstates; k++)
+            expval[k] = exp(eval[k]*cat_rate[c]*len);
+        double *mat = trans_mat + c*nstates*nstates;
+        for (int x = 0; x < nstates; x++)
+            for (int y = 0; y < nstates; y++) {
+                double p = 0.0;
+                for (int k = 0; k < nstates; k++)
+                    p += evec[x*nstates+k] * expval[k] * inv_evec[k*nstates+y];
+                if (transposed)
+                    mat[y*nstates+x] = p;
+                else
+                    mat[x*nstates+y] = p;
+            }
+    }
+}
+
+void QuartetEngine::computeTipTransform(int branch) {
+    computeTransMatrix(brlen[branch], tip_mat);
+    double *out = tip_trans[branch];
+    for (int state = 0; state < ntipstates; state++) {
+        double *lh = &tip_lh[state*nstates];
+        for (int c = 0; c < ncat; c++, out += nstates) {
+            double *mat = tip_mat + c*nstates*nstates;
+            for (int x = 0; x < nstates; x++) {
+                double sum = 0.0;
+                for (int y = 0; y < nstates; y++)
+                    sum += mat[x*nstates+y] * lh[y];
+                out[x] = sum;
+            }
+        }
+    }
+}
+
+void QuartetEngine::computeTheta(int branch) {
+    switch (nstates) {
+    case 4: computeThetaStates<4>(branch); break;
+    case 20: computeThetaStates<20>(branch); break;
+    default: computeThetaStates<0>(branch); break;
+    }
+}
+
+template <const int NSTATES>
+void QuartetEngine::computeThetaStates(int branch) {
+    // NSTATES = 0: number of states only known at runtime
+    const int ns = (NSTATES > 0) ? NSTATES : nstates;
+    double lk[ns], rk[ns], tmp[ns];
+    size_t block = ncat*ns;
+    for (size_t ptn = 0; ptn < nquartptn; ptn++) {
+        StateType *states = &ptn_states[ptn*4];
+        StateType leaf_state[4];
+        for (int i = 0; i < 4; i++)
+            leaf_state[i] = states[leaf_order[i]];
+        double *this_theta = theta + ptn*block;
+        if (branch == 4) {
+            // internal branch separates {0,1} from {2,3}
+            for (int c = 0; c < ncat; c++, this_theta += ns) {
+                size_t offset = c*ns;
+                double *w0 = tip_trans[0] + leaf_state[0]*block + offset;
+                double *w1 = tip_trans[1] + leaf_state[1]*block + offset;
+                double *w2 = tip_trans[2] + leaf_state[2]*block + offset;
+                double *w3 = tip_trans[3] + leaf_state[3]*block + offset;
+                for (int k = 0; k < ns; k++)
+                    lk[k] = rk[k] = 0.0;
+                // loops are written over k innermost so that they vectorize
+                for (int x = 0; x < ns; x++) {
+                    double left = state_freq[x] * w0[x] * w1[x];
+                    double right = w2[x] * w3[x];
+                    for (int k = 0; k < ns; k++) {
+                        lk[k] += left * evec[x*ns+k];
+                        rk[k] += right * inv_evec_t[x*ns+k];
+                    }
+                }
+                for (int k = 0; k < ns; k++)
+                    this_theta[k] = lk[k] * rk[k] * cat_prop[c];
+            }
+        } else {
+            // terminal branch: the other side is the cherry node of its sibling
+            int sib = branch ^ 1;
+            int other = (branch < 2) ? 2 : 0;
+            double *tip_lk = tip_eigen + leaf_state[branch]*ns;
+            double *far = far_partial + ptn*block;
+            for (int c = 0; c < ncat; c++, this_theta += ns, far += ns) {
+                size_t offset = c*ns;
+                double *wsib = tip_trans[sib] + leaf_state[sib]*block + offset;
+                if (branch == 0 || branch == 2) {
+                    // P(t) of the internal branch times the partial of the other cherry;
+                    // still valid for the sibling branch, which is optimized next
+                    double *w2 = tip_trans[other] + leaf_state[other]*block + offset;
+                    double *w3 = tip_trans[other+1] + leaf_state[other+1]*block + offset;
+                    double *mat_t = internal_trans + c*ns*ns;
+                    for (int x = 0; x < ns; x++)
+                        tmp[x] = 0.0;
+                    for (int y = 0; y < ns; y++) {
+                        double child = w2[y] * w3[y];
+                        for (int x = 0; x < ns; x++)
+                            tmp[x] += mat_t[y*ns+x] * child;
+                    }
+                    for (int x = 0; x < ns; x++)
+                        far[x] = tmp[x];
+                }
+                for (int k = 0; k < ns; k++)
+                    rk[k] = 0.0;
+                for (int x = 0; x < ns; x++) {
+                    double right = wsib[x] * far[x];
+                    for (int k = 0; k < ns; k++)
+                        rk[k] += right * inv_evec_t[x*ns+k];
+                }
+                for (int k = 0; k < ns; k++)
+                    this_theta[k] = tip_lk[k] * rk[k] * cat_prop[c];
+            }
+        }
+    }
+}
+
+void QuartetEngine::computeFuncDerv(double value, double &df, double &ddf) {
+    for (int c = 0; c < ncat; c++) {
+        for (int k = 0; k < nstates; k++) {
+            double lambda = eval[k]*cat_rate[c];
+            double e = exp(lambda*value);
+            val0[c*nstates+k] = e;
+            val1[c*nstates+k] = lambda*e;
+            val2[c*nstates+k] = lambda*lambda*e;
+        }
+    }
+    switch (nstates) {
+    case 4: computeFuncDervStates<4>(df, ddf); break;
+    case 20: computeFuncDervStates<20>(df, ddf); break;
+    default: computeFuncDervStates<0>(df, ddf); break;
+    }
+}
+
+template <const int NSTATES>
+void QuartetEngine::computeFuncDervStates(double &df, double &ddf) {
+    const int ns = (NSTATES > 0) ? NSTATES : nstates;
+    size_t block = ncat*ns;
+    double d1 = 0.0, d2 = 0.0;
+    double *this_theta = theta;
+    for (size_t ptn = 0; ptn < nquartptn; ptn++, this_theta += block) {
+        // one partial sum per state to break the dependency chain
+        double lh[ns], lh1[ns], lh2[ns];
+        for (int k = 0; k < ns; k++) {
+            lh[k] = this_theta[k] * val0[k];
+            lh1[k] = this_theta[k] * val1[k];
+            lh2[k] = this_theta[k] * val2[k];
+        }
+        for (size_t i = ns; i < block; i += ns)
+            for (int k = 0; k < ns; k++) {
+                lh[k] += this_theta[i+k] * val0[i+k];
+                lh1[k] += this_theta[i+k] * val1[i+k];
+                lh2[k] += this_theta[i+k] * val2[i+k];
+            }
+        double lh_ptn = ptn_invar[ptn], lh1_ptn = 0.0, lh2_ptn = 0.0;
+        for (int k = 0; k < ns; k++) {
+            lh_ptn += lh[k];
+            lh1_ptn += lh1[k];
+            lh2_ptn += lh2[k];
+        }
+        double inv_lh = (lh_ptn > 0.0) ? 1.0/lh_ptn : 1.0/DBL_MIN;
+        lh1_ptn *= inv_lh;
+        d1 += ptn_freq[ptn] * lh1_ptn;
+        d2 += ptn_freq[ptn] * (lh2_ptn*inv_lh - lh1_ptn*lh1_ptn);
+    }
+    df = -d1;
+    ddf = -d2;
+}
+
+double QuartetEngine::computeLikelihood(double value) {
+    size_t block = ncat*nstates;
+    for (int c = 0; c < ncat; c++)
+        for (int k = 0; k < nstates; k++)
+            val0[c*nstates+k] = exp(eval[k]*cat_rate[c]*value);
+    double logl = 0.0;
+    double *this_theta = theta;
+    for (size_t ptn = 0; ptn < nquartptn; ptn++, this_theta += block) {
+        double lh = ptn_invar[ptn];
+        for (size_t i = 0; i < block; i++)
+            lh += this_theta[i] * val0[i];
+        if (lh <= 0.0)
+            lh = DBL_MIN;
+        logl += ptn_freq[ptn] * log(lh);
+    }
+    return logl;
+}
+
+double QuartetEngine::optimizeTopology(int topo) {
+    static const int qc[] = {0, 1, 2, 3,  0, 2, 1, 3,  0, 3, 1, 2};
+    for (int i = 0; i < 4; i++)
+        leaf_order[i] = qc[topo*4+i];
+    initBranchLengths();
+    for (int i = 0; i < 4; i++)
+        computeTipTransform(i);
+    computeTransMatrix(brlen[4], internal_trans, true);
+
+    double logl = -DBL_MAX, d2l;
+    for (int round = 0; round < QUARTET_MAX_ROUNDS; round++) {
+        for (int branch = 0; branch < 5; branch++) {
+            computeTheta(branch);
+            brlen[branch] = minimizeNewton(min_brlen, brlen[branch], max_brlen, min_brlen, d2l);
+            if (branch < 4)
+                computeTipTransform(branch);
+            else
+                computeTransMatrix(brlen[4], internal_trans, true);
+        }
+        // theta of the internal branch is still valid
+        double new_logl = computeLikelihood(brlen[4]);
+        if (new_logl < logl + QUARTET_LOGL_EPS) {
+            logl = max(logl, new_logl);
+            break;
+        }
+        logl = new_logl;
+    }
+    return logl;
+}
+
+void QuartetEngine::computeQuartetLikelihoods(int *seq_id, double *logl) {
+    compressPatterns(seq_id);
+    for (int topo = 0; topo < 3; topo++)
+        logl[topo] = optimizeTopology(topo);
+}
@@ -0,0 +1,226 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef QUARTETENGINE_H
+#define QUARTETENGINE_H
+
+#ifndef PHYLOTREE_H
+#error "Please #include phylotree.h before including this header file"
+#endif
+
+#include "alignment/alignmentsummary.h"
+
+/**
+    Likelihood engine specialised for 4-taxon trees, used by likelihood mapping.
+    The 4 rows of a quartet are compressed into their own site patterns and the
+    three quartet topologies are evaluated with a closed-form 5-branch kernel
+    in the eigen space of the substitution model of the main tree.
+    One engine is created per thread and reused for all quartets of that thread;
+    the model and rate parameters are copied, so they are never modified.
+*/
+class QuartetEngine : public Optimization {
+public:
+
+    /**
+        constructor
+        @param tree main tree with fixed model and rate parameters
+        @param aln_summary summary of the alignment with a constructed sequence matrix of all sites,
+        shared read-only between engines of different threads
+    */
+    QuartetEngine(PhyloTree *tree, AlignmentSummary *aln_summary);
+
+    ~QuartetEngine();
+
+    /**
+        @return TRUE if the model of the tree can be handled by the quartet engine
+        (single reversible model of binary or DNA data without mixture, site-specific models
+        or ascertainment bias correction)
+    */
+    static bool isSupported(PhyloTree *tree);
+
+    /**
+        compute maximum log-likelihoods of the three quartet topologies
+        {0,1}|{2,3}, {0,2}|{1,3} and {0,3}|{1,2}
+        @param seq_id the 4 sequence IDs of the quartet
+        @param[out] logl the 3 log-likelihoods
+    */
+    void computeQuartetLikelihoods(int *seq_id, double *logl);
+
+    /**
+        compute negative first and second derivatives of the log-likelihood
+        with respect to the length of the current branch (used by minimizeNewton)
+    */
+    virtual void computeFuncDerv(double value, double &df, double &ddf);
+
+    /** computeFuncDerv for a fixed number of states (0 for any number of states) */
+    template <const int NSTATES>
+    void computeFuncDervStates(double &df, double &ddf);
+
+    /**
+        compute the log-likelihood for a given length of the current branch
+        @param value branch length
+        @return log-likelihood
+    */
+    double computeLikelihood(double value);
+
+protected:
+
+    /**
+        collect the site patterns of the 4 sequences of the quartet
+        @param seq_id the 4 sequence IDs
+    */
+    void compressPatterns(int *seq_id);
+
+    /**
+        initialize the 5 branch lengths of the current topology from pairwise distances
+    */
+    void initBranchLengths();
+
+    /**
+        optimize the 5 branch lengths of one quartet topology
+        @param topo topology index (0, 1 or 2)
+        @return maximum log-likelihood
+    */
+    double optimizeTopology(int topo);
+
+    /**
+        compute transition matrices P(t) of all rate categories
+        @param len branch length
+        @param[out] trans_mat ncat*nstates*nstates matrices
+        @param transposed TRUE to store the transposed matrices
+    */
+    void computeTransMatrix(double len, double *trans_mat, bool transposed = false);
+
+    /**
+        compute P(t) times tip likelihood vectors of all states for a terminal branch
+        @param branch terminal branch (0..3)
+    */
+    void computeTipTransform(int branch);
+
+    /**
+        compute the eigen-space coefficients of all patterns for one branch,
+        such that the pattern likelihood is sum_k theta_k exp(eval_k * rate * t).
+        Branches must be visited in the order 0..4, as far_partial of branch 0 (2)
+        is reused for branch 1 (3).
+        @param branch branch index (0..3 for terminal branches, 4 for internal branch)
+    */
+    void computeTheta(int branch);
+
+    /** computeTheta for a fixed number of states (0 for any number of states) */
+    template <const int NSTATES>
+    void computeThetaStates(int branch);
+
+    /** number of states */
+    int nstates;
+
+    /** number of tip states including ambiguous and unknown states */
+    int ntipstates;
+
+    /** number of rate categories */
+    int ncat;
+
+    /** main alignment */
+    Alignment *aln;
+
+    /** sequence matrix of the main alignment, one row of patterns per sequence */
+    AlignmentSummary *summary;
+
+    /** eigenvalues */
+    double *eval;
+
+    /** eigenvectors */
+    double *evec;
+
+    /** inverse eigenvectors */
+    double *inv_evec;
+
+    /** transposed inverse eigenvectors */
+    double *inv_evec_t;
+
+    /** state frequencies */
+    double *state_freq;
+
+    /** rates of categories */
+    double *cat_rate;
+
+    /** proportions of categories */
+    double *cat_prop;
+
+    /** proportion of invariant sites */
+    double p_invar;
+
+    /** tip likelihood vectors of all tip states, ntipstates*nstates */
+    double *tip_lh;
+
+    /** tip_lh weighted by state frequencies and transformed by eigenvectors, ntipstates*nstates */
+    double *tip_eigen;
+
+    /** P(t) times tip_lh for each terminal branch, ntipstates*ncat*nstates */
+    double *tip_trans[4];
+
+    /** transposed transition matrices of the internal branch, ncat*nstates*nstates */
+    double *internal_trans;
+
+    /** transition matrices of the terminal branch being updated, ncat*nstates*nstates */
+    double *tip_mat;
+
+    /** index of each combination of 4 tip states among quartet patterns, -1 if absent */
+    IntVector ptn_lookup;
+
+    /** states of the 4 sequences for each quartet pattern */
+    vector<StateType> ptn_states;
+
+    /** frequencies of quartet patterns */
+    DoubleVector ptn_freq;
+
+    /** likelihoods of quartet patterns under the invariant category */
+    DoubleVector ptn_invar;
+
+    /** number of quartet patterns */
+    size_t nquartptn;
+
+    /** allocated number of quartet patterns of theta */
+    size_t max_quartptn;
+
+    /** eigen-space coefficients of the current branch, nquartptn*ncat*nstates */
+    double *theta;
+
+    /** P(t) of the internal branch times the partial of the cherry opposite
+        to the current terminal branch, nquartptn*ncat*nstates */
+    double *far_partial;
+
+    /** exp(eval*rate*t) and its derivatives, ncat*nstates each */
+    double *val0, *val1, *val2;
+
+    /** position in the quartet of the 4 leaves of the current topology, {0,1}|{2,3} */
+    int leaf_order[4];
+
+    /** the 4 terminal branch lengths followed by the internal branch length */
+    double brlen[5];
+
+    /** JC distances between the 4 sequences of the quartet, 4x4 matrix */
+    double pair_dist[16];
+
+    /** branch length bounds */
+    double min_brlen, max_brlen;
+};
+
+#endif // QUARTETENGINE_H
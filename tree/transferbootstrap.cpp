@@ -0,0 +1,574 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "transferbootstrap.h"
+#include <climits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/** branches with a normalized transfer distance above this are not used for the transfer index of taxa */
+#define TBE_DIST_CUTOFF 0.3
+
+/** value of segment tree leaves that are not clusters (root and padding) */
+#define TBE_NO_CLUSTER (INT_MAX / 4)
+
+/** @return TRUE if a node is a taxon, i.e. a leaf other than the root of a rooted tree */
+static inline bool isTaxon(Node *node) {
+    return node->isLeaf() && node->name != ROOT_NAME;
+}
+
+/**
+    one bootstrap tree, rooted at its root leaf and decomposed into heavy paths.
+    A segment tree over the heavy path positions keeps a(v) = |C(v)| - 2|L & C(v)| for the
+    cluster C(v) below every node v and the current set L of reference taxa.
+    Only the global minimum and maximum are queried, so range additions are kept
+    in the covering nodes without being pushed down.
+*/
+class TransferBootstrapTree {
+public:
+
+    TransferBootstrapTree(int ntaxa) {
+        this->ntaxa = ntaxa;
+        taxon_node.resize(ntaxa);
+        taxon_order.resize(ntaxa);
+        mark.resize(ntaxa, 0);
+    }
+
+    /**
+        set up the heavy path decomposition and the segment tree of a tree
+        @param tree bootstrap tree
+        @param taxon_ids taxon ID of every taxon name
+        @return FALSE if the taxa of the tree do not match the reference taxa
+    */
+    bool load(MTree &tree, unordered_map<string, int> &taxon_ids) {
+        // a rooted tree has an extra root leaf that is not a taxon
+        if (tree.leafNum != ntaxa + (tree.rooted ? 1 : 0))
+            return false;
+        // pre-order to get parents and cluster sizes
+        vector<Node*> nodes;
+        vector<pair<Node*, Node*> > stack;
+        IntVector node_parent;
+        unordered_map<Node*, int> node_index;
+        stack.push_back(make_pair(tree.root, (Node*)NULL));
+        while (!stack.empty()) {
+            Node *node = stack.back().first;
+            Node *dad = stack.back().second;
+            stack.pop_back();
+            node_index[node] = nodes.size();
+            nodes.push_back(node);
+            node_parent.push_back(dad ? node_index[dad] : -1);
+            FOR_NEIGHBOR_IT(node, dad, it)
+                stack.push_back(make_pair((*it)->node, node));
+        }
+        nnode = nodes.size();
+        parent = node_parent;
+        num_taxa.assign(nnode, 0);
+        heavy.assign(nnode, -1);
+        IntVector node_taxon(nnode, -1);
+        std::fill(taxon_node.begin(), taxon_node.end(), -1);
+        for (int v = 0; v < nnode; v++) {
+            if (isTaxon(nodes[v])) {
+                auto it = taxon_ids.find(nodes[v]->name);
+                if (it == taxon_ids.end() || taxon_node[it->second] >= 0)
+                    return false;
+                taxon_node[it->second] = v;
+                node_taxon[v] = it->second;
+                num_taxa[v] = 1;
+            }
+        }
+        for (int v = nnode - 1; v > 0; v--)
+            num_taxa[parent[v]] += num_taxa[v];
+        for (int v = 1; v < nnode; v++) {
+            int p = parent[v];
+            if (heavy[p] < 0 || num_taxa[heavy[p]] < num_taxa[v])
+                heavy[p] = v;
+        }
+
+        // pre-order visiting heavy children first, so that heavy paths and clusters are contiguous
+        head.resize(nnode);
+        pos.resize(nnode);
+        first_pos.resize(nnode);
+        node_at.resize(nnode);
+        IntVector order_stack;
+        order_stack.push_back(0);
+        int npos = 0, ntaxon = 0;
+        while (!order_stack.empty()) {
+            int v = order_stack.back();
+            order_stack.pop_back();
+            pos[v] = npos;
+            node_at[npos++] = v;
+            head[v] = (v > 0 && heavy[parent[v]] == v) ? head[parent[v]] : v;
+            first_pos[v] = ntaxon;
+            if (node_taxon[v] >= 0)
+                taxon_order[ntaxon++] = node_taxon[v];
+            FOR_NEIGHBOR_IT(nodes[v], (v > 0 ? nodes[parent[v]] : NULL), it) {
+                int w = node_index[(*it)->node];
+                if (w != heavy[v])
+                    order_stack.push_back(w);
+            }
+            if (heavy[v] >= 0)
+                order_stack.push_back(heavy[v]);
+        }
+
+        // segment tree, the root is not a cluster
+        for (size = 1; size < nnode; size <<= 1);
+        min_val.assign(2 * size, TBE_NO_CLUSTER);
+        max_val.assign(2 * size, -TBE_NO_CLUSTER);
+        add_val.assign(size, 0);
+        min_pos.resize(2 * size);
+        max_pos.resize(2 * size);
+        for (int i = 0; i < size; i++) {
+            min_pos[size + i] = max_pos[size + i] = i;
+            if (i < nnode && node_at[i] > 0)
+                min_val[size + i] = max_val[size + i] = num_taxa[node_at[i]];
+        }
+        for (int i = size - 1; i > 0; i--)
+            pull(i);
+        return true;
+    }
+
+    /**
+        add a value to a(v) for all ancestors v of a taxon (the taxon included)
+        @param taxon taxon ID
+        @param value -2 to add the taxon to L, 2 to remove it
+    */
+    void updateTaxon(int taxon, int value) {
+        for (int v = taxon_node[taxon]; v >= 0; v = parent[head[v]])
+            addRange(pos[head[v]], pos[v], value);
+    }
+
+    /** @return minimum of a(v) */
+    inline int getMin() { return min_val[1]; }
+
+    /** @return maximum of a(v) */
+    inline int getMax() { return max_val[1]; }
+
+    /** @return node with the minimum of a(v) */
+    inline int getMinNode() { return node_at[min_pos[1]]; }
+
+    /** @return node with the maximum of a(v) */
+    inline int getMaxNode() { return node_at[max_pos[1]]; }
+
+    /** number of taxa */
+    int ntaxa;
+
+    /** number of nodes */
+    int nnode;
+
+    /** parent of every node, -1 for the root */
+    IntVector parent;
+
+    /** number of taxa below every node */
+    IntVector num_taxa;
+
+    /** node of every taxon ID */
+    IntVector taxon_node;
+
+    /** taxon IDs in heavy-first pre-order */
+    IntVector taxon_order;
+
+    /** taxa below node v are taxon_order[first_pos[v]...first_pos[v]+num_taxa[v]-1] */
+    IntVector first_pos;
+
+    /** per-taxon marks used to enumerate moved taxa, all 0 between uses */
+    vector<char> mark;
+
+protected:
+
+    inline void apply(int i, int value) {
+        min_val[i] += value;
+        max_val[i] += value;
+        if (i < size)
+            add_val[i] += value;
+    }
+
+    inline void pull(int i) {
+        int l = 2 * i, r = 2 * i + 1;
+        if (min_val[l] <= min_val[r]) {
+            min_val[i] = min_val[l] + add_val[i];
+            min_pos[i] = min_pos[l];
+        } else {
+            min_val[i] = min_val[r] + add_val[i];
+            min_pos[i] = min_pos[r];
+        }
+        if (max_val[l] >= max_val[r]) {
+            max_val[i] = max_val[l] + add_val[i];
+            max_pos[i] = max_pos[l];
+        } else {
+            max_val[i] = max_val[r] + add_val[i];
+            max_pos[i] = max_pos[r];
+        }
+    }
+
+    /** add a value to positions first...last */
+    void addRange(int first, int last, int value) {
+        int l = first + size, r = last + size + 1;
+        while (l < r) {
+            if (l & 1) apply(l++, value);
+            if (r & 1) apply(--r, value);
+            l >>= 1;
+            r >>= 1;
+        }
+        for (l = (first + size) >> 1; l > 0; l >>= 1)
+            pull(l);
+        for (r = (last + size) >> 1; r > 0; r >>= 1)
+            pull(r);
+    }
+
+    /** node at the top of the heavy path of every node */
+    IntVector head;
+
+    /** heavy child of every node, -1 for leaves */
+    IntVector heavy;
+
+    /** segment tree position of every node */
+    IntVector pos;
+
+    /** node at every segment tree position */
+    IntVector node_at;
+
+    /** number of segment tree leaves, a power of 2 */
+    int size;
+
+    /** minimum, maximum and pending addition of every segment tree node */
+    IntVector min_val, max_val, add_val;
+
+    /** position of the minimum and maximum of every segment tree node */
+    IntVector min_pos, max_pos;
+};
+
+TransferBootstrap::TransferBootstrap(MTree *ref_tree) {
+    tree = ref_tree;
+    ntaxa = tree->leafNum - (tree->rooted ? 1 : 0);
+    ntrees = 0;
+
+    // pre-order of the reference tree, taxa are numbered in this order
+    vector<pair<Node*, int> > stack;
+    stack.push_back(make_pair(tree->root, -1));
+    while (!stack.empty()) {
+        Node *node = stack.back().first;
+        int dad = stack.back().second;
+        stack.pop_back();
+        int id = nodes.size();
+        nodes.push_back(node);
+        parent.push_back(dad);
+        first_taxon.push_back(taxon_names.size());
+        if (isTaxon(node)) {
+            taxon_ids[node->name] = taxon_names.size();
+            taxon_names.push_back(node->name);
+        }
+        FOR_NEIGHBOR_IT(node, (dad >= 0 ? nodes[dad] : NULL), it)
+            stack.push_back(make_pair((*it)->node, id));
+    }
+    if (taxon_ids.size() != ntaxa)
+        outError("Reference tree for transfer bootstrap has duplicated taxon names");
+
+    int nnode = nodes.size();
+    num_taxa.assign(nnode, 0);
+    heavy.assign(nnode, -1);
+    child_begin.assign(nnode + 1, 0);
+    for (int v = 0; v < nnode; v++)
+        if (isTaxon(nodes[v]))
+            num_taxa[v] = 1;
+    for (int v = nnode - 1; v > 0; v--) {
+        num_taxa[parent[v]] += num_taxa[v];
+        child_begin[parent[v] + 1]++;
+    }
+    for (int v = 0; v < nnode; v++)
+        child_begin[v + 1] += child_begin[v];
+    children.resize(nnode > 0 ? nnode - 1 : 0);
+    IntVector next_child(child_begin.begin(), child_begin.end() - 1);
+    for (int v = 1; v < nnode; v++) {
+        int p = parent[v];
+        children[next_child[p]++] = v;
+        if (heavy[p] < 0 || num_taxa[heavy[p]] < num_taxa[v])
+            heavy[p] = v;
+    }
+    dist_sum.assign(nnode, 0);
+    move_counts.assign(ntaxa, 0.0);
+}
+
+void TransferBootstrap::addTree(TransferBootstrapTree &boot, vector<int64_t> &thread_dist_sum, double *thread_move_counts) {
+    int nnode = nodes.size();
+    int cur_taxa = 0;
+    // best bootstrap node for the branch above every reference node, negative if it is the complement
+    IntVector best_node(thread_move_counts ? nnode : 0);
+    IntVector branch_dist(nnode, 0);
+
+    // visit the reference nodes bottom-up; the taxa of the heavy child are kept,
+    // those of the other children are added again
+    struct Frame {
+        int node;
+        bool keep;
+        int stage;
+    };
+    vector<Frame> stack;
+    stack.push_back({0, true, 0});
+    while (!stack.empty()) {
+        Frame frame = stack.back();
+        stack.pop_back();
+        int u = frame.node;
+        if (frame.stage == 0) {
+            stack.push_back({u, frame.keep, 1});
+            for (int i = child_begin[u]; i < child_begin[u + 1]; i++)
+                if (children[i] != heavy[u])
+                    stack.push_back({children[i], false, 0});
+        } else if (frame.stage == 1) {
+            stack.push_back({u, frame.keep, 2});
+            if (heavy[u] >= 0)
+                stack.push_back({heavy[u], true, 0});
+        } else {
+            // add the taxa below the other children
+            for (int i = child_begin[u]; i < child_begin[u + 1]; i++) {
+                int c = children[i];
+                if (c == heavy[u])
+                    continue;
+                for (int x = first_taxon[c]; x < first_taxon[c] + num_taxa[c]; x++)
+                    boot.updateTaxon(x, -2);
+                cur_taxa += num_taxa[c];
+            }
+            if (isTaxon(nodes[u])) {
+                boot.updateTaxon(first_taxon[u], -2);
+                cur_taxa++;
+            }
+            int depth = min(num_taxa[u], ntaxa - num_taxa[u]);
+            if (u > 0 && depth > 1) {
+                // transfer distance min(|L xor C|, n - |L xor C|) over all clusters C
+                int dist_min = boot.getMin() + cur_taxa;
+                int dist_comp = ntaxa - (boot.getMax() + cur_taxa);
+                if (dist_min <= dist_comp) {
+                    branch_dist[u] = dist_min;
+                    if (thread_move_counts)
+                        best_node[u] = boot.getMinNode();
+                } else {
+                    branch_dist[u] = dist_comp;
+                    if (thread_move_counts)
+                        best_node[u] = -boot.getMaxNode() - 1;
+                }
+            }
+            if (!frame.keep) {
+                for (int x = first_taxon[u]; x < first_taxon[u] + num_taxa[u]; x++)
+                    boot.updateTaxon(x, 2);
+                cur_taxa -= num_taxa[u];
+            }
+        }
+    }
+    for (int u = 1; u < nnode; u++)
+        thread_dist_sum[u] += branch_dist[u];
+
+    if (!thread_move_counts)
+        return;
+
+    // taxa to move for every branch close to the bootstrap tree
+    IntVector moved(ntaxa, 0);
+    int num_close = 0;
+    int min_depth = (int)ceil(1.0 / TBE_DIST_CUTOFF + 1.0);
+    vector<char> &mark = boot.mark;
+    for (int u = 1; u < nnode; u++) {
+        int depth = min(num_taxa[u], ntaxa - num_taxa[u]);
+        if (depth <= 1 || depth < min_depth || branch_dist[u] > TBE_DIST_CUTOFF * (depth - 1))
+            continue;
+        num_close++;
+        // S: smaller side of the reference branch, B: side of the best bootstrap branch
+        // such that the taxa to move are S xor B
+        bool s_below = (num_taxa[u] == depth);
+        bool complement = (best_node[u] < 0);
+        int v = complement ? -best_node[u] - 1 : best_node[u];
+        bool b_below = (s_below != complement);
+        int s_first = first_taxon[u], s_last = first_taxon[u] + num_taxa[u];
+        int b_first = boot.first_pos[v], b_last = boot.first_pos[v] + boot.num_taxa[v];
+        // S and B are either a range of taxa or its complement
+        int s_ranges[] = {s_first, s_last, 0, 0};
+        int b_ranges[] = {b_first, b_last, 0, 0};
+        if (!s_below) {
+            s_ranges[0] = 0; s_ranges[1] = s_first;
+            s_ranges[2] = s_last; s_ranges[3] = ntaxa;
+        }
+        if (!b_below) {
+            b_ranges[0] = 0; b_ranges[1] = b_first;
+            b_ranges[2] = b_last; b_ranges[3] = ntaxa;
+        }
+        for (int r = 0; r < 4; r += 2)
+            for (int x = s_ranges[r]; x < s_ranges[r + 1]; x++)
+                mark[x] = 1;
+        for (int r = 0; r < 4; r += 2)
+            for (int k = b_ranges[r]; k < b_ranges[r + 1]; k++) {
+                int x = boot.taxon_order[k];
+                if (mark[x])
+                    mark[x] = 2;
+                else
+                    moved[x]++;
+            }
+        for (int r = 0; r < 4; r += 2)
+            for (int x = s_ranges[r]; x < s_ranges[r + 1]; x++) {
+                if (mark[x] == 1)
+                    moved[x]++;
+                mark[x] = 0;
+            }
+    }
+    if (num_close == 0)
+        return;
+    for (int x = 0; x < ntaxa; x++)
+        thread_move_counts[x] += (double)moved[x] / num_close;
+}
+
+int TransferBootstrap::addTrees(const char *boot_trees, bool count_moves) {
+    ifstream in;
+    try {
+        in.exceptions(ios::badbit);
+        in.open(boot_trees);
+    } catch (ios::failure) {
+        outError(ERR_READ_INPUT, boot_trees);
+    }
+    if (!in.is_open())
+        outError(ERR_READ_INPUT, boot_trees);
+    int num_skipped = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        TransferBootstrapTree boot(ntaxa);
+        vector<int64_t> thread_dist_sum(nodes.size(), 0);
+        DoubleVector thread_move_counts(count_moves ? ntaxa : 0, 0.0);
+        int thread_trees = 0, thread_skipped = 0;
+        string tree_str;
+        while (true) {
+            bool has_tree = false;
+#ifdef _OPENMP
+#pragma omp critical(tbe_read_tree)
+#endif
+            {
+                // trees are streamed one at a time from the file
+                while (!has_tree && getline(in, tree_str, ';')) {
+                    size_t start = tree_str.find_first_not_of(" \t\r\n");
+                    if (start == string::npos)
+                        continue;
+                    tree_str = tree_str.substr(start) + ";";
+                    has_tree = true;
+                }
+            }
+            if (!has_tree)
+                break;
+            MTree boot_tree;
+            bool rooted = false;
+            stringstream ss(tree_str);
+            boot_tree.readTree(ss, rooted);
+            if (!boot.load(boot_tree, taxon_ids)) {
+                thread_skipped++;
+                continue;
+            }
+            addTree(boot, thread_dist_sum, count_moves ? &thread_move_counts[0] : NULL);
+            thread_trees++;
+        }
+#ifdef _OPENMP
+#pragma omp critical(tbe_sum)
+#endif
+        {
+            for (size_t i = 0; i < nodes.size(); i++)
+                dist_sum[i] += thread_dist_sum[i];
+            if (count_moves)
+                for (int x = 0; x < ntaxa; x++)
+                    move_counts[x] += thread_move_counts[x];
+            ntrees += thread_trees;
+            num_skipped += thread_skipped;
+        }
+    }
+    in.close();
+    if (num_skipped > 0)
+        outWarning(convertIntToString(num_skipped) + " trees in " + boot_trees +
+                   " do not have the same taxa as the reference tree and were ignored");
+    return ntrees;
+}
+
+void TransferBootstrap::assignSupports(bool raw) {
+    for (size_t u = 1; u < nodes.size(); u++) {
+        int depth = min(num_taxa[u], ntaxa - num_taxa[u]);
+        if (nodes[u]->isLeaf() || depth <= 1 || ntrees == 0)
+            continue;
+        double avg_dist = (double)dist_sum[u] / ntrees;
+        stringstream ss;
+        ss.precision(6);
+        ss << fixed;
+        if (raw)
+            ss << nodes[u]->findNeighbor(nodes[parent[u]])->id << "|" << avg_dist << "|" << depth;
+        else
+            ss << 1.0 - avg_dist / (depth - 1.0);
+        nodes[u]->name = ss.str();
+    }
+}
+
+void TransferBootstrap::writeStat(const char *stat_out) {
+    try {
+        ofstream out;
+        out.exceptions(ios::failbit | ios::badbit);
+        out.open(stat_out);
+        out.precision(6);
+        out << fixed;
+        if (ntrees > 0) {
+            // branches ordered by ID, taxa in the order of the tree file
+            vector<pair<int, int> > branches, taxa;
+            for (size_t u = 1; u < nodes.size(); u++) {
+                int depth = min(num_taxa[u], ntaxa - num_taxa[u]);
+                if (!nodes[u]->isLeaf() && depth > 1)
+                    branches.push_back(make_pair(nodes[u]->findNeighbor(nodes[parent[u]])->id, u));
+                if (isTaxon(nodes[u]))
+                    taxa.push_back(make_pair(nodes[u]->id, first_taxon[u]));
+            }
+            if (isTaxon(nodes[0]))
+                taxa.push_back(make_pair(nodes[0]->id, first_taxon[0]));
+            sort(branches.begin(), branches.end());
+            sort(taxa.begin(), taxa.end());
+            out << "EdgeId\tDepth\tMeanMinDist" << endl;
+            for (auto branch : branches) {
+                int u = branch.second;
+                out << branch.first << "\t" << min(num_taxa[u], ntaxa - num_taxa[u]) << "\t"
+                    << (double)dist_sum[u] / ntrees << endl;
+            }
+            out << "Taxon\ttIndex" << endl;
+            for (auto taxon : taxa)
+                out << taxon_names[taxon.second] << "\t" << move_counts[taxon.second] * 100.0 / ntrees << endl;
+        }
+        out.close();
+    } catch (ios::failure) {
+        outError(ERR_WRITE_OUTPUT, stat_out);
+    }
+}
+
+void computeTransferBootstrap(const char *input_tree, const char *boot_trees,
+                              const char *out_tree, const char *out_raw_tree, const char *stat_out) {
+    MTree tree;
+    bool rooted = false;
+    tree.readTree(input_tree, rooted);
+    TransferBootstrap tbe(&tree);
+    int ntrees = tbe.addTrees(boot_trees, stat_out != NULL);
+    cout << "Number of bootstrap trees: " << ntrees << endl;
+    if (stat_out)
+        tbe.writeStat(stat_out);
+    if (out_raw_tree) {
+        tbe.assignSupports(true);
+        tree.printTree(out_raw_tree, WT_BR_LEN | WT_NEWLINE);
+    }
+    tbe.assignSupports(false);
+    tree.printTree(out_tree, WT_BR_LEN | WT_NEWLINE);
+}
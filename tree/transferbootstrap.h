@@ -0,0 +1,127 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef TRANSFERBOOTSTRAP_H
+#define TRANSFERBOOTSTRAP_H
+
+#include "mtree.h"
+#include <unordered_map>
+
+class TransferBootstrapTree;
+
+/**
+    Transfer bootstrap expectation (TBE, Lemoine et al. 2018) of the branches of a reference tree.
+    The transfer distance of every reference branch to a bootstrap tree is computed in
+    O(n log^3 n) instead of filling the O(n^2) matrices of booster: the bootstrap tree is
+    rooted and decomposed into heavy paths, a segment tree over these paths keeps
+    |C| - 2|L & C| for all clusters C of the bootstrap tree, and the clusters L of the
+    reference tree are enumerated by keeping the cluster of the largest child,
+    so that every taxon is added O(log n) times.
+*/
+class TransferBootstrap {
+public:
+
+    /**
+        constructor
+        @param ref_tree reference tree, its internal nodes are later labelled with the supports
+    */
+    TransferBootstrap(MTree *ref_tree);
+
+    /**
+        compute the transfer distances of the reference branches to all trees of a file.
+        The trees are read one at a time and distributed over the OpenMP threads.
+        @param boot_trees file of bootstrap trees
+        @param count_moves TRUE to also compute the transfer index of every taxon
+        @return number of trees
+    */
+    int addTrees(const char *boot_trees, bool count_moves);
+
+    /**
+        label the internal nodes of the reference tree with the TBE supports
+        @param raw TRUE to label with "branch ID|average transfer distance|depth" instead
+    */
+    void assignSupports(bool raw = false);
+
+    /**
+        write the average transfer distance of all branches and the transfer index of all taxa
+        @param stat_out output file name
+    */
+    void writeStat(const char *stat_out);
+
+protected:
+
+    /**
+        compute the transfer distances of the reference branches to one bootstrap tree
+        @param boot bootstrap tree
+        @param[in,out] thread_dist_sum sum of transfer distances of every reference node
+        @param[in,out] thread_move_counts transfer index of every taxon, NULL to skip
+    */
+    void addTree(TransferBootstrapTree &boot, vector<int64_t> &thread_dist_sum, double *thread_move_counts);
+
+    /** reference tree */
+    MTree *tree;
+
+    /** number of taxa */
+    int ntaxa;
+
+    /** number of trees added */
+    int ntrees;
+
+    /** taxon ID of every taxon name, taxa are numbered in pre-order of the reference tree */
+    unordered_map<string, int> taxon_ids;
+
+    /** taxon names by taxon ID */
+    StrVector taxon_names;
+
+    /** nodes of the reference tree in pre-order, rooted at the root leaf */
+    vector<Node*> nodes;
+
+    /** parent of every reference node, -1 for the root */
+    IntVector parent;
+
+    /** children of reference node i are children[child_begin[i]...child_begin[i+1]-1] */
+    IntVector child_begin, children;
+
+    /** child with the most taxa below every reference node, -1 for leaves */
+    IntVector heavy;
+
+    /** taxa below reference node i are first_taxon[i]...first_taxon[i]+num_taxa[i]-1 */
+    IntVector first_taxon, num_taxa;
+
+    /** sum of transfer distances of the branch above every reference node */
+    vector<int64_t> dist_sum;
+
+    /** transfer index of every taxon, summed over trees */
+    DoubleVector move_counts;
+};
+
+/**
+    compute TBE supports of a tree from a set of bootstrap trees
+    @param input_tree reference tree file
+    @param boot_trees bootstrap tree file
+    @param out_tree output tree file with TBE supports
+    @param out_raw_tree output tree file with raw transfer distances, NULL to skip
+    @param stat_out output file for branch and taxon statistics, NULL to skip
+*/
+void computeTransferBootstrap(const char *input_tree, const char *boot_trees,
+                              const char *out_tree, const char *out_raw_tree, const char *stat_out);
+
+#endif // TRANSFERBOOTSTRAP_H
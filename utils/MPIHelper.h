@@ -37,6 +37,8 @@
 #define BOOT_TAG 3 // Message to please send bootstrap trees
 #define BOOT_TREE_TAG 4 // bootstrap tree tag
 #define LOGL_CUTOFF_TAG 5 // send logl_cutoff for ultrafast bootstrap
+#define MF_JOB_TAG 6 // ModelFinder job for a worker
+#define MF_RESULT_TAG 7 // ModelFinder result of a worker
 
 using namespace std;
 
@@ -10,9 +10,142 @@
 #include "timeutil.h"
 #include "gzstream.h"
 #include <cstdio>
+#include <functional>
+#include <zlib.h>
 
 const char* CKP_HEADER =     "--- # IQ-TREE Checkpoint ver >= 1.6";
 const char* CKP_HEADER_OLD = "--- # IQ-TREE Checkpoint";
+const char* CKP_HEADER_BINARY = "--- # IQ-TREE Binary Checkpoint";
+
+/*
+    A binary checkpoint file starts with the line CKP_HEADER_BINARY followed by
+    the header line. Then follows a log of records, each starting with one of the bytes
+    below. Keys are prefixed by their 4-byte length and values by their 8-byte length,
+    both little endian. A dump appends the changed keys followed by CKP_RECORD_COMMIT,
+    so that records of an interrupted dump are ignored when loading.
+*/
+const char CKP_RECORD_PUT = 'P';
+const char CKP_RECORD_ERASE = 'E';
+const char CKP_RECORD_COMMIT = 'C';
+
+/*-------------------------------------------------------------
+ * CheckpointLog
+ *-------------------------------------------------------------*/
+
+CheckpointLog::CheckpointLog() {
+    log_bytes = 0;
+    valid = false;
+    done = true;
+}
+
+CheckpointLog::~CheckpointLog() {
+    wait();
+}
+
+string CheckpointLog::wait() {
+    if (writer.joinable())
+        writer.join();
+    string ret = error;
+    error = "";
+    return ret;
+}
+
+/** append an integer in little endian */
+static void putInteger(string &buf, uint64_t value, int nbytes) {
+    for (int i = 0; i < nbytes; i++, value >>= 8)
+        buf.push_back((char)(value & 0xff));
+}
+
+/** read an integer in little endian, @return false if the stream ended */
+static bool getInteger(istream &in, uint64_t &value, int nbytes) {
+    unsigned char buf[8];
+    if (!in.read((char*)buf, nbytes))
+        return false;
+    value = 0;
+    for (int i = nbytes-1; i >= 0; i--)
+        value = (value << 8) | buf[i];
+    return true;
+}
+
+/** write a buffer to a gz file, @return false on error */
+static bool gzWriteAll(gzFile file, const char *buf, size_t len) {
+    const size_t chunk = 1 << 30;
+    for (size_t pos = 0; pos < len; pos += chunk) {
+        unsigned int n = (unsigned int)min(chunk, len - pos);
+        if (gzwrite(file, buf + pos, n) != (int)n)
+            return false;
+    }
+    return true;
+}
+
+/**
+    write records to a binary checkpoint file
+    @return error message, empty if successful
+*/
+static string writeCheckpointRecords(string filename, string header, bool compression, bool compact,
+                                     vector<CheckpointRecord> &records)
+{
+    string filename_out = (compact) ? filename + ".tmp" : filename;
+    const char *mode;
+    if (compact)
+        mode = (compression) ? "wb1" : "wbT";
+    else
+        mode = (compression) ? "ab1" : "abT";
+    gzFile file = gzopen(filename_out.c_str(), mode);
+    if (!file)
+        return filename_out;
+    bool ok = true;
+    string buf;
+    if (compact)
+        buf = (string)CKP_HEADER_BINARY + "\n" + header + "\n";
+    for (auto rec = records.begin(); ok && rec != records.end(); rec++) {
+        buf.push_back(rec->op);
+        putInteger(buf, rec->key.length(), 4);
+        buf += rec->key;
+        if (rec->op == CKP_RECORD_PUT) {
+            putInteger(buf, rec->value.length(), 8);
+            // write large values directly without copying them
+            if (rec->value.length() > 65536) {
+                ok = gzWriteAll(file, buf.c_str(), buf.length()) &&
+                     gzWriteAll(file, rec->value.c_str(), rec->value.length());
+                buf.clear();
+            } else
+                buf += rec->value;
+        }
+        if (buf.length() > 65536) {
+            ok = gzWriteAll(file, buf.c_str(), buf.length());
+            buf.clear();
+        }
+    }
+    buf.push_back(CKP_RECORD_COMMIT);
+    ok = ok && gzWriteAll(file, buf.c_str(), buf.length());
+    if (gzclose(file) != Z_OK)
+        ok = false;
+    if (!ok)
+        return filename_out;
+    if (compact) {
+        if (fileExists(filename) && std::remove(filename.c_str()) != 0)
+            return filename;
+        if (std::rename(filename_out.c_str(), filename.c_str()) != 0)
+            return filename_out;
+    }
+    return "";
+}
+
+void CheckpointLog::write(string filename, string header, bool compression, bool compact,
+                          vector<CheckpointRecord> &records)
+{
+    ASSERT(!writer.joinable());
+    done = false;
+    writer = thread([this, filename, header, compression, compact](vector<CheckpointRecord> records) {
+        error = writeCheckpointRecords(filename, header, compression, compact, records);
+        done = true;
+    }, std::move(records));
+}
+
+/*-------------------------------------------------------------
+ * Checkpoint
+ *-------------------------------------------------------------*/
 
 Checkpoint::Checkpoint() {
 	filename = "";
@@ -22,6 +155,7 @@ Checkpoint::Checkpoint() {
     struct_name = "";
     compression = true;
     header = CKP_HEADER;
+    binary = false;
 }
 
 
@@ -90,10 +224,16 @@ bool Checkpoint::load() {
         }
         if (line == CKP_HEADER_OLD)
             throw "Incompatible checkpoint file from version 1.5.X or older.\nEither overwrite it with -redo option or run older version";
+        bool binary_file = (line == CKP_HEADER_BINARY);
+        if (binary_file && !safeGetline(in, line))
+            throw ("Invalid checkpoint file " + filename);
         if (line != header)
         	throw ("Invalid checkpoint file " + filename);
         // call load from the stream
-        load(in);
+        if (binary_file)
+            loadBinary(in);
+        else
+            load(in);
         in.clear();
         // set the failbit again
         in.exceptions(ios::failbit | ios::badbit);
@@ -109,6 +249,55 @@ bool Checkpoint::load() {
     return false;
 }
 
+void Checkpoint::loadBinary(istream &in) {
+    vector<CheckpointRecord> batch;
+    CheckpointRecord rec;
+    uint64_t len;
+    size_t bytes = 0, batch_bytes = 0;
+    while (in.get(rec.op)) {
+        batch_bytes++;
+        if (rec.op == CKP_RECORD_COMMIT) {
+            // apply records of a complete dump
+            for (auto it = batch.begin(); it != batch.end(); it++)
+                if (it->op == CKP_RECORD_PUT)
+                    (*this)[it->key].swap(it->value);
+                else
+                    erase(it->key);
+            batch.clear();
+            bytes += batch_bytes;
+            batch_bytes = 0;
+            continue;
+        }
+        if ((rec.op != CKP_RECORD_PUT && rec.op != CKP_RECORD_ERASE) || !getInteger(in, len, 4))
+            break;
+        rec.key.resize(len);
+        if (len > 0 && !in.read(&rec.key[0], len))
+            break;
+        batch_bytes += 4 + len;
+        rec.value.clear();
+        if (rec.op == CKP_RECORD_PUT) {
+            if (!getInteger(in, len, 8))
+                break;
+            rec.value.resize(len);
+            if (len > 0 && !in.read(&rec.value[0], len))
+                break;
+            batch_bytes += 8 + len;
+        }
+        batch.push_back(rec);
+    }
+    if (batch_bytes > 0)
+        outWarning("Ignore incomplete records at the end of checkpoint file " + filename);
+
+    // the file can be appended to from the current state
+    ckp_log.dumped_keys.clear();
+    ckp_log.dumped_keys.reserve(size());
+    std::hash<string> hash_fn;
+    for (auto it = begin(); it != end(); it++)
+        ckp_log.dumped_keys.push_back(make_pair(it->first, make_pair(it->second.length(), hash_fn(it->second))));
+    ckp_log.log_bytes = bytes;
+    ckp_log.valid = (batch_bytes == 0);
+}
+
 void Checkpoint::setCompression(bool compression) {
     this->compression = compression;
 }
@@ -121,6 +310,10 @@ void Checkpoint::setHeader(string header) {
     this->header = "--- # " + header;
 }
 
+void Checkpoint::setBinary(bool binary) {
+    this->binary = binary;
+}
+
 void Checkpoint::setDumpInterval(double interval) {
     dump_interval = interval;
 }
@@ -150,37 +343,45 @@ void Checkpoint::dump(bool force) {
     if (!force && getRealTime() < prev_dump_time + dump_interval) {
         return;
     }
+    if (binary && !force && ckp_log.busy()) {
+        // the previous dump is still being written, changes go into the next one
+        return;
+    }
     prev_dump_time = getRealTime();
     string filename_tmp = filename + ".tmp";
-    if (fileExists(filename_tmp)) {
-        outWarning("IQ-TREE was killed while writing temporary checkpoint file " + filename_tmp);
-        outWarning("You should increase checkpoint interval from the default 60 seconds");
-        outWarning("via -cptime option to avoid too frequent checkpoint for large datasets");
-    }
-    try {
-        ostream *out;
-        if (compression) 
-            out = new ogzstream(filename_tmp.c_str());
-        else
-            out = new ofstream(filename_tmp.c_str());
-        out->exceptions(ios::failbit | ios::badbit);
-        *out << header << endl;
-        // call dump stream
-        dump(*out);
-        if (compression)
-            ((ogzstream*)out)->close();
-        else
-            ((ofstream*)out)->close();
-        delete out;
+    if (binary) {
+        dumpBinary(force);
+    } else {
+        if (fileExists(filename_tmp)) {
+            outWarning("IQ-TREE was killed while writing temporary checkpoint file " + filename_tmp);
+            outWarning("You should increase checkpoint interval from the default 60 seconds");
+            outWarning("via -cptime option to avoid too frequent checkpoint for large datasets");
+        }
+        try {
+            ostream *out;
+            if (compression) 
+                out = new ogzstream(filename_tmp.c_str());
+            else
+                out = new ofstream(filename_tmp.c_str());
+            out->exceptions(ios::failbit | ios::badbit);
+            *out << header << endl;
+            // call dump stream
+            dump(*out);
+            if (compression)
+                ((ogzstream*)out)->close();
+            else
+                ((ofstream*)out)->close();
+            delete out;
 //        cout << "Checkpoint dumped" << endl;
-        if (fileExists(filename)) {
-            if (std::remove(filename.c_str()) != 0)
-                outError("Cannot remove file ", filename);
+            if (fileExists(filename)) {
+                if (std::remove(filename.c_str()) != 0)
+                    outError("Cannot remove file ", filename);
+            }
+            if (std::rename(filename_tmp.c_str(), filename.c_str()) != 0)
+                outError("Cannot rename file ", filename_tmp);
+        } catch (ios::failure &) {
+            outError(ERR_WRITE_OUTPUT, filename.c_str());
         }
-        if (std::rename(filename_tmp.c_str(), filename.c_str()) != 0)
-            outError("Cannot rename file ", filename_tmp);
-    } catch (ios::failure &) {
-        outError(ERR_WRITE_OUTPUT, filename.c_str());
     }
     if (Params::getInstance().print_all_checkpoints) {
         // Feature request by Nick Goldman
@@ -215,6 +416,67 @@ void Checkpoint::dump(bool force) {
     }
 }
 
+void Checkpoint::dumpBinary(bool force) {
+    string error = ckp_log.wait();
+    if (!error.empty())
+        outError(ERR_WRITE_OUTPUT, error);
+
+    // compare the current keys and values with those already in the file
+    vector<pair<string, pair<size_t, size_t> > > keys;
+    keys.reserve(size());
+    vector<CheckpointRecord> records;
+    std::hash<string> hash_fn;
+    size_t live_bytes = 0, record_bytes = 0;
+    auto old_key = ckp_log.dumped_keys.begin();
+    for (auto it = begin(); it != end(); it++) {
+        keys.push_back(make_pair(it->first, make_pair(it->second.length(), hash_fn(it->second))));
+        live_bytes += it->first.length() + it->second.length() + 13;
+        for (; old_key != ckp_log.dumped_keys.end() && old_key->first < it->first; old_key++) {
+            records.push_back({CKP_RECORD_ERASE, old_key->first, ""});
+            record_bytes += old_key->first.length() + 5;
+        }
+        if (old_key != ckp_log.dumped_keys.end() && old_key->first == it->first) {
+            bool same = (old_key->second == keys.back().second);
+            old_key++;
+            if (same)
+                continue;
+        }
+        records.push_back({CKP_RECORD_PUT, it->first, it->second});
+        record_bytes += it->first.length() + it->second.length() + 13;
+    }
+    for (; old_key != ckp_log.dumped_keys.end(); old_key++) {
+        records.push_back({CKP_RECORD_ERASE, old_key->first, ""});
+        record_bytes += old_key->first.length() + 5;
+    }
+
+    // rewrite the whole file if it is not up to date or twice as large as needed
+    bool compact = !ckp_log.valid || ckp_log.log_bytes + record_bytes > 2*live_bytes + 65536;
+    if (compact) {
+        string filename_tmp = filename + ".tmp";
+        if (fileExists(filename_tmp)) {
+            outWarning("IQ-TREE was killed while writing temporary checkpoint file " + filename_tmp);
+        }
+        records.clear();
+        records.reserve(size());
+        for (auto it = begin(); it != end(); it++)
+            records.push_back({CKP_RECORD_PUT, it->first, it->second});
+        ckp_log.log_bytes = live_bytes;
+    } else if (records.empty()) {
+        return;
+    } else {
+        ckp_log.log_bytes += record_bytes;
+    }
+    ckp_log.dumped_keys.swap(keys);
+    ckp_log.valid = true;
+    ckp_log.write(filename, header, compression, compact, records);
+
+    if (force) {
+        error = ckp_log.wait();
+        if (!error.empty())
+            outError(ERR_WRITE_OUTPUT, error);
+    }
+}
+
 bool Checkpoint::hasKey(string key) {
 	return (find(struct_name + key) != end());
 }
@@ -15,6 +15,8 @@
 #include <cassert>
 #include <vector>
 #include <typeinfo>
+#include <thread>
+#include <atomic>
 #include "tools.h"
 
 using namespace std;
@@ -61,6 +63,72 @@ public:
 //    return is;
 //}
 
+/**
+    one record of a binary checkpoint file
+*/
+struct CheckpointRecord {
+    /** CKP_RECORD_PUT or CKP_RECORD_ERASE */
+    char op;
+    string key;
+    string value;
+};
+
+/**
+    state of the binary checkpoint file written so far and the background thread
+    appending to it. It is not copied together with the checkpoint, such that the copy
+    starts a new file with a full dump
+*/
+class CheckpointLog {
+public:
+    CheckpointLog();
+
+    CheckpointLog(const CheckpointLog &other) : CheckpointLog() {}
+
+    CheckpointLog &operator=(const CheckpointLog &other) { return *this; }
+
+    /** wait for the background writer */
+    ~CheckpointLog();
+
+    /** @return true if the background writer is still running */
+    bool busy() { return writer.joinable() && !done; }
+
+    /**
+        wait for the background writer to finish
+        @return error message of the writer, empty if successful
+    */
+    string wait();
+
+    /**
+        start writing records in a background thread
+        @param filename checkpoint file name
+        @param header header line
+        @param compression true to compress the file
+        @param compact true to rewrite the whole file, false to append to it
+        @param records records to write, moved into the thread
+    */
+    void write(string filename, string header, bool compression, bool compact, vector<CheckpointRecord> &records);
+
+    /** key, size and hash of values as stored in the file, sorted by key */
+    vector<pair<string, pair<size_t, size_t> > > dumped_keys;
+
+    /** number of bytes of records in the file */
+    size_t log_bytes;
+
+    /** true if the file contains exactly dumped_keys, false if it must be rewritten */
+    bool valid;
+
+private:
+
+    /** background writer */
+    thread writer;
+
+    /** true if writer has finished */
+    atomic<bool> done;
+
+    /** error message of writer */
+    string error;
+};
+
 /**
  * Checkpoint as map from key strings to value strings
  */
@@ -92,6 +160,12 @@ public:
     */
     void setHeader(string header);
 
+    /**
+        set the file format of the checkpoint file
+        @param binary true to write a binary log of changed keys, false to rewrite a text file on each dump
+    */
+    void setBinary(bool binary);
+
 	/**
 	 * load checkpoint information from an input stram
      * @param in input stream
@@ -116,6 +190,13 @@ public:
 	 */
 	void dump(bool force = false);
 
+    /**
+        write the changes since the last dump to the binary checkpoint file
+        in a background thread. The whole file is rewritten if it grew too large
+        @param force TRUE to wait until the file is written
+    */
+    void dumpBinary(bool force);
+
     /**
         set dumping interval in seconds
         @param interval dumping interval
@@ -459,6 +540,18 @@ protected:
     
     /** header line of checkpoint file */
     string header;
+
+    /** true to write binary checkpoint file, false (default) for text */
+    bool binary;
+
+    /** state of the binary checkpoint file */
+    CheckpointLog ckp_log;
+
+    /**
+        load records of a binary checkpoint file
+        @param in input stream positioned after the header lines
+    */
+    void loadBinary(istream &in);
     
 private:
 
@@ -0,0 +1,227 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "linereader.h"
+#include <ios>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+LineReader::LineReader(const char *filename) {
+    cur = end = NULL;
+    skip_lf = false;
+    pending = false;
+    compressed_length = 0;
+    mapped = NULL;
+    mapped_len = 0;
+    mapped_released = 0;
+    file = NULL;
+    cur_block = -1;
+    num_filled = 0;
+    finished = false;
+    failed = false;
+    stopped = false;
+
+#ifndef _WIN32
+    // memory-map plain regular files, gzip files start with 0x1f 0x8b
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        throw std::ios::failure("Cannot open " + std::string(filename));
+    struct stat st;
+    unsigned char magic[2] = {0, 0};
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        compressed_length = st.st_size;
+        if (compressed_length == 0) {
+            close(fd);
+            return;
+        }
+        if (read(fd, magic, 2) != 2 || magic[0] != 0x1f || magic[1] != 0x8b) {
+            void *addr = mmap(NULL, compressed_length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                mapped = (char*)addr;
+                mapped_len = compressed_length;
+                madvise(addr, mapped_len, MADV_SEQUENTIAL);
+                cur = mapped;
+                end = mapped + mapped_len;
+                close(fd);
+                return;
+            }
+        }
+    }
+    close(fd);
+#else
+    FILE *fp = fopen(filename, "rb");
+    if (fp) {
+        fseek(fp, 0, SEEK_END);
+        #if defined(WIN64)
+            compressed_length = _ftelli64(fp);
+        #else
+            compressed_length = ftell(fp);
+        #endif
+        fclose(fp);
+    }
+#endif
+
+    // zlib reads plain files transparently
+    file = gzopen(filename, "rb");
+    if (!file)
+        throw std::ios::failure("Cannot open " + std::string(filename));
+    gzbuffer(file, 1 << 17);
+    for (int i = 0; i < LINE_READER_BLOCKS; i++)
+        blocks[i].resize(LINE_READER_BLOCK_SIZE);
+    producer = std::thread(&LineReader::produceBlocks, this);
+}
+
+LineReader::~LineReader() {
+    if (producer.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(block_lock);
+            stopped = true;
+        }
+        block_freed.notify_one();
+        producer.join();
+    }
+    if (file)
+        gzclose(file);
+#ifndef _WIN32
+    if (mapped)
+        munmap(mapped, mapped_len);
+#endif
+}
+
+void LineReader::produceBlocks() {
+    for (int fill_block = 0; ; fill_block = (fill_block+1) % LINE_READER_BLOCKS) {
+        {
+            std::unique_lock<std::mutex> guard(block_lock);
+            block_freed.wait(guard, [this] { return num_filled < LINE_READER_BLOCKS || stopped; });
+            if (stopped)
+                return;
+        }
+        // the block is not held by the reader, fill it without the lock
+        int num = gzread(file, blocks[fill_block].data(), (unsigned)LINE_READER_BLOCK_SIZE);
+        {
+            std::lock_guard<std::mutex> guard(block_lock);
+            if (num < 0) {
+                failed = true;
+            } else if (num == 0) {
+                finished = true;
+            } else {
+                block_len[fill_block] = num;
+                block_pos[fill_block] = gzoffset(file);
+                num_filled++;
+            }
+        }
+        block_filled.notify_one();
+        if (num <= 0)
+            return;
+    }
+}
+
+bool LineReader::nextBlock() {
+    if (!file)
+        return false;
+    std::unique_lock<std::mutex> guard(block_lock);
+    if (cur_block >= 0) {
+        // release the block that was just parsed
+        num_filled--;
+        block_freed.notify_one();
+    }
+    block_filled.wait(guard, [this] { return num_filled > 0 || finished || failed; });
+    if (num_filled == 0) {
+        if (failed)
+            throw std::ios::failure("Error while decompressing input file");
+        cur_block = -1;
+        return false;
+    }
+    cur_block = (cur_block+1) % LINE_READER_BLOCKS;
+    cur = blocks[cur_block].data();
+    end = cur + block_len[cur_block];
+    return true;
+}
+
+size_t LineReader::getCompressedPosition() {
+    if (mapped)
+        return cur - mapped;
+    std::lock_guard<std::mutex> guard(block_lock);
+    return (cur_block >= 0) ? block_pos[cur_block] : compressed_length;
+}
+
+bool LineReader::getLine(const char *&line, size_t &len) {
+    if (!pending)
+        carry.clear();
+#ifndef _WIN32
+    if (mapped && (size_t)(cur - mapped) >= mapped_released + LINE_READER_BLOCK_SIZE) {
+        // drop the parsed pages, so that the mapping does not add the file size to the memory footprint
+        size_t release_end = (cur - mapped) & ~(LINE_READER_BLOCK_SIZE-1);
+        madvise(mapped + mapped_released, release_end - mapped_released, MADV_DONTNEED);
+        mapped_released = release_end;
+    }
+#endif
+    for (;;) {
+        if (cur == end) {
+            if (!nextBlock()) {
+                if (!pending)
+                    return false;
+                // last line without line break
+                pending = false;
+                line = carry.data();
+                len = carry.size();
+                return true;
+            }
+            continue;
+        }
+        if (skip_lf) {
+            skip_lf = false;
+            if (*cur == '\n') {
+                cur++;
+                continue;
+            }
+        }
+        const char *pos = cur;
+        while (pos != end && *pos != '\n' && *pos != '\r')
+            pos++;
+        if (pos == end) {
+            // the line continues in the next block
+            carry.append(cur, pos);
+            pending = true;
+            cur = end;
+            continue;
+        }
+        skip_lf = (*pos == '\r');
+        if (pending) {
+            carry.append(cur, pos);
+            pending = false;
+            line = carry.data();
+            len = carry.size();
+        } else {
+            line = cur;
+            len = pos - cur;
+        }
+        cur = pos + 1;
+        return true;
+    }
+}
@@ -0,0 +1,140 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef LINEREADER_H
+#define LINEREADER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <zlib.h>
+
+/** number of decompressed blocks in flight between the producer thread and the reader */
+const int LINE_READER_BLOCKS = 3;
+
+/** size of a decompressed block in bytes */
+const size_t LINE_READER_BLOCK_SIZE = 1 << 22;
+
+/**
+    Reader of text lines from a plain or gzip-compressed file without copying each line
+    into a std::string. Plain files are memory-mapped and lines point directly into
+    the mapping. Gzip files are decompressed block by block on a producer thread
+    while the reader parses the previous block. Lines may end with \n, \r or \r\n,
+    like safeGetline().
+*/
+class LineReader {
+public:
+
+    /**
+        constructor, open the file
+        @param filename file name
+        @throw ios::failure if the file cannot be opened
+    */
+    LineReader(const char *filename);
+
+    /** destructor, stop the producer thread and close the file */
+    ~LineReader();
+
+    /**
+        read the next line
+        @param[out] line first character of the line, valid until the next call
+        @param[out] len number of characters of the line without the line break
+        @return false at the end of file
+        @throw ios::failure on a read error
+    */
+    bool getLine(const char *&line, size_t &len);
+
+    /** @return size of the file on disk */
+    size_t getCompressedLength() { return compressed_length; }
+
+    /** @return number of bytes of the file on disk consumed so far */
+    size_t getCompressedPosition();
+
+protected:
+
+    /**
+        make the next decompressed block the current block
+        @return false if there are no more blocks
+    */
+    bool nextBlock();
+
+    /** producer thread: decompress the file into the free blocks */
+    void produceBlocks();
+
+    /** current position and end of the current block */
+    const char *cur, *end;
+
+    /** TRUE if the previous block ended with \r, so that a leading \n is skipped */
+    bool skip_lf;
+
+    /** TRUE if carry holds the unfinished beginning of the current line */
+    bool pending;
+
+    /** line spanning two blocks */
+    std::string carry;
+
+    /** size of the file on disk */
+    size_t compressed_length;
+
+    /** memory-mapped file content, NULL if the file is read through zlib */
+    char *mapped;
+
+    /** number of mapped bytes */
+    size_t mapped_len;
+
+    /** number of mapped bytes already parsed and given back to the system */
+    size_t mapped_released;
+
+    /** gzip file handle */
+    gzFile file;
+
+    /** ring of decompressed blocks */
+    std::vector<char> blocks[LINE_READER_BLOCKS];
+
+    /** number of valid bytes of every block */
+    size_t block_len[LINE_READER_BLOCKS];
+
+    /** compressed position after every block */
+    size_t block_pos[LINE_READER_BLOCKS];
+
+    /** block being read, -1 before the first block */
+    int cur_block;
+
+    /** number of decompressed blocks not yet consumed by the reader */
+    int num_filled;
+
+    /** TRUE if the producer reached the end of file */
+    bool finished;
+
+    /** TRUE if zlib reported an error */
+    bool failed;
+
+    /** TRUE if the reader is destroyed before the end of file */
+    bool stopped;
+
+    std::mutex block_lock;
+    std::condition_variable block_filled, block_freed;
+    std::thread producer;
+};
+
+#endif // LINEREADER_H
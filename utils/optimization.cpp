@@ -950,6 +950,11 @@ void Optimization::dfpmin(double p[], int n, double lower[], double upper[]
 	@param dfx the derivative at x
 	@return the function value at x
 */
+void Optimization::targetFunkBatch(int npoints, double *points[], double values[]) {
+	for (int i = 0; i < npoints; i++)
+		values[i] = targetFunk(points[i]);
+}
+
 double Optimization::derivativeFunk(double x[], double dfx[]) {
 	/*
 	if (!checkRange(x))
@@ -957,20 +962,28 @@ double Optimization::derivativeFunk(double x[], double dfx[]) {
 	*/
 	int ndim = getNDim();
 	double *h = new double[ndim+1];
-    double temp;
     int dim;
-	double fx = targetFunk(x);
+	// x itself followed by one forward probe per dimension, evaluated as one batch
+	double *probes = new double[(ndim+1)*(ndim+1)];
+	double **points = new double*[ndim+1];
+	double *values = new double[ndim+1];
+	points[0] = x;
 	for (dim = 1; dim <= ndim; dim++ ){
-		temp = x[dim];
+		points[dim] = probes + dim*(ndim+1);
+		memcpy(points[dim], x, sizeof(double)*(ndim+1));
+		double temp = x[dim];
 		h[dim] = ERROR_X * fabs(temp);
 		if (h[dim] == 0.0) h[dim] = ERROR_X;
-		x[dim] = temp + h[dim];
-		h[dim] = x[dim] - temp;
-		dfx[dim] = (targetFunk(x));
-		x[dim] = temp;
+		points[dim][dim] = temp + h[dim];
+		h[dim] = points[dim][dim] - temp;
 	}
+	targetFunkBatch(ndim+1, points, values);
+	double fx = values[0];
 	for (dim = 1; dim <= ndim; dim++ )
-        dfx[dim] = (dfx[dim] - fx) / h[dim];
+        dfx[dim] = (values[dim] - fx) / h[dim];
+    delete [] values;
+    delete [] points;
+    delete [] probes;
     delete [] h;
 	return fx;
 }
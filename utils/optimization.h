@@ -136,6 +136,17 @@ public:
 	*/
 	virtual double targetFunk(double x[]) { return 0.0; }
 
+	/**
+		evaluate the target function at several independent points.
+		The default calls targetFunk for each point in turn. Subclasses that can compute
+		the function without changing their state may evaluate all points concurrently,
+		but must leave the same state as the sequential evaluation.
+		@param npoints number of points
+		@param points the input vectors, indexed from 1 like x of targetFunk
+		@param[out] values the function values at the points
+	*/
+	virtual void targetFunkBatch(int npoints, double *points[], double values[]);
+
 	/**
 		the approximated derivative function
 		@param x the input vector x
@@ -1111,6 +1111,7 @@ void parseArg(int argc, char *argv[], Params &params) {
 
     params.aln_file = NULL;
     params.phylip_sequential_format = false;
+    params.aln_cache = false;
     params.symtest = SYMTEST_NONE;
     params.symtest_only = false;
     params.symtest_remove = 0;
@@ -1186,7 +1187,7 @@ void parseArg(int argc, char *argv[], Params &params) {
     params.model_test_separate_rate = false;
     params.optimize_mixmodel_weight = false;
     params.optimize_rate_matrix = false;
-    params.store_trans_matrix = false;
+    params.store_trans_matrix = true;
     //params.freq_type = FREQ_EMPIRICAL;
     params.freq_type = FREQ_UNKNOWN;
     params.keep_zero_freq = true;
@@ -1210,6 +1211,7 @@ void parseArg(int argc, char *argv[], Params &params) {
     params.optimize_by_newton = true;
     params.optimize_alg_freerate = "2-BFGS,EM";
     params.optimize_alg_mixlen = "EM";
+    params.analytic_gradient = true;
     params.optimize_alg_gammai = "EM";
     params.optimize_alg_treeweight = "EM";
     params.optimize_from_given_params = false;
@@ -1261,6 +1263,8 @@ void parseArg(int argc, char *argv[], Params &params) {
     params.lk_safe_scaling = false;
     params.numseq_safe_scaling = 2000;
     params.kernel_nonrev = false;
+    params.lh_mixed_precision = false;
+    params.lh_mix_block = 4;
     params.print_site_lh = WSL_NONE;
     params.print_partition_lh = false;
     params.print_marginal_prob = false;
@@ -1413,6 +1417,7 @@ void parseArg(int argc, char *argv[], Params &params) {
     params.checkpoint_dump_interval = 60;
     params.force_unfinished = false;
     params.print_all_checkpoints = false;
+    params.binary_checkpoint = true;
     params.suppress_output_flags = 0;
     params.ufboot2corr = false;
     params.u2c_nni5 = false;
@@ -1637,6 +1642,10 @@ void parseArg(int argc, char *argv[], Params &params) {
 				params.optimize_alg_freerate = argv[cnt];
 				continue;
 			}
+            if (strcmp(argv[cnt], "--numeric-grad") == 0) {
+                params.analytic_gradient = false;
+                continue;
+            }
 			if (strcmp(argv[cnt], "-optlen") == 0) {
 				cnt++;
 				if (cnt >= argc)
@@ -2379,6 +2388,10 @@ void parseArg(int argc, char *argv[], Params &params) {
                 params.phylip_sequential_format = true;
                 continue;
             }
+            if (strcmp(argv[cnt], "--aln-cache") == 0) {
+                params.aln_cache = true;
+                continue;
+            }
             if (strcmp(argv[cnt], "--symtest") == 0) {
                 params.symtest = SYMTEST_MAXDIV;
                 continue;
@@ -3372,6 +3385,10 @@ void parseArg(int argc, char *argv[], Params &params) {
 				params.store_trans_matrix = true;
 				continue;
 			}
+			if (strcmp(argv[cnt], "--no-trans-cache") == 0) {
+				params.store_trans_matrix = false;
+				continue;
+			}
 			if (strcmp(argv[cnt], "-nni_lh") == 0) {
 				params.nni_lh = true;
 				continue;
@@ -3425,6 +3442,21 @@ void parseArg(int argc, char *argv[], Params &params) {
                 continue;
             }
 
+            if (strcmp(argv[cnt], "--mixed-precision") == 0) {
+                params.lh_mixed_precision = true;
+                continue;
+            }
+
+            if (strcmp(argv[cnt], "--mix-block") == 0) {
+                cnt++;
+                if (cnt >= argc)
+                    throw "Use --mix-block NUM";
+                params.lh_mix_block = convert_int(argv[cnt]);
+                if (params.lh_mix_block < 0)
+                    throw "--mix-block must be non-negative";
+                continue;
+            }
+
 			if (strcmp(argv[cnt], "-f") == 0) {
 				cnt++;
 				if (cnt >= argc)
@@ -3835,7 +3867,6 @@ void parseArg(int argc, char *argv[], Params &params) {
                 continue;
             }
 
-#ifdef USE_BOOSTER
             if (strcmp(argv[cnt], "--tbe") == 0) {
                 params.transfer_bootstrap = 1;
                 continue;
@@ -3845,7 +3876,6 @@ void parseArg(int argc, char *argv[], Params &params) {
                 params.transfer_bootstrap = 2;
                 continue;
             }
-#endif
 
             if (strcmp(argv[cnt], "-bc") == 0 || strcmp(argv[cnt], "--bcon") == 0) {
 				params.multi_tree = true;
@@ -5321,6 +5351,11 @@ void parseArg(int argc, char *argv[], Params &params) {
                 params.print_all_checkpoints = true;
                 continue;
             }
+
+            if (strcmp(argv[cnt], "--ckp-text") == 0) {
+                params.binary_checkpoint = false;
+                continue;
+            }
             
 			if (strcmp(argv[cnt], "--no-log") == 0) {
 				params.suppress_output_flags |= OUT_LOG;
@@ -5730,6 +5765,16 @@ void parseArg(int argc, char *argv[], Params &params) {
     
     if (params.lh_mem_save == LM_MEM_SAVE && params.partition_file)
         outError("-mem option does not work with partition models yet");
+
+    if (params.lh_mixed_precision && params.partition_file) {
+        outWarning("--mixed-precision does not work with partition models yet, using double precision");
+        params.lh_mixed_precision = false;
+    }
+
+    if (params.lh_mixed_precision && params.SSE < LK_AVX) {
+        outWarning("--mixed-precision requires AVX instructions, using double precision");
+        params.lh_mixed_precision = false;
+    }
     
     if (params.gbo_replicates && params.num_bootstrap_samples)
         outError("UFBoot (-bb) and standard bootstrap (-b) must not be specified together");
@@ -5978,11 +6023,14 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  -s FILE[,...,FILE]   PHYLIP/FASTA/NEXUS/CLUSTAL/MSF alignment file(s)" << endl
     << "  -s DIR               Directory of alignment files" << endl
     << "  --seqtype STRING     BIN, DNA, AA, NT2AA, CODON, MORPH (default: auto-detect)" << endl
+    << "  --aln-cache          Reuse compressed alignment from binary cache FILE.iqa" << endl
     << "  -t FILE|PARS|RAND    Starting tree (default: 99 parsimony and BIONJ)" << endl
     << "  -o TAX[,...,TAX]     Outgroup taxon (list) for writing .treefile" << endl
     << "  --prefix STRING      Prefix for all output files (default: aln/partition)" << endl
     << "  --seed NUM           Random seed number, normally used for debugging purpose" << endl
     << "  --safe               Safe likelihood kernel to avoid numerical underflow" << endl
+    << "  --mixed-precision    Single-precision partial likelihoods (AVX, DNA/AA only)" << endl
+    << "  --mix-block NUM      SIMD vectors per class block of large mixtures (default: 4, 0: off)" << endl
     << "  --mem NUM[G|M|%]     Maximal RAM usage in GB | MB | %" << endl
     << "  --runs NUM           Number of indepedent runs (default: 1)" << endl
     << "  -v, --verbose        Verbose mode, printing more messages to screen" << endl
@@ -5990,6 +6038,7 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --quiet              Quiet mode, suppress printing to screen (stdout)" << endl
     << "  -fconst f1,...,fN    Add constant patterns into alignment (N=no. states)" << endl
     << "  --epsilon NUM        Likelihood epsilon for parameter estimate (default 0.01)" << endl
+    << "  --numeric-grad       Use finite differences for model parameter gradients" << endl
 #ifdef _OPENMP
     << "  -T NUM|AUTO          No. cores/threads or AUTO-detect (default: 1)" << endl
     << "  --threads-max NUM    Max number of threads for -T AUTO (default: all cores)" << endl
@@ -5999,6 +6048,7 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --redo-tree          Restore ModelFinder and only redo tree search" << endl
     << "  --undo               Revoke finished run, used when changing some options" << endl
     << "  --cptime NUM         Minimum checkpoint interval (default: 60 sec and adapt)" << endl
+    << "  --ckp-text           Write text instead of binary checkpoint files" << endl
     << endl << "PARTITION MODEL:" << endl
     << "  -p FILE|DIR          NEXUS/RAxML partition file or directory with alignments" << endl
     << "                       Edge-linked proportional partition model" << endl
@@ -6051,9 +6101,7 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --jack-prop NUM      Subsampling proportion for jackknife (default: 0.5)" << endl
     << "  --bcon NUM           Replicates for bootstrap + consensus tree" << endl
     << "  --bonly NUM          Replicates for bootstrap only" << endl
-#ifdef USE_BOOSTER
     << "  --tbe                Transfer bootstrap expectation" << endl
-#endif
 //            << "  -t <threshold>       Minimum bootstrap support [0...1) for consensus tree" << endl
     << endl << "SINGLE BRANCH TEST:" << endl
     << "  --alrt NUM           Replicates for SH approximate likelihood ratio test" << endl
@@ -931,6 +931,9 @@ public:
     /** true if sequential phylip format is used, default: false (interleaved format) */
     bool phylip_sequential_format;
 
+    /** true to store compressed alignments in a binary cache FILE.iqa and reuse it (--aln-cache) */
+    bool aln_cache;
+
     /**
      SYMTEST_NONE to not perform test of symmetry of Jermiin et al. (default)
      SYMTEST_MAXDIV to perform symmetry test on the pair with maximum divergence
@@ -1638,7 +1641,7 @@ public:
     bool optimize_rate_matrix;
 
     /**
-            TRUE to store transition matrix into a hash table for computation efficiency
+            TRUE to cache transition matrices for computation efficiency (default), FALSE by --no-trans-cache
      */
     bool store_trans_matrix;
 
@@ -1759,6 +1762,9 @@ public:
     /** optimization algorithm for mixture (heterotachy) branch length models */
     string optimize_alg_mixlen;
 
+    /** TRUE to compute gradients of model parameters analytically if supported (default), FALSE for finite differences */
+    bool analytic_gradient;
+
     /**
      *  Optimization algorithm for +I+G
      */
@@ -1973,6 +1979,18 @@ public:
     /** TRUE to force using non-reversible likelihood kernel */
     bool kernel_nonrev;
 
+    /**
+        TRUE to store partial likelihoods in single precision (AVX and higher),
+        while site log-likelihoods and derivatives are still accumulated in double
+    */
+    bool lh_mixed_precision;
+
+    /**
+        number of SIMD pattern vectors over which the partial likelihoods of one class of a large
+        mixture model are computed before moving to the next class, 0 to loop over classes per pattern
+    */
+    int lh_mix_block;
+
     /**
      	 	WSL_NONE: do not print anything
             WSL_SITE: print site log-likelihood
@@ -2439,6 +2457,10 @@ public:
     /** TRUE to print checkpoints to 1.ckp.gz, 2.ckp.gz,... */
     bool print_all_checkpoints;
 
+    /** TRUE (default) to write binary checkpoint files appended with the changes of each dump,
+        FALSE to rewrite text checkpoint files */
+    bool binary_checkpoint;
+
     /** control output files to be written
      * OUT_LOG
      * OUT_TREEFILE
@@ -2818,30 +2840,33 @@ struct PDRelatedMeasures {
 
 /*--------------------------------------------------------------*/
     
-inline size_t get_safe_upper_limit(size_t cur_limit) {
+inline size_t get_safe_upper_limit_float(size_t cur_limit) {
     if (Params::getInstance().SSE >= LK_AVX512)
         // AVX-512
-        return ((cur_limit+7)/8)*8;
+        return ((cur_limit+15)/16)*16;
     else
         if (Params::getInstance().SSE >= LK_AVX)
             // AVX
-            return ((cur_limit+3)/4)*4;
+            return ((cur_limit+7)/8)*8;
         else
             // SSE
-            return ((cur_limit+1)/2)*2;
+            return ((cur_limit+3)/4)*4;
 }
 
-inline size_t get_safe_upper_limit_float(size_t cur_limit) {
+inline size_t get_safe_upper_limit(size_t cur_limit) {
+    if (Params::getInstance().lh_mixed_precision)
+        // single-precision kernels process twice as many patterns per vector
+        return get_safe_upper_limit_float(cur_limit);
     if (Params::getInstance().SSE >= LK_AVX512)
         // AVX-512
-        return ((cur_limit+15)/16)*16;
+        return ((cur_limit+7)/8)*8;
     else
         if (Params::getInstance().SSE >= LK_AVX)
             // AVX
-            return ((cur_limit+7)/8)*8;
+            return ((cur_limit+3)/4)*4;
         else
             // SSE
-            return ((cur_limit+3)/4)*4;
+            return ((cur_limit+1)/2)*2;
 }
 /*--------------------------------------------------------------*/
 